@@ -0,0 +1,55 @@
+#ifndef CLIA_BASE_STRING_VIEW_H_
+#define CLIA_BASE_STRING_VIEW_H_
+
+#include <cstddef>
+#include <cstring>
+#include <string>
+
+#include "clia/base/copyable.h"
+
+namespace clia {
+    /// 只读的字节视图，不持有内存，生命周期由底层缓冲区保证
+    class StringView final : Copyable {
+    public:
+        StringView() noexcept : data_(nullptr), size_(0) {}
+        StringView(const char *data, const std::size_t size) noexcept : data_(data), size_(size) {}
+        StringView(const char *str) noexcept : data_(str), size_(str ? std::strlen(str) : 0) {}
+        StringView(const std::string &str) noexcept : data_(str.data()), size_(str.size()) {}
+    public:
+        const char* data() const noexcept { return data_; }
+        std::size_t size() const noexcept { return size_; }
+        bool empty() const noexcept { return 0 == size_; }
+        const char* begin() const noexcept { return data_; }
+        const char* end() const noexcept { return data_ + size_; }
+        char operator[](const std::size_t i) const noexcept { return data_[i]; }
+        std::string to_string() const { return std::string(data_, size_); }
+    public:
+        bool operator==(const StringView &oth) const noexcept {
+            return size_ == oth.size_ && (0 == size_ || 0 == std::memcmp(data_, oth.data_, size_));
+        }
+        bool operator!=(const StringView &oth) const noexcept {
+            return !(*this == oth);
+        }
+        /// ASCII 大小写不敏感比较，用于协议字段名
+        bool iequals(const StringView &oth) const noexcept {
+            if (size_ != oth.size_) {
+                return false;
+            }
+            for (std::size_t i = 0; i < size_; ++i) {
+                char a = data_[i];
+                char b = oth.data_[i];
+                if (a >= 'A' && a <= 'Z') a = static_cast<char>(a - 'A' + 'a');
+                if (b >= 'A' && b <= 'Z') b = static_cast<char>(b - 'A' + 'a');
+                if (a != b) {
+                    return false;
+                }
+            }
+            return true;
+        }
+    private:
+        const char *data_;
+        std::size_t size_;
+    };
+}
+
+#endif
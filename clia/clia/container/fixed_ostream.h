@@ -24,6 +24,10 @@ namespace clia {
         public:
             inline const char* data() const noexcept;
             inline std::size_t size() const noexcept;
+            // 直接写入：调用方先检查 avail()，写入 n 字节后调用 add(n)，add 之后至少要留一个字节
+            inline char* current() noexcept;
+            inline std::size_t avail() const noexcept;
+            inline void add(const std::size_t n) noexcept;
         public:
             inline void format(const char *fmt, ...) noexcept;
             inline void format(const char *fmt, va_list al) noexcept;
@@ -43,6 +47,7 @@ namespace clia {
             inline Self& operator<<(const unsigned long long val) noexcept;
             inline Self& operator<<(const long long val) noexcept;
             inline Self& operator<<(const std::string &str) noexcept;
+            inline Self& operator<<(const clia::util::str_func::Hex val) noexcept;
         private:
             clia::container::FixedBuffer<char, Nm> buffer_;
         };
@@ -66,6 +71,21 @@ inline std::size_t clia::container::FixedOStream<Nm>::size() const noexcept {
     return buffer_.size();
 }
 
+template <int Nm>
+inline char* clia::container::FixedOStream<Nm>::current() noexcept {
+    return buffer_.current();
+}
+
+template <int Nm>
+inline std::size_t clia::container::FixedOStream<Nm>::avail() const noexcept {
+    return static_cast<std::size_t>(buffer_.avail());
+}
+
+template <int Nm>
+inline void clia::container::FixedOStream<Nm>::add(const std::size_t n) noexcept {
+    buffer_.add(n);
+}
+
 template <int Nm>
 inline void clia::container::FixedOStream<Nm>::format(const char *fmt, ...) noexcept {
     std::va_list args;
@@ -82,7 +102,7 @@ inline void clia::container::FixedOStream<Nm>::format(const char *fmt, std::va_l
 
 template <int Nm>
 inline clia::container::FixedOStream<Nm>& clia::container::FixedOStream<Nm>::operator<<(const void *ptr) noexcept {
-    const auto n = std::snprintf(buffer_.current(), buffer_.avail(), "0x%p", ptr);
+    const auto n = clia::util::str_func::convert_pointer(buffer_.current(), buffer_.avail(), ptr);
     buffer_.add(n);
     return *this;
 }
@@ -107,14 +127,14 @@ inline clia::container::FixedOStream<Nm>& clia::container::FixedOStream<Nm>::ope
 
 template <int Nm>
 inline clia::container::FixedOStream<Nm>& clia::container::FixedOStream<Nm>::operator<<(const float val) noexcept {
-    const auto n = std::snprintf(buffer_.current(), buffer_.avail(), "%.2f", val);
+    const auto n = clia::util::str_func::convert(buffer_.current(), buffer_.avail(), val);
     buffer_.add(n);
     return *this;
 }
 
 template <int Nm>
 inline clia::container::FixedOStream<Nm>& clia::container::FixedOStream<Nm>::operator<<(const double val) noexcept {
-    const auto n = std::snprintf(buffer_.current(), buffer_.avail(), "%.2lf", val);
+    const auto n = clia::util::str_func::convert(buffer_.current(), buffer_.avail(), val);
     buffer_.add(n);
     return *this;
 }
@@ -188,4 +208,11 @@ inline clia::container::FixedOStream<Nm>& clia::container::FixedOStream<Nm>::ope
     return *this;
 }
 
+template <int Nm>
+inline clia::container::FixedOStream<Nm>& clia::container::FixedOStream<Nm>::operator<<(const clia::util::str_func::Hex val) noexcept {
+    const auto n = clia::util::str_func::convert_hex(buffer_.current(), buffer_.avail(), val.value);
+    buffer_.add(n);
+    return *this;
+}
+
 #endif
\ No newline at end of file
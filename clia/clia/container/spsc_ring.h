@@ -0,0 +1,181 @@
+#ifndef CLIA_CONTAINER_SPSC_RING_H_
+#define CLIA_CONTAINER_SPSC_RING_H_
+
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+
+#include "clia/base/noncopyable.h"
+
+namespace clia {
+    namespace container {
+        /**
+         * 单生产者单消费者的变长记录环形缓冲区，无锁。
+         * 每条记录前有 8 字节长度头并按 8 字节对齐，记录在缓冲区中总是连续的：
+         * 尾部剩余空间不够时写入一条填充记录后从头开始。
+         * reserve/commit 只能由生产者线程调用，front/pop 只能由消费者线程调用
+         */
+        class SpscRing final : Noncopyable {
+        public:
+            // capacity 向上取整为 2 的幂
+            inline explicit SpscRing(const std::size_t capacity);
+            inline ~SpscRing() noexcept;
+        public:
+            // 预留 len 字节的连续空间，空间不足时返回 nullptr；commit 之前记录对消费者不可见
+            inline void* reserve(const std::size_t len) noexcept;
+            inline void commit() noexcept;
+            // 最早的一条记录，为空时返回 nullptr
+            inline const void* front(std::size_t *len) noexcept;
+            inline void pop() noexcept;
+
+            inline std::size_t capacity() const noexcept;
+            // 已占用的字节数(含记录头与填充)，任意线程读取时只是近似值
+            inline std::size_t used() const noexcept;
+            // 生产者视角的占用字节数，只在超过一半时才重新读取 head_，只能由生产者调用
+            inline std::size_t producer_used() noexcept;
+            inline bool empty() const noexcept;
+            // 单条记录允许的最大长度
+            inline std::size_t max_record_size() const noexcept;
+        private:
+            static constexpr std::size_t kCacheLine = 64;
+            static constexpr std::size_t kHeaderSize = 8;
+            static constexpr std::uint32_t kPadding = 0xffffffffu;
+
+            static inline std::size_t round_up_pow2(std::size_t n) noexcept;
+            static inline std::size_t align8(const std::size_t n) noexcept;
+            inline unsigned char* at(const std::uint64_t pos) const noexcept;
+        private:
+            const std::size_t capacity_;
+            const std::size_t mask_;
+            std::unique_ptr<unsigned char[]> data_;
+            // 消费者写、生产者读
+            char pad0_[kCacheLine];
+            std::atomic<std::uint64_t> head_;
+            std::uint64_t cached_tail_;     // 消费者看到的 tail_
+            std::uint64_t read_end_;        // front 返回的记录结束位置
+            // 生产者写、消费者读
+            char pad1_[kCacheLine];
+            std::atomic<std::uint64_t> tail_;
+            std::uint64_t cached_head_;     // 生产者看到的 head_
+            std::uint64_t write_end_;       // reserve 的记录结束位置
+            char pad2_[kCacheLine];
+        };
+    }
+}
+
+inline clia::container::SpscRing::SpscRing(const std::size_t capacity)
+    : capacity_(round_up_pow2(capacity < 4096 ? 4096 : capacity))
+    , mask_(capacity_ - 1)
+    , data_(new unsigned char[capacity_])
+    , head_(0)
+    , cached_tail_(0)
+    , read_end_(0)
+    , tail_(0)
+    , cached_head_(0)
+    , write_end_(0)
+{
+
+}
+
+inline clia::container::SpscRing::~SpscRing() noexcept = default;
+
+inline void* clia::container::SpscRing::reserve(const std::size_t len) noexcept {
+    const std::size_t need = kHeaderSize + align8(len);
+    if (len > this->max_record_size()) {
+        return nullptr;
+    }
+    const std::uint64_t tail = tail_.load(std::memory_order_relaxed);
+    const std::size_t to_end = capacity_ - (tail & mask_);
+    // 尾部放不下时连同填充一起计算
+    const std::size_t total = to_end < need ? to_end + need : need;
+    if (tail + total - cached_head_ > capacity_) {
+        cached_head_ = head_.load(std::memory_order_acquire);
+        if (tail + total - cached_head_ > capacity_) {
+            return nullptr;
+        }
+    }
+    std::uint64_t pos = tail;
+    if (to_end < need) {
+        const std::uint32_t padding = kPadding;
+        std::memcpy(this->at(pos), &padding, sizeof(padding));
+        pos += to_end;
+    }
+    const std::uint32_t len32 = static_cast<std::uint32_t>(len);
+    std::memcpy(this->at(pos), &len32, sizeof(len32));
+    write_end_ = pos + need;
+    return this->at(pos) + kHeaderSize;
+}
+
+inline void clia::container::SpscRing::commit() noexcept {
+    tail_.store(write_end_, std::memory_order_release);
+}
+
+inline const void* clia::container::SpscRing::front(std::size_t *len) noexcept {
+    std::uint64_t head = head_.load(std::memory_order_relaxed);
+    if (head == cached_tail_) {
+        cached_tail_ = tail_.load(std::memory_order_acquire);
+        if (head == cached_tail_) {
+            return nullptr;
+        }
+    }
+    std::uint32_t len32 = 0;
+    std::memcpy(&len32, this->at(head), sizeof(len32));
+    if (kPadding == len32) {
+        head += capacity_ - (head & mask_);
+        head_.store(head, std::memory_order_release);
+        std::memcpy(&len32, this->at(head), sizeof(len32));
+    }
+    *len = len32;
+    read_end_ = head + kHeaderSize + align8(len32);
+    return this->at(head) + kHeaderSize;
+}
+
+inline void clia::container::SpscRing::pop() noexcept {
+    assert(read_end_ > head_.load(std::memory_order_relaxed));
+    head_.store(read_end_, std::memory_order_release);
+}
+
+inline std::size_t clia::container::SpscRing::capacity() const noexcept {
+    return capacity_;
+}
+
+inline std::size_t clia::container::SpscRing::used() const noexcept {
+    return static_cast<std::size_t>(tail_.load(std::memory_order_acquire) - head_.load(std::memory_order_acquire));
+}
+
+inline std::size_t clia::container::SpscRing::producer_used() noexcept {
+    if (write_end_ - cached_head_ > capacity_ / 2) {
+        cached_head_ = head_.load(std::memory_order_acquire);
+    }
+    return static_cast<std::size_t>(write_end_ - cached_head_);
+}
+
+inline bool clia::container::SpscRing::empty() const noexcept {
+    return head_.load(std::memory_order_acquire) == tail_.load(std::memory_order_acquire);
+}
+
+inline std::size_t clia::container::SpscRing::max_record_size() const noexcept {
+    // 保证最坏情况下(填充接近半个缓冲区)也能放下
+    return capacity_ / 2 - kHeaderSize;
+}
+
+inline std::size_t clia::container::SpscRing::round_up_pow2(std::size_t n) noexcept {
+    std::size_t r = 1;
+    while (r < n) {
+        r <<= 1;
+    }
+    return r;
+}
+
+inline std::size_t clia::container::SpscRing::align8(const std::size_t n) noexcept {
+    return (n + 7) & ~static_cast<std::size_t>(7);
+}
+
+inline unsigned char* clia::container::SpscRing::at(const std::uint64_t pos) const noexcept {
+    return data_.get() + (pos & mask_);
+}
+
+#endif
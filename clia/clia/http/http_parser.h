@@ -0,0 +1,69 @@
+#ifndef CLIA_HTTP_HTTP_PARSER_H_
+#define CLIA_HTTP_HTTP_PARSER_H_
+
+#include <cstddef>
+
+#include "clia/base/noncopyable.h"
+#include "clia/http/http_request.h"
+
+namespace clia {
+    namespace net {
+        class Buffer;
+    }
+    namespace http {
+        /**
+         * 增量式请求解析器，直接在连接的输入 Buffer 上工作。
+         * 数据不完整时记录已扫描的位置，下次只扫描新到达的字节；
+         * chunked 请求体在 Buffer 内原地拼接成连续区域，因此请求体同样以视图形式给出。
+         */
+        class HttpParser final : Noncopyable {
+        public:
+            enum class Result {
+                kIncomplete,    // 需要更多数据
+                kComplete,      // 得到一个完整请求，见 request()/consumed()
+                kError,         // 请求非法，见 error_status()
+            };
+            static constexpr std::size_t kMaxHeaderBytes = 8 * 1024;
+            static constexpr std::size_t kMaxBodyBytes = 8 * 1024 * 1024;
+        public:
+            HttpParser() noexcept;
+            ~HttpParser() noexcept;
+        public:
+            Result parse(clia::net::Buffer *buf) noexcept;
+            const HttpRequest& request() const noexcept;
+            // 当前请求在 Buffer 中占用的字节数，处理完后由调用方 retrieve
+            std::size_t consumed() const noexcept;
+            int error_status() const noexcept;
+            // 准备解析下一个请求(流水线)
+            void reset() noexcept;
+        private:
+            enum class State {
+                kHead,
+                kBody,
+                kChunkSize,
+                kChunkData,
+                kChunkDataEnd,
+                kTrailer,
+                kComplete,
+                kError,
+            };
+            bool parse_head(const char *base, const std::size_t head_len) noexcept;
+            bool parse_request_line(const char *base, const char *begin, const char *end) noexcept;
+            bool parse_header_line(const char *base, const char *begin, const char *end) noexcept;
+            Result parse_chunked(clia::net::Buffer *buf) noexcept;
+            Result fail(const int status) noexcept;
+        private:
+            State state_;
+            std::size_t scan_;          // 下一次扫描的起始偏移
+            std::size_t body_begin_;
+            std::size_t body_end_;      // chunked 时为已拼接的请求体末尾
+            std::size_t content_length_;
+            std::size_t chunk_remain_;
+            std::size_t consumed_;
+            int error_status_;
+            HttpRequest request_;
+        };
+    }
+}
+
+#endif
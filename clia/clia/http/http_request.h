@@ -0,0 +1,82 @@
+#ifndef CLIA_HTTP_HTTP_REQUEST_H_
+#define CLIA_HTTP_HTTP_REQUEST_H_
+
+#include <cstddef>
+#include <cstdint>
+
+#include "clia/base/noncopyable.h"
+#include "clia/base/string_view.h"
+
+namespace clia {
+    namespace http {
+        enum class Method {
+            kInvalid,
+            kGet,
+            kHead,
+            kPost,
+            kPut,
+            kDelete,
+            kOptions,
+            kPatch,
+        };
+        extern const char* method_to_string(const Method method) noexcept;
+
+        enum class Version {
+            kUnknown,
+            kHttp10,
+            kHttp11,
+        };
+
+        /**
+         * 请求的各个字段只记录相对于请求起始位置的偏移，不做任何拷贝。
+         * 解析器在请求完整后把起始地址绑定进来，此时才能通过访问器拿到视图，
+         * 视图在回调返回前有效(回调返回后底层 Buffer 会被 retrieve)。
+         */
+        class HttpRequest final : Noncopyable {
+            friend class HttpParser;
+        public:
+            static constexpr int kMaxHeaders = 64;
+        public:
+            HttpRequest() noexcept;
+            ~HttpRequest() noexcept;
+        public:
+            Method method() const noexcept;
+            Version version() const noexcept;
+            clia::StringView method_str() const noexcept;
+            clia::StringView target() const noexcept;   // path + query
+            clia::StringView path() const noexcept;
+            clia::StringView query() const noexcept;
+            clia::StringView body() const noexcept;
+            int header_count() const noexcept;
+            clia::StringView header_name(const int i) const noexcept;
+            clia::StringView header_value(const int i) const noexcept;
+            // 大小写不敏感查找，不存在时返回空视图
+            clia::StringView header(const clia::StringView &name) const noexcept;
+            bool keep_alive() const noexcept;
+            bool chunked() const noexcept;
+        private:
+            struct Slice {
+                std::uint32_t off;
+                std::uint32_t len;
+            };
+            clia::StringView view(const Slice &slice) const noexcept;
+            void reset() noexcept;
+        private:
+            const char *base_;
+            Method method_;
+            Version version_;
+            bool keep_alive_;
+            bool chunked_;
+            Slice method_str_;
+            Slice target_;
+            Slice path_;
+            Slice query_;
+            Slice body_;
+            int header_count_;
+            Slice header_names_[kMaxHeaders];
+            Slice header_values_[kMaxHeaders];
+        };
+    }
+}
+
+#endif
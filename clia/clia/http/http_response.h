@@ -0,0 +1,59 @@
+#ifndef CLIA_HTTP_HTTP_RESPONSE_H_
+#define CLIA_HTTP_HTTP_RESPONSE_H_
+
+#include <cstddef>
+#include <ctime>
+
+#include "clia/base/noncopyable.h"
+#include "clia/base/string_view.h"
+#include "clia/http/http_request.h"
+
+namespace clia {
+    namespace net {
+        class Buffer;
+    }
+    namespace http {
+        /**
+         * 响应直接序列化进输出 Buffer，不在中间结构里暂存头部。
+         * 调用顺序: set_status -> add_header* -> set_body 或 begin_chunked/write_chunk/end_chunked。
+         * 处理函数没有写出响应体时，由 HttpServer 调用 finish() 补全空响应。
+         */
+        class HttpResponse final : Noncopyable {
+        public:
+            HttpResponse(clia::net::Buffer *output, const Version version, const bool close_connection, const bool head_only = false) noexcept;
+            ~HttpResponse() noexcept;
+        public:
+            void set_status(const int code, const clia::StringView &reason = clia::StringView()) noexcept;
+            void set_close_connection(const bool on) noexcept;
+            bool close_connection() const noexcept;
+            void add_header(const clia::StringView &name, const clia::StringView &value);
+            void set_content_type(const clia::StringView &type);
+            void set_body(const void *data, const std::size_t len);
+            void set_body(const clia::StringView &body);
+            void begin_chunked();
+            void write_chunk(const void *data, const std::size_t len);
+            void end_chunked();
+            void finish();
+            bool finished() const noexcept;
+        public:
+            // 刷新当前线程缓存的 Date 头，同一秒内重复调用直接返回
+            static void refresh_date(const std::time_t now) noexcept;
+            static const char* reason_phrase(const int code) noexcept;
+        private:
+            void write_head();
+            void append(const clia::StringView &str);
+        private:
+            clia::net::Buffer *const output_;
+            const Version version_;
+            const bool head_only_;
+            bool close_connection_;
+            bool head_written_;
+            bool chunked_;
+            bool finished_;
+            int status_;
+            clia::StringView reason_;
+        };
+    }
+}
+
+#endif
@@ -0,0 +1,34 @@
+#ifndef CLIA_HTTP_HTTP_SERVER_H_
+#define CLIA_HTTP_HTTP_SERVER_H_
+
+#include <functional>
+
+#include "clia/base/noncopyable.h"
+#include "clia/net/base.h"
+#include "clia/net/tcp_server.h"
+#include "clia/http/http_request.h"
+#include "clia/http/http_response.h"
+
+namespace clia {
+    namespace http {
+        class HttpServer final : Noncopyable {
+        public:
+            using HttpCallback = std::function<void(const HttpRequest&, HttpResponse*)>;
+        public:
+            HttpServer(clia::reactor::EventLoop *loop, const clia::net::InetAddress &listen_addr, const bool reuse_port = false);
+            ~HttpServer();
+        public:
+            void set_http_callback(const HttpCallback &cb);
+            void set_thread_num(const int num = std::thread::hardware_concurrency());
+            void start();
+        private:
+            void on_connection(const clia::net::TcpConnectionPtr &conn);
+            void on_message(const clia::net::TcpConnectionPtr &conn, clia::net::Buffer *buf, clia::util::Timestamp receive_time);
+        private:
+            clia::net::TcpServer server_;
+            HttpCallback http_callback_;
+        };
+    }
+}
+
+#endif
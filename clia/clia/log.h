@@ -1,19 +1,43 @@
 #ifndef CLIA_LOG_H_
 #define CLIA_LOG_H_
 
+#include <atomic>
 #include <memory>
 #include <mutex>
 #include <string>
 #include <unordered_map>
+#include <vector>
 
 #include "clia/log/trait.h"
 #include "clia/log/event.h"
+#include "clia/log/binary.h"
+#include "clia/log/sampling.h"
+
+// 编译期日志级别，低于 CLIA_LOG_ACTIVE_LEVEL 的日志语句条件恒为假，会被编译器整体消除。
+// 编译时通过 -DCLIA_LOG_ACTIVE_LEVEL=1 之类的方式指定，默认保留全部级别
+#define CLIA_LOG_LEVEL_TRACE  0
+#define CLIA_LOG_LEVEL_DEBUG  1
+#define CLIA_LOG_LEVEL_INFO   2
+#define CLIA_LOG_LEVEL_WARN   3
+#define CLIA_LOG_LEVEL_ERROR  4
+#define CLIA_LOG_LEVEL_FATAL  5
+#define CLIA_LOG_LEVEL_OFF    6
+
+#ifndef CLIA_LOG_ACTIVE_LEVEL
+#define CLIA_LOG_ACTIVE_LEVEL CLIA_LOG_LEVEL_TRACE
+#endif
+
+#define CLIA_LOG_COMPILED(LEVEL) (static_cast<int>(LEVEL) >= CLIA_LOG_ACTIVE_LEVEL)
+// 默认日志记录器的级别检查只是两次原子读(指针与级别)，不复制 shared_ptr
+#define CLIA_LOG_ENABLED(LEVEL) (CLIA_LOG_COMPILED(LEVEL) && clia::log::LoggerManger::enabled(LEVEL))
 
 #define CLIA_LOG(LOGGER, LEVEL) \
-    if (LOGGER && LOGGER->level() <= LEVEL) \
+    if (CLIA_LOG_COMPILED(LEVEL) && LOGGER && LOGGER->level() <= LEVEL) \
         clia::log::Event(LOGGER, LEVEL, __FILE__, __LINE__, __FUNCTION__).stream()
 
-#define CLIA_LOG_LEVEL(LEVEL) CLIA_LOG(clia::log::LoggerManger::instance()->default_logger(), LEVEL)
+#define CLIA_LOG_LEVEL(LEVEL) \
+    if (CLIA_LOG_ENABLED(LEVEL)) \
+        clia::log::Event(clia::log::LoggerManger::default_ptr(), LEVEL, __FILE__, __LINE__, __FUNCTION__).stream()
 
 #define CLIA_LOG_TRACE  CLIA_LOG_LEVEL(clia::log::Level::kTrace)
 #define CLIA_LOG_DEBUG  CLIA_LOG_LEVEL(clia::log::Level::kDebug)
@@ -23,10 +47,12 @@
 #define CLIA_LOG_FATAL  CLIA_LOG_LEVEL(clia::log::Level::kFatal)
 
 #define CLIA_LARGE_LOG(LOGGER, LEVEL) \
-    if (LOGGER && LOGGER->level() <= LEVEL) \
+    if (CLIA_LOG_COMPILED(LEVEL) && LOGGER && LOGGER->level() <= LEVEL) \
         clia::log::LargeEvent(LOGGER, LEVEL, __FILE__, __LINE__, __FUNCTION__).stream()
 
-#define CLIA_LARGE_LOG_LEVEL(LEVEL) CLIA_LARGE_LOG(clia::log::LoggerManger::instance()->default_logger(), LEVEL)
+#define CLIA_LARGE_LOG_LEVEL(LEVEL) \
+    if (CLIA_LOG_ENABLED(LEVEL)) \
+        clia::log::LargeEvent(clia::log::LoggerManger::default_ptr(), LEVEL, __FILE__, __LINE__, __FUNCTION__).stream()
 
 #define CLIA_LARGE_LOG_TRACE  CLIA_LARGE_LOG_LEVEL(clia::log::Level::kTrace)
 #define CLIA_LARGE_LOG_DEBUG  CLIA_LARGE_LOG_LEVEL(clia::log::Level::kDebug)
@@ -36,12 +62,16 @@
 #define CLIA_LARGE_LOG_FATAL  CLIA_LARGE_LOG_LEVEL(clia::log::Level::kFatal)
 
 #define CLIA_FMT_LOG(LOGGER, LEVEL, ...) do { \
-    if (LOGGER && LOGGER->level() <= LEVEL) { \
+    if (CLIA_LOG_COMPILED(LEVEL) && LOGGER && LOGGER->level() <= LEVEL) { \
         clia::log::Event(LOGGER, LEVEL, __FILE__, __LINE__, __FUNCTION__).format(__VA_ARGS__); \
     } \
 } while (0);
 
-#define CLIA_FMT_LOG_LEVEL(LEVEL, ...) CLIA_FMT_LOG(clia::log::LoggerManger::instance()->default_logger(), LEVEL, __VA_ARGS__)
+#define CLIA_FMT_LOG_LEVEL(LEVEL, ...) do { \
+    if (CLIA_LOG_ENABLED(LEVEL)) { \
+        clia::log::Event(clia::log::LoggerManger::default_ptr(), LEVEL, __FILE__, __LINE__, __FUNCTION__).format(__VA_ARGS__); \
+    } \
+} while (0);
 
 #define CLIA_FMT_LOG_TRACE(...)  CLIA_FMT_LOG_LEVEL(clia::log::Level::kTrace, __VA_ARGS__)
 #define CLIA_FMT_LOG_DEBUG(...)  CLIA_FMT_LOG_LEVEL(clia::log::Level::kDebug, __VA_ARGS__)
@@ -51,12 +81,16 @@
 #define CLIA_FMT_LOG_FATAL(...)  CLIA_FMT_LOG_LEVEL(clia::log::Level::kFatal, __VA_ARGS__)
 
 #define CLIA_LARGE_FMT_LOG(LOGGER, LEVEL, ...) do { \
-    if (LOGGER && LOGGER->level() <= LEVEL) { \
+    if (CLIA_LOG_COMPILED(LEVEL) && LOGGER && LOGGER->level() <= LEVEL) { \
         clia::log::LargeEvent(LOGGER, LEVEL, __FILE__, __LINE__, __FUNCTION__).format(__VA_ARGS__); \
     } \
 } while (0);
 
-#define CLIA_LARGE_FMT_LOG_LEVEL(LEVEL, ...) CLIA_LARGE_FMT_LOG(clia::log::LoggerManger::instance()->default_logger(), LEVEL, __VA_ARGS__)
+#define CLIA_LARGE_FMT_LOG_LEVEL(LEVEL, ...) do { \
+    if (CLIA_LOG_ENABLED(LEVEL)) { \
+        clia::log::LargeEvent(clia::log::LoggerManger::default_ptr(), LEVEL, __FILE__, __LINE__, __FUNCTION__).format(__VA_ARGS__); \
+    } \
+} while (0);
 
 #define CLIA_LARGE_FMT_LOG_TRACE(...)  CLIA_LARGE_FMT_LOG_LEVEL(clia::log::Level::kTrace, __VA_ARGS__)
 #define CLIA_LARGE_FMT_LOG_DEBUG(...)  CLIA_LARGE_FMT_LOG_LEVEL(clia::log::Level::kDebug, __VA_ARGS__)
@@ -65,22 +99,179 @@
 #define CLIA_LARGE_FMT_LOG_ERROR(...)  CLIA_LARGE_FMT_LOG_LEVEL(clia::log::Level::kError, __VA_ARGS__)
 #define CLIA_LARGE_FMT_LOG_FATAL(...)  CLIA_LARGE_FMT_LOG_LEVEL(clia::log::Level::kFatal, __VA_ARGS__)
 
+// 延迟格式化的二进制日志，见 clia/log/binary.h
+#define CLIA_BIN_LOG(LOGGER, LEVEL, FMT, ...) do { \
+    if (CLIA_LOG_COMPILED(LEVEL) && LOGGER && LOGGER->level() <= LEVEL) { \
+        static const clia::log::binary::Site clia_bin_log_site_(LEVEL, FMT, __FILE__, __LINE__, __FUNCTION__); \
+        clia::log::binary::log(LOGGER, &clia_bin_log_site_, ##__VA_ARGS__); \
+    } \
+} while (0)
+
+#define CLIA_BIN_LOG_LEVEL(LEVEL, FMT, ...) do { \
+    if (CLIA_LOG_ENABLED(LEVEL)) { \
+        static const clia::log::binary::Site clia_bin_log_site_(LEVEL, FMT, __FILE__, __LINE__, __FUNCTION__); \
+        clia::log::binary::log(clia::log::LoggerManger::default_ptr(), &clia_bin_log_site_, ##__VA_ARGS__); \
+    } \
+} while (0)
+
+#define CLIA_BIN_LOG_TRACE(FMT, ...)  CLIA_BIN_LOG_LEVEL(clia::log::Level::kTrace, FMT, ##__VA_ARGS__)
+#define CLIA_BIN_LOG_DEBUG(FMT, ...)  CLIA_BIN_LOG_LEVEL(clia::log::Level::kDebug, FMT, ##__VA_ARGS__)
+#define CLIA_BIN_LOG_INFO(FMT, ...)   CLIA_BIN_LOG_LEVEL(clia::log::Level::kInfo, FMT, ##__VA_ARGS__)
+#define CLIA_BIN_LOG_WARN(FMT, ...)   CLIA_BIN_LOG_LEVEL(clia::log::Level::kWarn, FMT, ##__VA_ARGS__)
+#define CLIA_BIN_LOG_ERROR(FMT, ...)  CLIA_BIN_LOG_LEVEL(clia::log::Level::kError, FMT, ##__VA_ARGS__)
+#define CLIA_BIN_LOG_FATAL(FMT, ...)  CLIA_BIN_LOG_LEVEL(clia::log::Level::kFatal, FMT, ##__VA_ARGS__)
+
+// 按调用点采样与限流，状态见 clia/log/sampling.h，只对默认日志记录器；级别检查在采样之前，
+// 被级别过滤掉的调用不计数。输出的行以 "[suppressed N] " 开头给出上一条之后被跳过的行数
+#define CLIA_LOG_SAMPLING_DECISION(STATE, ...) \
+    ([&]() noexcept -> clia::log::sampling::Decision { \
+        static clia::log::sampling::STATE clia_log_sampling_state_; \
+        return clia_log_sampling_state_.check(__VA_ARGS__); \
+    }())
+
+#define CLIA_LOG_SAMPLED(LEVEL, DECISION) \
+    if (const clia::log::sampling::Decision clia_log_decision_ = CLIA_LOG_ENABLED(LEVEL) ? DECISION : clia::log::sampling::Decision{false, 0}) \
+        clia::log::Event(clia::log::LoggerManger::default_ptr(), LEVEL, __FILE__, __LINE__, __FUNCTION__).stream() << clia_log_decision_
+
+// 第 1、N+1、2N+1... 次输出
+#define CLIA_LOG_EVERY_N(LEVEL, N)              CLIA_LOG_SAMPLED(LEVEL, CLIA_LOG_SAMPLING_DECISION(EveryN, N))
+// 只输出前 N 次
+#define CLIA_LOG_FIRST_N(LEVEL, N)              CLIA_LOG_SAMPLED(LEVEL, CLIA_LOG_SAMPLING_DECISION(FirstN, N))
+// 每 SECONDS 秒最多一次，可以是小数
+#define CLIA_LOG_EVERY_T(LEVEL, SECONDS)        CLIA_LOG_SAMPLED(LEVEL, CLIA_LOG_SAMPLING_DECISION(EveryT, SECONDS))
+// 令牌桶，平均每秒 RATE 条，最多连续 BURST 条
+#define CLIA_LOG_RATE_LIMIT(LEVEL, RATE, BURST) CLIA_LOG_SAMPLED(LEVEL, CLIA_LOG_SAMPLING_DECISION(TokenBucket, RATE, BURST))
+
+#define CLIA_FMT_LOG_SAMPLED(LEVEL, DECISION, ...) do { \
+    if (CLIA_LOG_ENABLED(LEVEL)) { \
+        const clia::log::sampling::Decision clia_log_decision_ = DECISION; \
+        if (clia_log_decision_) { \
+            clia::log::Event clia_log_event_(clia::log::LoggerManger::default_ptr(), LEVEL, __FILE__, __LINE__, __FUNCTION__); \
+            clia_log_event_.stream() << clia_log_decision_; \
+            clia_log_event_.format(__VA_ARGS__); \
+        } \
+    } \
+} while (0)
+
+#define CLIA_FMT_LOG_EVERY_N(LEVEL, N, ...)              CLIA_FMT_LOG_SAMPLED(LEVEL, CLIA_LOG_SAMPLING_DECISION(EveryN, N), __VA_ARGS__)
+#define CLIA_FMT_LOG_FIRST_N(LEVEL, N, ...)              CLIA_FMT_LOG_SAMPLED(LEVEL, CLIA_LOG_SAMPLING_DECISION(FirstN, N), __VA_ARGS__)
+#define CLIA_FMT_LOG_EVERY_T(LEVEL, SECONDS, ...)        CLIA_FMT_LOG_SAMPLED(LEVEL, CLIA_LOG_SAMPLING_DECISION(EveryT, SECONDS), __VA_ARGS__)
+#define CLIA_FMT_LOG_RATE_LIMIT(LEVEL, RATE, BURST, ...) CLIA_FMT_LOG_SAMPLED(LEVEL, CLIA_LOG_SAMPLING_DECISION(TokenBucket, RATE, BURST), __VA_ARGS__)
+
+// 结构化日志，见 clia/log/event.h 中的 StructuredEvent：CLIA_SLOG_INFO("conn_closed").kv("fd", fd).kv("bytes", n);
+#define CLIA_SLOG(LOGGER, LEVEL, EVENT) \
+    if (CLIA_LOG_COMPILED(LEVEL) && LOGGER && LOGGER->level() <= LEVEL) \
+        clia::log::StructuredEvent(LOGGER, LEVEL, EVENT, __FILE__, __LINE__, __FUNCTION__)
+
+#define CLIA_SLOG_LEVEL(LEVEL, EVENT) \
+    if (CLIA_LOG_ENABLED(LEVEL)) \
+        clia::log::StructuredEvent(clia::log::LoggerManger::default_ptr(), LEVEL, EVENT, __FILE__, __LINE__, __FUNCTION__)
+
+#define CLIA_SLOG_TRACE(EVENT)  CLIA_SLOG_LEVEL(clia::log::Level::kTrace, EVENT)
+#define CLIA_SLOG_DEBUG(EVENT)  CLIA_SLOG_LEVEL(clia::log::Level::kDebug, EVENT)
+#define CLIA_SLOG_INFO(EVENT)   CLIA_SLOG_LEVEL(clia::log::Level::kInfo, EVENT)
+#define CLIA_SLOG_WARN(EVENT)   CLIA_SLOG_LEVEL(clia::log::Level::kWarn, EVENT)
+#define CLIA_SLOG_ERROR(EVENT)  CLIA_SLOG_LEVEL(clia::log::Level::kError, EVENT)
+#define CLIA_SLOG_FATAL(EVENT)  CLIA_SLOG_LEVEL(clia::log::Level::kFatal, EVENT)
+
+// 按模块名记录日志：调用点第一次执行时解析出模块的句柄并缓存，之后只有一次原子读，
+// 模块没有注册日志记录器时使用默认日志记录器
+#define CLIA_LOG_MODULE_LOGGER(MODULE) \
+    ([]() noexcept -> clia::log::trait::Logger* { \
+        static const clia::log::Handle clia_log_handle_(MODULE); \
+        return clia_log_handle_.get(); \
+    }())
+
+#define CLIA_MODULE_LOG(MODULE, LEVEL) \
+    if (CLIA_LOG_COMPILED(LEVEL)) \
+        if (clia::log::trait::Logger *clia_log_logger_ = CLIA_LOG_MODULE_LOGGER(MODULE)) \
+            if (clia_log_logger_->level() <= LEVEL) \
+                clia::log::Event(clia_log_logger_, LEVEL, __FILE__, __LINE__, __FUNCTION__).stream()
+
+#define CLIA_MODULE_LOG_TRACE(MODULE)  CLIA_MODULE_LOG(MODULE, clia::log::Level::kTrace)
+#define CLIA_MODULE_LOG_DEBUG(MODULE)  CLIA_MODULE_LOG(MODULE, clia::log::Level::kDebug)
+#define CLIA_MODULE_LOG_INFO(MODULE)   CLIA_MODULE_LOG(MODULE, clia::log::Level::kInfo)
+#define CLIA_MODULE_LOG_WARN(MODULE)   CLIA_MODULE_LOG(MODULE, clia::log::Level::kWarn)
+#define CLIA_MODULE_LOG_ERROR(MODULE)  CLIA_MODULE_LOG(MODULE, clia::log::Level::kError)
+#define CLIA_MODULE_LOG_FATAL(MODULE)  CLIA_MODULE_LOG(MODULE, clia::log::Level::kFatal)
+
+#define CLIA_MODULE_FMT_LOG(MODULE, LEVEL, ...) do { \
+    if (CLIA_LOG_COMPILED(LEVEL)) { \
+        clia::log::trait::Logger *clia_log_logger_ = CLIA_LOG_MODULE_LOGGER(MODULE); \
+        if (clia_log_logger_ && clia_log_logger_->level() <= LEVEL) { \
+            clia::log::Event(clia_log_logger_, LEVEL, __FILE__, __LINE__, __FUNCTION__).format(__VA_ARGS__); \
+        } \
+    } \
+} while (0)
+
+#define CLIA_MODULE_FMT_LOG_TRACE(MODULE, ...)  CLIA_MODULE_FMT_LOG(MODULE, clia::log::Level::kTrace, __VA_ARGS__)
+#define CLIA_MODULE_FMT_LOG_DEBUG(MODULE, ...)  CLIA_MODULE_FMT_LOG(MODULE, clia::log::Level::kDebug, __VA_ARGS__)
+#define CLIA_MODULE_FMT_LOG_INFO(MODULE, ...)   CLIA_MODULE_FMT_LOG(MODULE, clia::log::Level::kInfo, __VA_ARGS__)
+#define CLIA_MODULE_FMT_LOG_WARN(MODULE, ...)   CLIA_MODULE_FMT_LOG(MODULE, clia::log::Level::kWarn, __VA_ARGS__)
+#define CLIA_MODULE_FMT_LOG_ERROR(MODULE, ...)  CLIA_MODULE_FMT_LOG(MODULE, clia::log::Level::kError, __VA_ARGS__)
+#define CLIA_MODULE_FMT_LOG_FATAL(MODULE, ...)  CLIA_MODULE_FMT_LOG(MODULE, clia::log::Level::kFatal, __VA_ARGS__)
+
 namespace clia {
     namespace log { 
+        /**
+         * 日志记录器注册表。读取(logger、default_ptr、Handle::get)不加锁：
+         * 名字到日志记录器的映射以写时复制的快照发布，注册时复制一份新快照再原子替换；
+         * 旧快照以及注册过的日志记录器都保留到进程退出，所以读者拿到的裸指针始终有效。
+         * 注册只应在启动或运维操作时发生，不在热路径上
+         */
         class LoggerManger final : Noncopyable {
+        public:
+            using Slot = std::atomic<trait::Logger*>;
         public:
             static LoggerManger* instance() noexcept;
+            // 未注册的名字返回默认日志记录器
             std::shared_ptr<trait::Logger> logger(const std::string &name) noexcept;
             std::shared_ptr<trait::Logger> default_logger() noexcept;
             void set_default(std::shared_ptr<trait::Logger> logger) noexcept;
+            // 同名的日志记录器会被替换，已缓存该名字的调用点随之切换
             void register_logger(const std::string &name, std::shared_ptr<trait::Logger> logger) noexcept;
+            /// 运行期调整日志级别
+            /// @param name 模块名，为空时调整默认日志记录器
+            /// @return 对应的日志记录器不存在时返回 false
+            /// @note 多个模块共用同一个日志记录器对象时级别也是共用的
+            bool set_level(const std::string &name, const Level level) noexcept;
+            // 名字对应的槽位，地址在进程内不变，内容为已注册的日志记录器或 nullptr
+            const Slot* slot(const std::string &name) noexcept;
+
+            static trait::Logger* default_ptr() noexcept {
+                return default_ptr_.load(std::memory_order_acquire);
+            }
+            // 默认日志记录器是否会记录该级别，没有默认日志记录器时总是 false
+            static bool enabled(const Level level) noexcept {
+                const trait::Logger *logger = default_ptr();
+                return logger != nullptr && logger->level() <= level;
+            }
         private:
+            using Registry = std::unordered_map<std::string, std::shared_ptr<trait::Logger>>;
+
             LoggerManger() noexcept;
             ~LoggerManger() noexcept;
         private:
-            std::mutex lck_;
+            static std::atomic<trait::Logger*> default_ptr_;                           // 默认日志记录器，设置后不再改变
+            std::mutex lck_;                                                            // 保护写操作
             std::shared_ptr<trait::Logger> default_logger_;                            // 默认日志记录器
-            std::unordered_map<std::string, std::shared_ptr<trait::Logger>> loggers_;  // 日志记录器映射
+            std::atomic<const Registry*> registry_;                                     // 当前快照
+            std::vector<std::unique_ptr<const Registry>> snapshots_;                    // 发布过的所有快照
+            std::unordered_map<std::string, std::unique_ptr<Slot>> slots_;              // 调用点缓存的槽位
+        };
+
+        // 调用点缓存的模块句柄，构造时解析一次槽位，之后的 get() 只是一次原子读
+        class Handle final : Noncopyable {
+        public:
+            explicit Handle(const std::string &module) noexcept
+                : slot_(LoggerManger::instance()->slot(module)) {}
+        public:
+            trait::Logger* get() const noexcept {
+                trait::Logger *logger = slot_ != nullptr ? slot_->load(std::memory_order_acquire) : nullptr;
+                return logger != nullptr ? logger : LoggerManger::default_ptr();
+            }
+        private:
+            const LoggerManger::Slot *const slot_;
         };
     }
 }
@@ -2,6 +2,7 @@
 #define CLIA_LOG_ASYNC_LOGGER_H_
 
 #include <cstddef>
+#include <cstdint>
 #include <memory>
 #include <mutex>
 #include <vector>
@@ -14,16 +15,65 @@
 
 namespace clia {
     namespace log {
+        /**
+         * 异步日志：前端只把日志行放入缓冲区，由后台线程写入 appender。
+         * 默认每个写日志的线程在第一次写日志时注册一个无锁的单生产者环形缓冲区，之后写日志不再加锁，
+         * 后台线程按时间戳顺序合并各线程的缓冲区。ring_bytes 为 0 时退回所有线程共用一个加锁缓冲区的方式。
+         * 缓冲区满时按 Overflow 策略处理，丢弃的行数与字节数按级别精确统计，
+         * 后台线程每个刷新周期把新增的丢弃数量作为一条 WARN 日志写入 appender
+         */
         class AsyncLogger final : public trait::Logger {
         public:
-            explicit AsyncLogger(const Level level, std::shared_ptr<trait::Appender> appender, const int flush_interval_sec = 1) noexcept;
+            static constexpr std::size_t kDefaultRingBytes = 1024 * 1024;
+            static constexpr int kLevelCount = static_cast<int>(Level::kFatal) + 1;
+
+            enum class Overflow {
+                kBlock,         // 阻塞写日志的线程直到有空间(默认)
+                kDropNewest,    // 丢弃正在写入的日志行
+                kDropOldest,    // 丢弃最早的未写出日志，为新日志腾出空间
+                kDropByLevel,   // 不低于 keep_level 的阻塞，其余丢弃
+            };
+
+            // 按级别累计的丢弃数量，字节数按提交给 logger 的长度计算
+            struct DropStats {
+                std::uint64_t lines[kLevelCount];
+                std::uint64_t bytes[kLevelCount];
+
+                std::uint64_t total_lines() const noexcept;
+                std::uint64_t total_bytes() const noexcept;
+            };
+        public:
+            explicit AsyncLogger(const Level level, std::shared_ptr<trait::Appender> appender, const int flush_interval_sec = 1,
+                const std::size_t ring_bytes = kDefaultRingBytes) noexcept;
             ~AsyncLogger() noexcept;
         public:
             void log(const Level level, const void *message, const std::size_t len) noexcept override; // 异步日志记录方法
+            // 环形缓冲区模式下只保存参数的原始字节，由后台线程格式化
+            void log_binary(const binary::Site *site, const void *record, const std::size_t len) noexcept override;
+
+            // 运行期可以随时切换，对之后的写入生效
+            void set_overflow(const Overflow policy, const Level keep_level = Level::kWarn) noexcept;
+            Overflow overflow() const noexcept;
+            DropStats drop_stats() const noexcept;
         private:
+            struct ThreadRing;
             inline void sync_thread();
+            inline void ring_thread();
+            // 当前线程在本 logger 上的环形缓冲区，第一次调用时注册
+            ThreadRing* local_ring();
+            // 写入当前线程的环形缓冲区，site 为空表示已格式化的文本
+            void push_record(const Level level, const binary::Site *site, const void *data, const std::size_t len) noexcept;
+            void wakeup() noexcept;
+            // 缓冲区满时该级别的日志是否等待，否则丢弃
+            bool wait_on_overflow(const Level level) const noexcept;
+            void count_drop(const Level level, const std::uint64_t lines, const std::uint64_t bytes) noexcept;
+            // 后台线程丢弃被标记的环形缓冲区中最早的记录，直到空出一半
+            void shed_oldest(const std::vector<std::shared_ptr<ThreadRing>> &rings) noexcept;
+            // 把 reported 之后新增的丢弃数量写入 appender
+            void report_drops(DropStats *reported) noexcept;
         private:
             static constexpr int kBufferSize = 4 * 1024 * 1024;
+            static constexpr std::size_t kMaxPendingBuffers = 25;
             using Buffer = clia::container::FixedBuffer<char, kBufferSize>;
             using BufferVector = std::vector<std::unique_ptr<Buffer>>;
             using BufferPtr = BufferVector::value_type;
@@ -32,10 +82,23 @@ namespace clia {
             BufferPtr current_buffer_;
             BufferPtr next_buffer_;
             BufferVector buffers_;
+            DropStats current_tally_;           // current_buffer_ 中各级别的行数与字节数
+            std::vector<DropStats> tallies_;    // 与 buffers_ 一一对应
+            std::condition_variable not_full_;  // 加锁模式下等待 buffers_ 有空位
             std::atomic<bool> running_;
             std::thread thread_;
             std::mutex lck_;
             std::condition_variable cond_;
+            const std::uint64_t id_;        // 区分 logger 实例，线程本地的缓存按它查找
+            const std::size_t ring_bytes_;
+            std::mutex rings_lck_;          // 只在线程注册与后台线程取快照时使用
+            std::vector<std::shared_ptr<ThreadRing>> rings_;
+            std::atomic<bool> wakeup_;
+            std::atomic<bool> shed_;            // 有环形缓冲区请求丢弃最早的记录
+            std::atomic<Overflow> overflow_;
+            std::atomic<Level> keep_level_;
+            std::atomic<std::uint64_t> dropped_lines_[kLevelCount];
+            std::atomic<std::uint64_t> dropped_bytes_[kLevelCount];
         };
         // 其他成员函数和数据成员可以根据需要添加
     } // namespace log
@@ -0,0 +1,139 @@
+#ifndef CLIA_LOG_BINARY_H_
+#define CLIA_LOG_BINARY_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include "clia/base/noncopyable.h"
+#include "clia/log/trait.h"
+
+namespace clia {
+    namespace log {
+        /**
+         * 延迟格式化的二进制日志：每个调用点有一个静态描述符(格式串、文件、行号、级别)，第一次执行时注册；
+         * 热路径只把时间、线程 id 与参数的原始字节编码成一条记录交给 Logger::log_binary，
+         * 格式化推迟到后台线程(AsyncLogger)或交由 binary::format 在别处完成。
+         * 格式串使用 printf 语法，长度修饰符会被忽略(按实际参数类型格式化)，不支持 '*' 宽度与精度
+         */
+        namespace binary {
+            class Site final : Noncopyable {
+            public:
+                Site(const Level level, const char *format, const char *file, const int line, const char *func) noexcept;
+            public:
+                const Level level;
+                const char *const format;
+                const char *const file;
+                const int line;
+                const char *const func;
+                const std::uint32_t id;     // 注册顺序，从 1 开始
+            };
+
+            // 已注册调用点的快照，供离线解码时导出
+            std::vector<const Site*> sites();
+
+            enum class Tag : std::uint8_t {
+                kInt = 1,
+                kUint,
+                kDouble,
+                kChar,
+                kString,    // 4 字节长度 + 内容
+                kPointer,
+            };
+
+            // 在调用线程栈上编码一条记录：[int64 微秒时间戳][int32 线程 id]{[tag][值]}...
+            class Encoder final : Noncopyable {
+            public:
+                static constexpr std::size_t kMaxSize = 1024;
+            public:
+                Encoder() noexcept;
+            public:
+                const void* data() const noexcept { return buf_; }
+                std::size_t size() const noexcept { return len_; }
+
+                void put(const Tag tag, const void *value, const std::size_t len) noexcept;
+                void put_string(const char *str, const std::size_t len) noexcept;
+            private:
+                char buf_[kMaxSize];
+                std::size_t len_;
+            };
+
+            template <typename T>
+            inline typename std::enable_if<(std::is_integral<T>::value || std::is_enum<T>::value) && std::is_signed<T>::value>::type
+            encode(Encoder &enc, const T value) noexcept {
+                const std::int64_t v = value;
+                enc.put(Tag::kInt, &v, sizeof(v));
+            }
+
+            template <typename T>
+            inline typename std::enable_if<(std::is_integral<T>::value || std::is_enum<T>::value) && !std::is_signed<T>::value>::type
+            encode(Encoder &enc, const T value) noexcept {
+                const std::uint64_t v = static_cast<std::uint64_t>(value);
+                enc.put(Tag::kUint, &v, sizeof(v));
+            }
+
+            inline void encode(Encoder &enc, const bool value) noexcept {
+                const std::int64_t v = value ? 1 : 0;
+                enc.put(Tag::kInt, &v, sizeof(v));
+            }
+
+            inline void encode(Encoder &enc, const char value) noexcept {
+                enc.put(Tag::kChar, &value, sizeof(value));
+            }
+
+            inline void encode(Encoder &enc, const double value) noexcept {
+                enc.put(Tag::kDouble, &value, sizeof(value));
+            }
+
+            inline void encode(Encoder &enc, const float value) noexcept {
+                encode(enc, static_cast<double>(value));
+            }
+
+            // 字符串按值复制，调用返回后原字符串可以释放
+            inline void encode(Encoder &enc, const char *value) noexcept {
+                if (nullptr == value) {
+                    enc.put_string("(null)", 6);
+                } else {
+                    enc.put_string(value, std::strlen(value));
+                }
+            }
+
+            inline void encode(Encoder &enc, char *value) noexcept {
+                encode(enc, static_cast<const char*>(value));
+            }
+
+            inline void encode(Encoder &enc, const std::string &value) noexcept {
+                enc.put_string(value.data(), value.size());
+            }
+
+            inline void encode(Encoder &enc, const void *value) noexcept {
+                const std::uint64_t v = reinterpret_cast<std::uintptr_t>(value);
+                enc.put(Tag::kPointer, &v, sizeof(v));
+            }
+
+            inline void encode_all(Encoder&) noexcept {}
+
+            template <typename Arg, typename... Args>
+            inline void encode_all(Encoder &enc, const Arg &arg, const Args&... args) noexcept {
+                encode(enc, arg);
+                encode_all(enc, args...);
+            }
+
+            template <typename Logger, typename... Args>
+            inline void log(const Logger &logger, const Site *site, const Args&... args) noexcept {
+                Encoder enc;
+                encode_all(enc, args...);
+                logger->log_binary(site, enc.data(), enc.size());
+            }
+
+            /// @brief 把一条二进制记录格式化为与 Event 相同格式的文本日志行(含换行)
+            /// @return 写入 out 的字节数，空间不足时截断
+            std::size_t format(const Site &site, const void *record, const std::size_t len, char *out, const std::size_t cap) noexcept;
+        }
+    }
+}
+
+#endif
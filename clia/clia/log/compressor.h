@@ -0,0 +1,49 @@
+#ifndef CLIA_LOG_COMPRESSOR_H_
+#define CLIA_LOG_COMPRESSOR_H_
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include "clia/base/noncopyable.h"
+
+namespace clia {
+    namespace log {
+        /**
+         * 后台压缩已关闭的日志文件：file 压缩为 file.gz(先写 file.gz.tmp 再改名)，成功后删除原文件。
+         * 压缩线程把自己的 CPU 优先级降到 nice 19、IO 优先级降到 idle，不与正在写日志的线程争抢资源。
+         * 编译时没有找到 zlib 则 available() 返回 false，不启动线程
+         */
+        class Compressor final : Noncopyable {
+        public:
+            static constexpr const char *kSuffix = ".gz";
+            static constexpr const char *kTempSuffix = ".gz.tmp";
+        public:
+            // level 为 zlib 压缩级别 1-9
+            explicit Compressor(const int level = 6);
+            // 处理完队列中剩余的文件后退出
+            ~Compressor() noexcept;
+        public:
+            static bool available() noexcept;
+            // 在调用线程中压缩 filename，成功返回 true
+            static bool compress(const std::string &filename, const int level) noexcept;
+
+            void submit(const std::string &filename);
+            std::size_t pending() const;
+        private:
+            void thread_func() noexcept;
+        private:
+            const int level_;
+            std::deque<std::string> files_;
+            mutable std::mutex lck_;
+            std::condition_variable cond_;
+            std::atomic<bool> running_;
+            std::thread thread_;
+        };
+    }
+}
+
+#endif
@@ -1,8 +1,13 @@
 #ifndef CLIA_LOG_EVENT_H_
 #define CLIA_LOG_EVENT_H_
 
+#include <atomic>
+#include <cassert>
+#include <cstddef>
 #include <memory>
 #include <sstream>
+#include <string>
+#include <type_traits>
 
 #include "clia/log/trait.h"
 #include "clia/container/fixed_ostream.h"
@@ -13,13 +18,16 @@ namespace clia {
         class Event final : Noncopyable {
             using Stream = clia::container::FixedOStream<1024>;
         public:
-            Event(std::shared_ptr<trait::Logger> logger, const Level level, const char *file, const int line, const char *func) noexcept;
+            // 只作为日志宏中的临时对象使用，logger 在语句结束前必须有效
+            Event(trait::Logger *logger, const Level level, const char *file, const int line, const char *func) noexcept;
+            Event(const std::shared_ptr<trait::Logger> &logger, const Level level, const char *file, const int line, const char *func) noexcept
+                : Event(logger.get(), level, file, line, func) {}
             ~Event() noexcept;
         public:
             Stream& stream() noexcept;
             void format(const char *fmt, ...) noexcept;
         private:
-            std::shared_ptr<trait::Logger> logger_;
+            trait::Logger *logger_ = nullptr;
             Level level_ = Level::kError;
             Stream stream_;
         };
@@ -27,16 +35,92 @@ namespace clia {
         class LargeEvent final : Noncopyable {
             using Stream = std::stringstream;
         public:
-            LargeEvent(std::shared_ptr<trait::Logger> logger, const Level level, const char *file, const int line, const char *func) noexcept;
+            LargeEvent(trait::Logger *logger, const Level level, const char *file, const int line, const char *func) noexcept;
+            LargeEvent(const std::shared_ptr<trait::Logger> &logger, const Level level, const char *file, const int line, const char *func) noexcept
+                : LargeEvent(logger.get(), level, file, line, func) {}
             ~LargeEvent() noexcept;
         public:
             Stream& stream() noexcept;
             void format(const char *fmt, ...) noexcept;
         private:
-             std::shared_ptr<trait::Logger> logger_;
+             trait::Logger *logger_ = nullptr;
             Level level_ = Level::kError;
             Stream stream_;
         };
+
+        /**
+         * 结构化日志，CLIA_SLOG_INFO("conn_closed").kv("fd", fd).kv("bytes", n)，两种输出格式：
+         *   kLogfmt: 与 Event 相同的行首，之后是 event=conn_closed fd=12 bytes=1024
+         *   kJson:   每行一个 JSON 对象 {"ts":"...","pid":1,"tid":2,"level":"INFO","src":"a.cc:f:10","event":"conn_closed","fd":12,...}
+         * 直接编码到栈上的定长缓冲区，不分配堆内存。键必须是字符串字面量，长度在编译期确定，
+         * 只能由字母、数字、'_'、'.'、'-' 组成，原样输出不做转义；字符串值按格式转义，非法的 UTF-8 字节替换为 U+FFFD。
+         * 缓冲区放不下时字符串值在字符边界处截断，其余的键值对被丢弃，并在行尾追加 _truncated=true
+         */
+        class StructuredEvent final : Noncopyable {
+            using Stream = clia::container::FixedOStream<1024>;
+        public:
+            enum class Format {
+                kLogfmt,
+                kJson,
+            };
+        public:
+            StructuredEvent(trait::Logger *logger, const Level level, const char *event, const char *file, const int line, const char *func) noexcept;
+            StructuredEvent(const std::shared_ptr<trait::Logger> &logger, const Level level, const char *event, const char *file, const int line, const char *func) noexcept
+                : StructuredEvent(logger.get(), level, event, file, line, func) {}
+            ~StructuredEvent() noexcept;
+        public:
+            // 进程内所有结构化日志的输出格式，默认 kLogfmt
+            static Format format() noexcept { return format_.load(std::memory_order_relaxed); }
+            static void set_format(const Format format) noexcept { format_.store(format, std::memory_order_relaxed); }
+
+            template <std::size_t N, typename T>
+            StructuredEvent& kv(const char (&key)[N], const T &value) noexcept {
+                static_assert(N > 1, "key must not be empty");
+                if (this->put_key(key, N - 1)) {
+                    this->put_value(value);
+                }
+                return *this;
+            }
+        private:
+            // 写入分隔符与键，剩余空间放不下键和一个数值时返回 false 并标记截断
+            bool put_key(const char *key, const std::size_t len) noexcept;
+
+            template <typename T>
+            typename std::enable_if<std::is_integral<T>::value && std::is_signed<T>::value>::type
+            put_value(const T value) noexcept { this->put_int(value); }
+
+            template <typename T>
+            typename std::enable_if<std::is_integral<T>::value && !std::is_signed<T>::value>::type
+            put_value(const T value) noexcept { this->put_uint(value); }
+
+            template <typename T>
+            typename std::enable_if<std::is_enum<T>::value>::type
+            put_value(const T value) noexcept { this->put_int(static_cast<long long>(value)); }
+
+            void put_value(const bool value) noexcept;
+            void put_value(const char value) noexcept { this->put_string(&value, 1); }
+            void put_value(const double value) noexcept;
+            void put_value(const float value) noexcept { this->put_value(static_cast<double>(value)); }
+            void put_value(const char *value) noexcept;
+            void put_value(const std::string &value) noexcept { this->put_string(value.data(), value.size()); }
+            void put_value(const void *value) noexcept;
+
+            void put_int(const long long value) noexcept;
+            void put_uint(const unsigned long long value) noexcept;
+            void put_raw(const char *data, const std::size_t len) noexcept;
+            // 按当前格式转义并(在需要时)加引号，空间不足时截断
+            void put_string(const char *str, const std::size_t len) noexcept;
+            // 保留给行尾的字节数之外还剩多少空间
+            std::size_t room() const noexcept;
+        private:
+            static std::atomic<Format> format_;
+
+            trait::Logger *logger_ = nullptr;
+            Level level_ = Level::kError;
+            Format fmt_ = Format::kLogfmt;
+            bool truncated_ = false;
+            Stream stream_;
+        };
     }
 }
 
@@ -2,17 +2,39 @@
 #define CLIA_LOG_FILE_APPENDER_H_
 
 #include <cstddef>
+#include <cstdint>
 #include <ctime>
 #include <string>
 #include <cstdio>
 #include <vector>
+#include <memory>
 #include <mutex>
 
+#include "clia/log/compressor.h"
 #include "clia/log/trait.h"
 
 namespace clia {
     namespace log {
+        struct FileAppenderOptions {
+            // 不经过 stdio，自己缓冲并用 write/writev 直接写 fd，大块数据(如 AsyncLogger 的缓冲区)不再复制
+            bool direct_write = false;
+            // 直接写模式下以 O_DIRECT 打开，按 4KB 对齐的块写入、绕过页缓存；
+            // 不足一块的尾部在 flush 时临时关闭 O_DIRECT 写入，文件系统不支持时自动退回普通写
+            bool o_direct = false;
+            // 新文件用 fallocate 预分配的字节数(不改变文件大小)，0 表示不预分配
+            std::size_t preallocate_bytes = 0;
+            // 每写入这么多字节执行一次 fdatasync，0 表示不按字节数
+            std::size_t sync_every_bytes = 0;
+            // 距上次 fdatasync 超过这么多秒时执行一次，0 表示不按时间；滚动和析构时总是会 fsync
+            int sync_every_sec = 0;
+            // 滚动后在后台线程把关闭的文件压缩为 .gz，需要编译时找到 zlib，否则忽略
+            bool compress_rotated = false;
+            int compress_level = 6;         // zlib 压缩级别 1-9
+        };
+
         class FileAppender final : public trait::Appender {
+        public:
+            using Options = FileAppenderOptions;
         public:
             FileAppender(
                 const char *path, 
@@ -21,7 +43,8 @@ namespace clia {
                 const int roll_period_days = 1,
                 const int retain_period_day = 6 * 30, // 保留周期6个月
                 const int check_every = 1024, // 每1024次检查一次是否需要滚动
-                const bool thread_safe = false
+                const bool thread_safe = false,
+                const Options &options = Options()
             );
             ~FileAppender();
         public:
@@ -31,9 +54,19 @@ namespace clia {
             void roll_file() noexcept;
             std::string get_logfilename() noexcept;
             void append_unlocked(const void *buf, const std::size_t size) noexcept;
-            void del_old_files() noexcept; 
+            void del_old_files() noexcept;
+            // 是否是本 appender 产生的日志文件(含压缩后的与压缩中的临时文件)
+            bool is_own_file(const char *name) const noexcept;
+            void open_file(const std::string &filename) noexcept;
+            void close_file() noexcept;
+            void write_direct(const void *buf, const std::size_t size) noexcept;
+            // 写出 staging_ 中的数据；O_DIRECT 下只写完整的块，all 为 true 时连同尾部一起写出但仍保留在 staging_ 中
+            void write_staged(const bool all) noexcept;
+            void maybe_sync(const std::size_t size) noexcept;
         private:
             static constexpr int kBufferSize = 4 * 1024 * 1024; 
+            static constexpr std::size_t kDirectAlignment = 4096;
+            static constexpr std::size_t kWriteThrough = 64 * 1024;   // 不小于这个大小的数据直接 writev，不复制
         private:
             const std::string path_;
             const std::string logname_;
@@ -48,6 +81,17 @@ namespace clia {
             std::size_t written_bytes_;
             std::FILE *file_; 
             std::vector<char> buffer_;           
+            const Options options_;
+            int fd_;                        // 直接写模式下的文件描述符
+            bool o_direct_;                 // 当前文件实际是否以 O_DIRECT 打开
+            char *staging_;                 // 直接写模式的缓冲区，位于 buffer_ 中并按 kDirectAlignment 对齐
+            std::size_t staged_;
+            std::uint64_t file_offset_;     // O_DIRECT 下已按块写入的长度
+            std::size_t unsynced_bytes_;
+            std::time_t last_sync_;
+            std::string filename_;          // 当前写入的文件
+            std::string file_suffix_;       // 文件名中时间与 pid 之后的部分，如 ".app.log"
+            std::unique_ptr<Compressor> compressor_;
         };
     }
 }
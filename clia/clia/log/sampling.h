@@ -0,0 +1,128 @@
+#ifndef CLIA_LOG_SAMPLING_H_
+#define CLIA_LOG_SAMPLING_H_
+
+#include <atomic>
+#include <cstdint>
+#include <ctime>
+
+namespace clia {
+    namespace log {
+        /**
+         * 按调用点采样与限流的状态，由 log.h 中的 CLIA_LOG_EVERY_N 等宏在每个调用点定义一个静态实例。
+         * 构造函数是 constexpr，静态实例在编译期完成初始化，没有局部静态变量的初始化检查；
+         * check 只使用原子操作，不加锁。被跳过的行数会在下一条输出的日志开头以 "[suppressed N] " 给出
+         */
+        namespace sampling {
+            struct Decision {
+                bool emit;
+                std::uint64_t suppressed;   // 上一条输出之后被跳过的行数
+
+                explicit operator bool() const noexcept { return emit; }
+            };
+
+            template <typename OStream>
+            inline OStream& operator<<(OStream &out, const Decision &decision) {
+                if (decision.suppressed > 0) {
+                    out << "[suppressed " << decision.suppressed << "] ";
+                }
+                return out;
+            }
+
+            // 单调时钟，纳秒；使用 COARSE 时钟，精度为一个时钟节拍(通常 1-4ms)
+            inline std::int64_t now_ns() noexcept {
+                ::timespec ts;
+                ::clock_gettime(CLOCK_MONOTONIC_COARSE, &ts);
+                return static_cast<std::int64_t>(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+            }
+
+            // 第 1、n+1、2n+1... 次输出
+            class EveryN final {
+            public:
+                constexpr EveryN() noexcept : count_(0) {}
+            public:
+                Decision check(const std::uint64_t n) noexcept {
+                    const std::uint64_t count = count_.fetch_add(1, std::memory_order_relaxed);
+                    if (n <= 1) {
+                        return Decision{true, 0};
+                    }
+                    if (count % n != 0) {
+                        return Decision{false, 0};
+                    }
+                    return Decision{true, 0 == count ? 0 : n - 1};
+                }
+            private:
+                std::atomic<std::uint64_t> count_;
+            };
+
+            // 只输出前 n 次
+            class FirstN final {
+            public:
+                constexpr FirstN() noexcept : count_(0) {}
+            public:
+                Decision check(const std::uint64_t n) noexcept {
+                    // 超过 n 次之后只读不写，避免多线程争用同一缓存行
+                    if (count_.load(std::memory_order_relaxed) >= n) {
+                        return Decision{false, 0};
+                    }
+                    return Decision{count_.fetch_add(1, std::memory_order_relaxed) < n, 0};
+                }
+            private:
+                std::atomic<std::uint64_t> count_;
+            };
+
+            // 每 seconds 秒最多输出一次
+            class EveryT final {
+            public:
+                constexpr EveryT() noexcept : next_(0), skipped_(0) {}
+            public:
+                Decision check(const double seconds) noexcept {
+                    const std::int64_t now = now_ns();
+                    std::int64_t next = next_.load(std::memory_order_relaxed);
+                    // 多个线程同时到期时只有 CAS 成功的一个输出
+                    if (now < next || !next_.compare_exchange_strong(next, now + static_cast<std::int64_t>(seconds * 1e9), std::memory_order_relaxed)) {
+                        skipped_.fetch_add(1, std::memory_order_relaxed);
+                        return Decision{false, 0};
+                    }
+                    return Decision{true, skipped_.exchange(0, std::memory_order_relaxed)};
+                }
+            private:
+                std::atomic<std::int64_t> next_;
+                std::atomic<std::uint64_t> skipped_;
+            };
+
+            // 令牌桶：平均每秒 rate 条，最多连续 burst 条。
+            // 用 GCRA 实现，只需要一个原子变量(理论上下一个令牌到达的时间)
+            class TokenBucket final {
+            public:
+                constexpr TokenBucket() noexcept : tat_(0), skipped_(0) {}
+            public:
+                Decision check(const double rate, const double burst) noexcept {
+                    if (rate <= 0) {
+                        skipped_.fetch_add(1, std::memory_order_relaxed);
+                        return Decision{false, 0};
+                    }
+                    const std::int64_t interval = static_cast<std::int64_t>(1e9 / rate);
+                    const std::int64_t tolerance = static_cast<std::int64_t>(interval * (burst > 1 ? burst - 1 : 0));
+                    const std::int64_t now = now_ns();
+                    std::int64_t tat = tat_.load(std::memory_order_relaxed);
+                    for (;;) {
+                        const std::int64_t base = tat > now ? tat : now;
+                        if (base - now > tolerance) {
+                            skipped_.fetch_add(1, std::memory_order_relaxed);
+                            return Decision{false, 0};
+                        }
+                        if (tat_.compare_exchange_weak(tat, base + interval, std::memory_order_relaxed)) {
+                            break;
+                        }
+                    }
+                    return Decision{true, skipped_.exchange(0, std::memory_order_relaxed)};
+                }
+            private:
+                std::atomic<std::int64_t> tat_;
+                std::atomic<std::uint64_t> skipped_;
+            };
+        }
+    }
+}
+
+#endif
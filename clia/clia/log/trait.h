@@ -1,6 +1,7 @@
 #ifndef CLIA_LOG_TRAIT_H_
 #define CLIA_LOG_TRAIT_H_
 
+#include <atomic>
 #include <cstddef>
 #include <memory>
 
@@ -17,6 +18,10 @@ namespace clia {
             kFatal,
         };
         extern const char* level_to_string(const Level level) noexcept;
+
+        namespace binary {
+            class Site;
+        }
         
         namespace trait {
             class Appender : Noncopyable {
@@ -49,15 +54,20 @@ namespace clia {
                 Logger(const Level level, std::shared_ptr<Appender> appender) noexcept;
                 virtual ~Logger() noexcept = default;
             public:
-                Level level() const noexcept;
+                Level level() const noexcept { return level_.load(std::memory_order_relaxed); }
+                /// 运行期调整日志级别，对所有线程立即生效，无需加锁
+                void set_level(const Level level) noexcept { level_.store(level, std::memory_order_relaxed); }
                 /// 日志记录函数，只有当日志级别大于等于当前设置的级别时才会记录
                 /// @param level 日志级别
                 /// @param message 日志消息内容
                 /// @param len 日志消息长度 
                 /// @note 该函数会调用具体的 log() 函数来处理日志记录, 该函数的实现要求是线程安全的
                 virtual void log(const Level level, const void *message, const std::size_t len) noexcept = 0;
+                /// 二进制日志记录函数，record 为 binary::Encoder 编码的参数
+                /// @note 默认实现在调用线程中格式化后交给 log()，异步实现可以只保存原始字节、推迟格式化
+                virtual void log_binary(const binary::Site *site, const void *record, const std::size_t len) noexcept;
             protected:
-                const Level level_ = Level::kError;          // 日志级别
+                std::atomic<Level> level_;                  // 日志级别
                 const std::shared_ptr<Appender> appender_;  // 日志追加器
             };
         }
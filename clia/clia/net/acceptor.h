@@ -3,6 +3,7 @@
 
 #include <functional>
 #include <memory>
+#include <vector>
 
 #include "clia/base/noncopyable.h"
 #include "clia/net/inet_address.h"
@@ -17,11 +18,20 @@ namespace clia {
             using NewConnectionCallback = std::function<void(int connfd, const InetAddress &peer_addr)>;
         public:
             Acceptor(clia::reactor::EventLoop *loop, const InetAddress &listen_addr, const bool reuseport = true);
+            // 接管已经 bind(可能已经 listen)的监听 socket，如热重启时从旧进程收到的 fd
+            Acceptor(clia::reactor::EventLoop *loop, const int listenfd);
             ~Acceptor() noexcept;
         public:
             void set_new_connection_callback(const NewConnectionCallback &cb);
             void listen() noexcept;
             bool listening() const noexcept;
+            // 不再接受新连接并关闭监听 socket，之后不能再 listen。内核不再向其完成握手，
+            // reuseport 组中的其他 socket 接手新连接；热重启后新进程持有同一 socket 的副本，已排队的连接留给新进程
+            void stop_listening() noexcept;
+            // stop_listening 之后为 -1
+            int fd() const noexcept;
+            // 见 Socket::attach_reuseport_cpu_steering
+            bool attach_reuseport_cpu_steering(const std::vector<int> &cpu_to_index);
         private:
             void handle_read();
         private:
@@ -2,11 +2,14 @@
 #define CLIA_NET_BUFFER_H_
 
 #include <cstddef>
+#include <cstdint>
 #include <sys/types.h>
 #include <vector>
 #include <string>
 
 #include "clia/base/copyable.h"
+#include "clia/base/noncopyable.h"
+#include "clia/util/memory_pool.h"
 
 namespace clia {
     namespace net {
@@ -14,6 +17,13 @@ namespace clia {
         public:
             static constexpr std::size_t kCheapPrepend = 8;
             static constexpr std::size_t kInitialSize = 1024;
+            // read_fd 在栈上额外提供的读空间，一次读取最多 writable_bytes() + kExtraReadSize 字节
+            static constexpr std::size_t kExtraReadSize = 65536;
+            // 默认大小的初始存储从当前线程的 slab 池分配，连接关闭后归还复用
+            struct PoolTag {
+                static constexpr std::size_t kBlocksPerSlab = 64;
+                static const char* name() noexcept { return "buffer"; }
+            };
         public:
             explicit Buffer(const std::size_t inital_size = kInitialSize);
             Buffer(const Buffer &oth);
@@ -25,24 +35,98 @@ namespace clia {
             std::size_t readable_bytes() const noexcept;
             std::size_t writable_bytes() const noexcept;
             std::size_t prependable_bytes() const noexcept;
+            // 所有线程的 Buffer 存储池统计
+            static clia::util::SlabPool::Stats pool_stats();
         public:
             const unsigned char* peek() const noexcept;
+            unsigned char* peek() noexcept;
             void retrieve(const std::size_t len) noexcept;
             void retrieve_all() noexcept;
             std::string retrieve_all_as_string();
             std::string retrieve_as_string(const std::size_t len);
             void ensure_writable_bytes(const std::size_t len);
             void append(const void *data, const std::size_t len);
+            // 写在可读数据之前，使用 kCheapPrepend 预留的区域，用于事后补写长度头等
+            void prepend(const void *data, const std::size_t len) noexcept;
             unsigned char* begin_write() noexcept;
             const unsigned char* begin_write() const noexcept;
+            // 直接写入 begin_write() 之后，提交写入的长度
+            void has_written(const std::size_t len) noexcept;
             ::ssize_t read_fd(int fd) noexcept;
             ::ssize_t write_fd(int fd) noexcept;
+        public:
+            // 整数均按网络字节序(大端)编解码，peek/read 要求可读数据足够
+            void append_int8(const std::int8_t x);
+            void append_int16(const std::int16_t x);
+            void append_int32(const std::int32_t x);
+            void append_int64(const std::int64_t x);
+            std::int8_t peek_int8() const noexcept;
+            std::int16_t peek_int16() const noexcept;
+            std::int32_t peek_int32() const noexcept;
+            std::int64_t peek_int64() const noexcept;
+            std::int8_t read_int8() noexcept;
+            std::int16_t read_int16() noexcept;
+            std::int32_t read_int32() noexcept;
+            std::int64_t read_int64() noexcept;
+            void prepend_int8(const std::int8_t x) noexcept;
+            void prepend_int16(const std::int16_t x) noexcept;
+            void prepend_int32(const std::int32_t x) noexcept;
+            void prepend_int64(const std::int64_t x) noexcept;
+        public:
+            // LEB128 变长整数，有符号版本先做 zigzag 编码，使绝对值小的负数也只占少量字节
+            static constexpr std::size_t kMaxVarintLen = 10;
+            void append_varint(const std::uint64_t x);
+            void append_svarint(const std::int64_t x);
+            // 返回编码占用的字节数；数据不完整返回 0，超过 kMaxVarintLen 字节仍未结束返回 -1
+            int peek_varint(std::uint64_t *x) const noexcept;
+            int read_varint(std::uint64_t *x) noexcept;
+            int read_svarint(std::int64_t *x) noexcept;
+        public:
+            /**
+             * 一次性预留整条记录的最大长度，之后逐个字段直接写入，不再逐次检查容量。
+             * 析构(或 commit)时提交实际写入的长度，写入超过预留长度属于调用方错误
+             */
+            class Builder : Noncopyable {
+            public:
+                Builder(Buffer *buf, const std::size_t max_len);
+                ~Builder() noexcept;
+            public:
+                Builder& put_int8(const std::int8_t x) noexcept;
+                Builder& put_int16(const std::int16_t x) noexcept;
+                Builder& put_int32(const std::int32_t x) noexcept;
+                Builder& put_int64(const std::int64_t x) noexcept;
+                Builder& put_varint(const std::uint64_t x) noexcept;
+                Builder& put_svarint(const std::int64_t x) noexcept;
+                Builder& put_bytes(const void *data, const std::size_t len) noexcept;
+                // 尚未提交的字节数
+                std::size_t size() const noexcept;
+                void commit() noexcept;
+            private:
+                Buffer *buf_;
+                unsigned char *begin_;
+                unsigned char *cur_;
+                unsigned char *const end_;
+            };
+        public:
+            // 在可读区域中查找，返回命中位置，找不到返回 nullptr
+            // resume 是相对 peek() 的偏移：从该处开始扫描；未命中时更新为下次可继续扫描的位置，
+            // 命中时更新为命中位置。retrieve 之后由调用方减去取走的长度
+            const unsigned char* find_crlf() const noexcept;
+            const unsigned char* find_crlf(std::size_t *resume) const noexcept;
+            const unsigned char* find_eol() const noexcept;
+            const unsigned char* find_eol(std::size_t *resume) const noexcept;
+            const unsigned char* find_byte(const unsigned char c) const noexcept;
+            const unsigned char* find_byte(const unsigned char c, std::size_t *resume) const noexcept;
+            const unsigned char* find_any_of(const char *set, const std::size_t set_len) const noexcept;
+            const unsigned char* find_any_of(const char *set, const std::size_t set_len, std::size_t *resume) const noexcept;
         private:
             unsigned char* begin() noexcept;
             const unsigned char* begin() const noexcept;
             void make_space(const std::size_t len);
+            const unsigned char* update_resume(const unsigned char *hit, std::size_t *resume, const std::size_t overlap) const noexcept;
         private:
-            std::vector<unsigned char> buffer_;
+            std::vector<unsigned char,
+                clia::util::SizeClassAllocator<unsigned char, PoolTag, kCheapPrepend + kInitialSize>> buffer_;
             std::size_t reader_index_;
             std::size_t writer_index_;
         };
@@ -0,0 +1,74 @@
+#ifndef CLIA_NET_CONNECTOR_H_
+#define CLIA_NET_CONNECTOR_H_
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <random>
+
+#include "clia/base/noncopyable.h"
+#include "clia/net/inet_address.h"
+#include "clia/reactor/base.h"
+#include "clia/reactor/timer_queue.h"
+
+namespace clia {
+    namespace net {
+        /**
+         * 非阻塞 connect：EINPROGRESS 后关注可写事件，可写时通过 SO_ERROR 判断是否连接成功。
+         * 失败后按指数退避 + 随机抖动重试，避免大量客户端在服务端重启后同时重连。
+         * 由 TcpClient 持有，所有状态只在 loop 线程内修改。
+         */
+        class Connector : Noncopyable, public std::enable_shared_from_this<Connector> {
+        public:
+            using NewConnectionCallback = std::function<void(int sockfd)>;
+            static constexpr int kInitRetryDelayMs = 500;
+            static constexpr int kMaxRetryDelayMs = 30 * 1000;
+        public:
+            Connector(clia::reactor::EventLoop *loop, const InetAddress &server_addr);
+            ~Connector();
+        public:
+            void set_new_connection_callback(const NewConnectionCallback &cb);
+            // 需在 start 之前设置
+            void set_retry_delay(const int init_ms, const int max_ms) noexcept;
+            const InetAddress& server_addr() const noexcept;
+            // 可在任意线程调用
+            void start();
+            // 只能在 loop 线程调用，重置退避时间后重新连接
+            void restart();
+            // 可在任意线程调用
+            void stop();
+        private:
+            enum class State {
+                kDisconnected,
+                kConnecting,
+                kConnected,
+            };
+        private:
+            void set_state(const State state) noexcept;
+            void start_in_loop();
+            void stop_in_loop();
+            void connect();
+            void connecting(const int sockfd);
+            void handle_write();
+            void handle_error();
+            void retry(const int sockfd);
+            int remove_and_reset_channel();
+            void reset_channel();
+            int next_retry_delay_ms();
+        private:
+            clia::reactor::EventLoop *const loop_;
+            const InetAddress server_addr_;
+            std::atomic_bool connect_;
+            std::atomic<State> state_;
+            std::unique_ptr<clia::reactor::Channel> channel_;
+            NewConnectionCallback new_connection_callback_;
+            int init_retry_delay_ms_;
+            int max_retry_delay_ms_;
+            int retry_delay_ms_;        // 当前退避上限，每次失败翻倍
+            clia::reactor::TimerId retry_timer_;
+            std::mt19937 rng_;
+        };
+    }
+}
+
+#endif
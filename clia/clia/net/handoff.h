@@ -0,0 +1,65 @@
+#ifndef CLIA_NET_HANDOFF_H_
+#define CLIA_NET_HANDOFF_H_
+
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+#include "clia/net/inet_address.h"
+
+namespace clia {
+    namespace net {
+        /**
+         * 热重启时从旧进程接收到的 socket。
+         * 旧进程在本地 Unix 域 socket 上等待，新进程连上后旧进程通过 SCM_RIGHTS 依次发送监听 socket
+         * 和(可选的)空闲连接，新进程开始接受连接后回复 READY，旧进程才停止接受并开始排空。
+         * 两个进程共享同一个监听 socket，交接期间内核队列中的连接由任意一方接受，不存在无人接受的间隙
+         */
+        struct HandoffState {
+            int listen_fd = -1;
+            std::vector<std::pair<int, InetAddress>> connections;
+            int channel_fd = -1;    // 与旧进程的交接连接，发送 READY 并等到旧进程关闭之后关闭
+
+            bool valid() const noexcept { return listen_fd >= 0; }
+        };
+
+        namespace handoff {
+            // 一条消息最多携带的连接数，小于内核 SCM_MAX_FD(253)
+            constexpr std::size_t kMaxFdsPerMessage = 64;
+
+            /**
+             * 旧进程：把监听 socket 与连接发送给新进程。
+             * 消息在构造时全部编码好，write 在非阻塞的交接连接上尽量发送，写不动时返回，由调用方在可写事件中再次调用。
+             * 发送完成之前这些文件描述符必须保持打开
+             */
+            class Sender final {
+            public:
+                Sender(const int listen_fd, const std::vector<std::pair<int, InetAddress>> &connections);
+            public:
+                /// @return 1 表示全部发送完成，0 表示需要等待可写，-1 表示出错
+                int write(const int sock) noexcept;
+            private:
+                struct Message {
+                    std::vector<unsigned char> data;
+                    std::vector<int> fds;   // 随消息的第一个字节发出
+                };
+                std::vector<Message> messages_;
+                std::size_t index_;         // 正在发送的消息
+                std::size_t offset_;        // 该消息已发送的字节数
+            };
+
+            /// @brief 旧进程：读取新进程的 READY
+            /// @return 1 表示收到 READY，0 表示暂无数据，-1 表示连接断开或协议错误
+            int read_ready(const int sock) noexcept;
+
+            /// @brief 新进程：连接旧进程在 addr 上的交接 socket，接收监听 socket 与连接
+            /// @return 成功返回 true；失败时 state 保持无效，调用方应自行 bind 监听地址
+            bool receive(const InetAddress &addr, HandoffState *state, const double timeout_sec = 5.0) noexcept;
+
+            /// @brief 新进程：开始接受连接之后通知旧进程，等旧进程释放交接 socket 路径并关闭连接后再关闭交接连接
+            bool notify_ready(HandoffState *state) noexcept;
+        }
+    }
+}
+
+#endif
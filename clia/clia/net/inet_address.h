@@ -2,7 +2,10 @@
 #define CLIA_NET_INET_ADDR_H_
 
 #include <cstdint>
+#include <string>
 #include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/un.h>
 
 #include "clia/base/copyable.h"
 
@@ -14,19 +17,32 @@ namespace clia {
             InetAddress(const char *ip, std::uint16_t port, const bool is_ipv6 = false) noexcept;
             explicit InetAddress(const ::sockaddr_in &addr) noexcept;
             explicit InetAddress(const ::sockaddr_in6 &addr) noexcept;
+            // 由 accept/getpeername 等返回的地址构造，支持 AF_INET、AF_INET6、AF_UNIX
+            InetAddress(const ::sockaddr *addr, const ::socklen_t len) noexcept;
             InetAddress(const InetAddress &oth) noexcept;
             InetAddress& operator=(const InetAddress &oth) noexcept;
             ~InetAddress() noexcept;
+        public:
+            // Unix 域地址，abstract 为 true 时使用 Linux 抽象命名空间(不在文件系统中创建文件)
+            static InetAddress unix_domain(const std::string &path, const bool abstract = false) noexcept;
         public:
             ::sa_family_t family() const noexcept;
+            bool is_unix() const noexcept;
             int get_ipaddr(char *buf, const std::size_t sz) const noexcept;
             std::string get_addr() const noexcept;
             const ::sockaddr* get_sockaddr() const noexcept;
+            ::socklen_t socklen() const noexcept;
+            std::uint16_t port() const noexcept;
+        public:
+            bool operator==(const InetAddress &oth) const noexcept;
+            bool operator!=(const InetAddress &oth) const noexcept;
         private:
             union {
                 ::sockaddr_in addr_;
                 ::sockaddr_in6 addr6_;
+                ::sockaddr_un addr_un_;
             };
+            ::socklen_t un_len_;    // AF_UNIX 地址的实际长度，抽象命名空间依赖它确定名字长度
         };
     }
 }
@@ -1,16 +1,61 @@
 #ifndef CLIA_NET_SOCKET_H_
 #define CLIA_NET_SOCKET_H_
 
+#include <cstdint>
+#include <vector>
+#include <sys/socket.h>
+
 #include "clia/base/noncopyable.h"
+#include "clia/util/timestamp.h"
 
 namespace clia {
     namespace net {
         class InetAddress;
 
+        // TCP_INFO 中与尾延迟相关的字段
+        struct TcpInfo {
+            clia::util::Timestamp sampled_at;   // 未采样过时无效
+            std::uint32_t rtt_us = 0;
+            std::uint32_t rttvar_us = 0;
+            std::uint32_t snd_cwnd = 0;         // 单位为 MSS
+            std::uint32_t snd_mss = 0;
+            std::uint32_t unacked = 0;
+            std::uint32_t lost = 0;
+            std::uint32_t retransmits = 0;      // 当前未恢复的连续重传次数
+            std::uint32_t total_retrans = 0;
+            std::uint32_t rto_us = 0;
+            std::uint32_t snd_ssthresh = 0;
+        };
+
+        /**
+         * 一组 socket 选项，TcpServer 对每个接受的连接应用。数值为 0 的项保持系统默认。
+         * 预置了几个常用的命名配置，也可以在其基础上修改
+         */
+        struct SocketProfile {
+            const char *name = "default";
+            bool tcp_nodelay = false;
+            bool keepalive = true;
+            int recv_buffer = 0;                // SO_RCVBUF，字节
+            int send_buffer = 0;                // SO_SNDBUF，字节
+            int notsent_lowat = 0;              // TCP_NOTSENT_LOWAT，字节
+            bool quickack = false;              // TCP_QUICKACK 不是持久选项，每次读之后重新设置
+            unsigned int user_timeout_ms = 0;   // TCP_USER_TIMEOUT
+            double tcp_info_interval_sec = 0.0; // 周期采样 TCP_INFO，0 表示只在调用时采样
+
+            static SocketProfile defaults();
+            // 交互式请求：关闭 Nagle、立即 ACK，限制内核中未发送的数据量以降低排队延迟
+            static SocketProfile low_latency();
+            // 大块传输：加大收发缓冲区
+            static SocketProfile bulk();
+        };
+
         class Socket : Noncopyable {
         public:
             explicit Socket(const int sockfd) noexcept;
             virtual ~Socket() noexcept;
+        public:
+            // 创建非阻塞的流式 socket，AF_UNIX 使用默认协议，失败时直接终止
+            static int create_nonblocking(const ::sa_family_t family) noexcept;
         public:
             int fd() const noexcept;
             void bind_address(const InetAddress &local_addr) noexcept;
@@ -19,9 +64,24 @@ namespace clia {
             void shutdown_write() noexcept;
         public:
             void set_tcp_nodelay(const bool on) noexcept;
+            // 开启后内核攒满一个 MSS 才发送，关闭时立即推出剩余数据
+            void set_tcp_cork(const bool on) noexcept;
             void set_reuse_addr(const bool on) noexcept;
             void set_reuse_port(const bool on) noexcept;
             void set_keeyalive(const bool on) noexcept;
+            void set_recv_buffer(const int bytes) noexcept;
+            void set_send_buffer(const int bytes) noexcept;
+            void set_tcp_notsent_lowat(const int bytes) noexcept;
+            void set_tcp_quickack(const bool on) noexcept;
+            void set_tcp_user_timeout(const unsigned int timeout_ms) noexcept;
+            // is_tcp 为 false 时(Unix 域 socket)只应用通用的 socket 选项
+            void apply(const SocketProfile &profile, const bool is_tcp) noexcept;
+            bool get_tcp_info(TcpInfo *info) const noexcept;
+            // 内核最后一次为该连接处理接收软中断的 CPU(SO_INCOMING_CPU)，失败返回 -1
+            int incoming_cpu() const noexcept;
+            // 给所在的 SO_REUSEPORT 组挂载 CBPF 程序，接收 CPU 为 cpu 时选择第 cpu_to_index[cpu] 个监听 socket，
+            // 表外或值为负的 CPU 由内核按哈希选择
+            bool attach_reuseport_cpu_steering(const std::vector<int> &cpu_to_index);
         private:
             const int sockfd_;
         };
@@ -0,0 +1,56 @@
+#ifndef CLIA_NET_TCP_CLIENT_H_
+#define CLIA_NET_TCP_CLIENT_H_
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+
+#include "clia/base/noncopyable.h"
+#include "clia/net/base.h"
+#include "clia/net/inet_address.h"
+#include "clia/reactor/base.h"
+
+namespace clia {
+    namespace net {
+        class Connector;
+        using ConnectorPtr = std::shared_ptr<Connector>;
+
+        /**
+         * 与 TcpServer 对称的客户端：Connector 负责建立连接，成功后在同一个 loop 上创建 TcpConnection，
+         * 回调模型与 TcpServer 一致。开启 enable_retry 后，连接断开会自动重连。
+         */
+        class TcpClient : Noncopyable {
+        public:
+            TcpClient(clia::reactor::EventLoop *loop, const InetAddress &server_addr);
+            ~TcpClient();
+        public:
+            void connect();
+            void disconnect();
+            void stop();
+            TcpConnectionPtr connection() const;
+            clia::reactor::EventLoop* get_loop() const noexcept;
+            bool retry() const noexcept;
+            void enable_retry() noexcept;
+            // 连接失败后的退避区间，需在 connect 之前设置
+            void set_retry_delay(const int init_ms, const int max_ms) noexcept;
+            void set_connection_callback(const ConnectionCallback &cb);
+            void set_message_callback(const MessageCallback &cb);
+            void set_write_complete_callback(const WriteCompleteCallback &cb);
+        private:
+            void new_connection(int sockfd);
+            void remove_connection(const TcpConnectionPtr &conn);
+        private:
+            clia::reactor::EventLoop *const loop_;
+            ConnectorPtr connector_;
+            ConnectionCallback connection_callback_;
+            MessageCallback message_callback_;
+            WriteCompleteCallback write_complete_callback_;
+            std::atomic_bool retry_;
+            std::atomic_bool connect_;
+            mutable std::mutex mutex_;
+            TcpConnectionPtr connection_;
+        };
+    }
+}
+
+#endif
@@ -2,7 +2,11 @@
 #define CLIA_NET_TCP_CONNECTION_H_
 
 #include <atomic>
+#include <deque>
 #include <memory>
+#include <mutex>
+
+#include <sys/uio.h>
 
 #include "clia/net/inet_address.h"
 #include "clia/reactor/base.h"
@@ -11,6 +15,8 @@
 #include "clia/base/noncopyable.h"
 #include "clia/net/socket.h"
 #include "clia/reactor/channel.h"
+#include "clia/reactor/timer_queue.h"
+#include "clia/util/memory_pool.h"
 
 namespace clia {
     namespace net {
@@ -25,20 +31,70 @@ namespace clia {
                 kConnected,     // 已连接
                 kDisconnecting, // 正在断开连接
             };
+        public:
+            // 连接对象(连同 shared_ptr 控制块)所在 slab 池的标记
+            struct PoolTag {
+                static constexpr std::size_t kBlocksPerSlab = 64;
+                static const char* name() noexcept { return "tcp_connection"; }
+            };
         public:
             TcpConnection(clia::reactor::EventLoop *loop, const int sockfd, const InetAddress &peer_addr);
             ~TcpConnection();
+        public:
+            // 从当前线程的 slab 池一次性分配对象与控制块，应优先于 new TcpConnection 使用
+            static TcpConnectionPtr create(clia::reactor::EventLoop *loop, const int sockfd, const InetAddress &peer_addr);
+            // 所有线程的连接池统计
+            static clia::util::SlabPool::Stats pool_stats();
         public:
             clia::reactor::EventLoop* get_loop() const noexcept;
             const InetAddress& peer_addr() const noexcept;
             int fd() const noexcept;
             bool connected() const noexcept;
             void send(const void *buf, const std::size_t len);
+            // 发送 buf 中全部可读数据并清空 buf，在 loop 线程内调用时不会额外拷贝
+            void send(Buffer *buf);
+            // 分散写：发送缓冲区为空时直接 writev，只有没写完的部分才进入发送缓冲区。
+            // copy 为 false 时不拷贝未写完的片段，只记录其地址，调用方需保证数据在写完成回调或连接关闭之前有效
+            void send(const ::iovec *iov, const int iovcnt, const bool copy = true);
             void shutdown();
+            // 不等待发送缓冲区清空，直接关闭连接
+            void force_close();
+            // 开启后，同一轮事件处理中的多次 send 先追加到发送缓冲区，在本轮末尾合并为一次写出。
+            // 应在连接回调中设置
+            void set_write_coalescing(const bool on) noexcept;
+            // cork 之后的 send 只追加到发送缓冲区，直到 uncork 时一次写出；可在任意线程调用。
+            // tcp_cork 为 true 时同时设置 TCP_CORK，让内核把 uncork 前的尾部小包合并成满 MSS 的报文
+            void cork(const bool tcp_cork = false);
+            void uncork();
             void set_connection_callback(const ConnectionCallback &cb);
             void set_message_callback(const MessageCallback &cb);
             void set_write_complete_callback(const WriteCompleteCallback &cb);
             void set_close_callback(const CloseCallback &cb);
+            // 应在 connect_established 之前调用，Unix 域连接只应用通用选项
+            void apply_socket_profile(const SocketProfile &profile);
+            // 最近一次 TCP_INFO 采样，可在任意线程调用；sample_tcp_info 立即重新采样
+            TcpInfo tcp_info() const;
+            bool sample_tcp_info();
+            // 内核处理该连接接收软中断的 CPU，-1 表示未知
+            int incoming_cpu() const noexcept;
+            /**
+             * 之后从本连接读到的数据不再交给消息回调，而是直接转发给 peer(L4 代理)。
+             * 优先通过每个连接一对管道用 splice 在两个 socket 之间搬运，不经过用户态缓冲区；
+             * 创建管道失败或 socket 不支持 splice 时退回缓冲拷贝。peer 写不动时停止读取本连接，
+             * peer 写空后恢复。本连接读到 EOF 时只关闭 peer 的写方向(半关闭)，反方向继续工作；
+             * 读方向到 EOF 且本连接的写方向也已关闭(发送数据写完)后才关闭连接。
+             * 只能在 loop 线程调用，peer 必须属于同一个 loop。返回是否使用 splice
+             */
+            bool forward_to(const TcpConnectionPtr &peer);
+            /**
+             * 热重启交接用，只能在 loop 线程调用。连接空闲(收发缓冲区都为空、没有转发或 cork)时停止关注读写事件
+             * 并返回 true，之后到达的数据留在内核中由接手的进程读取；交接失败时用 resume_reading 恢复
+             */
+            bool suspend_if_idle();
+            void resume_reading();
+            // 上层协议挂载在连接上的状态(如 HTTP 解析器)
+            void set_context(const std::shared_ptr<void> &context);
+            const std::shared_ptr<void>& context() const noexcept;
 
             // 连接建立
             void connect_established();
@@ -50,13 +106,62 @@ namespace clia {
             void handle_write();
             void handle_close();
             void handle_error();
+            // 发送缓冲区写出失败：EPIPE/ECONNRESET 时丢弃未发送的数据并关闭连接，其他错误留待下次写事件重试
+            void handle_write_error();
             void send_in_loop(const void *data, const std::size_t len);
+            void send_iov_in_loop(const ::iovec *iov, const int iovcnt, const bool copy);
+            // 未写完的数据按顺序排在发送缓冲区之后的外部片段中时，新数据也必须排到片段之后
+            void append_output(const void *data, const std::size_t len);
+            bool has_pending_output() const noexcept;
+            // 把发送缓冲区与外部片段一次 writev 写出
+            ::ssize_t write_output();
             void shutdown_in_loop();
+            void force_close_in_loop();
+            void handle_forward_read();
+            // 本连接读到 EOF：停止读取并关闭 peer 的写方向
+            void handle_forward_eof(const TcpConnectionPtr &peer);
+            // 把管道(或退回模式下 peer 的发送缓冲区)中的数据推给 peer，并根据 peer 的状态开关本连接的读
+            void pump_forward(const TcpConnectionPtr &peer);
+            void stop_splice();
+            // 转发的读方向已到 EOF 且写方向已关闭时关闭连接
+            void close_if_forward_done();
+            void cork_in_loop(const bool tcp_cork);
+            void uncork_in_loop();
+            void schedule_flush();
+            void flush_in_loop();
+        private:
+            // cork 期间发送缓冲区超过该值时先用 MSG_MORE 写出一部分，避免无限制地缓存
+            static constexpr std::size_t kCorkHighWaterMark = 64 * 1024;
+            static constexpr int kMaxWriteIov = 64;
+            static constexpr int kPipeSize = 256 * 1024;
+            // 缓冲拷贝转发时 peer 未发送数据超过该值则暂停读取
+            static constexpr std::size_t kForwardHighWaterMark = 1024 * 1024;
         private:
+            // 发送缓冲区之后待写的片段，owned 为空时 data 指向调用方保证有效的外部数据
+            struct OutputSlice {
+                const unsigned char *data;
+                std::size_t len;
+                std::unique_ptr<unsigned char[]> owned;
+            };
             clia::reactor::EventLoop *const loop_;
             const int fd_;
             std::atomic<State> state_;
             bool reading_;
+            bool coalescing_;
+            bool corked_;
+            bool tcp_corked_;
+            bool flush_pending_;    // 已排队合并写出，避免一轮中重复排队
+            bool quickack_;
+            double tcp_info_interval_sec_;
+            clia::reactor::TimerId tcp_info_timer_;
+            bool forwarding_;
+            int pipe_fds_[2];       // splice 中转管道，未使用时为 -1
+            std::size_t pipe_bytes_;
+            bool forward_eof_;      // 转发的读方向已到 EOF，已停止读取并关闭了 peer 的写方向
+            std::weak_ptr<TcpConnection> forward_peer_;     // 本连接的数据转发到这里
+            std::weak_ptr<TcpConnection> forward_source_;   // 向本连接转发数据的连接，写空后通知它继续
+            mutable std::mutex tcp_info_mutex_;
+            TcpInfo tcp_info_;
 
             Socket socket_;
             clia::reactor::Channel channel_;
@@ -71,6 +176,8 @@ namespace clia {
 
             Buffer input_buffer_;
             Buffer output_buffer_;
+            std::deque<OutputSlice> output_slices_;
+            std::shared_ptr<void> context_;
         };
     }
 }
@@ -2,19 +2,45 @@
 #define CLIA_NET_TCP_SERVER_H_
 
 #include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <sys/types.h>
 
 #include "clia/base/noncopyable.h"
 #include "clia/net/base.h"
+#include "clia/net/handoff.h"
 #include "clia/net/inet_address.h"
+#include "clia/net/socket.h"
 #include "clia/reactor/base.h"
+#include "clia/reactor/event_loop.h"
 #include "clia/reactor/event_loop_thread_pool.h"
+#include "clia/reactor/timer_queue.h"
 
 namespace clia {
     namespace net {
         class Acceptor;
         class TcpServer : Noncopyable {
+        public:
+            struct SharedNothingStats {
+                std::uint64_t accepted = 0;
+                std::uint64_t cpu_mismatches = 0;   // SO_INCOMING_CPU 与接受该连接的 loop 所在 CPU 不一致
+            };
+            struct DrainStats {
+                std::size_t handed_off = 0; // 交给新进程的空闲连接
+                std::size_t closed = 0;     // 期限内自行关闭的连接
+                std::size_t forced = 0;     // 期限到达时强制关闭的连接
+            };
+            using DrainCallback = std::function<void(const DrainStats&)>;
         public:
             TcpServer(clia::reactor::EventLoop *loop, const InetAddress &listen_addr, const bool reuse_port = false);
+            // 接管旧进程交接过来的监听 socket 与连接(见 handoff::receive)，state 中的 fd 转归 TcpServer 所有。
+            // start 时接管连接并开始接受，随后通知旧进程
+            TcpServer(clia::reactor::EventLoop *loop, const InetAddress &listen_addr, HandoffState *state);
             ~TcpServer();
         public:
             void set_thread_init_callback(clia::reactor::EventLoopThread::ThreadInitCallBack &cb);
@@ -22,14 +48,76 @@ namespace clia {
             void set_message_callback(const MessageCallback &cb);
             void set_write_complete_callback(const WriteCompleteCallback &cb);
             void set_thread_num(const int num = std::thread::hardware_concurrency());
+            // 在 start 之前调用，应用到所有 io loop
+            void set_fairness(const clia::reactor::FairnessOptions &options);
+            // 应用到之后接受的每个连接
+            void set_socket_profile(const SocketProfile &profile);
+            /**
+             * shared-nothing 模式：每个 io loop 依次绑定到本进程允许的一个 CPU，并各自持有一个 SO_REUSEPORT 监听 socket，
+             * 组上挂载按接收 CPU 选择该 CPU 上的 loop 的 CBPF 程序，连接从接受到销毁都只在同一个 loop 中处理。
+             * io loop 数应等于可用 CPU 数：loop 更多时同一 CPU 上只有第一个 loop 接收新连接，
+             * CPU 更多时没有 loop 的 CPU 上的连接由内核按哈希分配。
+             * 需要构造时 reuse_port 为 true 且为 TCP 地址，在 start 之前调用
+             */
+            bool set_shared_nothing(const bool on);
+            SharedNothingStats shared_nothing_stats() const;
             void start();
+            std::size_t connection_count() const noexcept;
+            // 不再接受新连接并关闭监听 socket，之后到达的连接被拒绝而不是排队等待，可在任意线程调用
+            void stop_accepting();
+            // 停止接受新连接，等待现有连接在 timeout_sec 内自行关闭，到期强制关闭剩余的连接，结束后在 base loop 中回调 cb
+            void drain(const double timeout_sec, const DrainCallback &cb);
+            /**
+             * 热重启：在 Unix 域地址 addr 上等待新进程接手，include_idle 为 true 时连同空闲连接一起交出。
+             * 新进程回复 READY 后关闭交接用的监听并删除 socket 文件(新进程可以在同一地址上再次 enable_handoff)，
+             * 然后停止接受并 drain(drain_timeout_sec, cb)；交接中途失败则恢复暂停的连接继续服务。
+             * 在 start 之后调用。shared-nothing 模式下新进程直接加入同一个 SO_REUSEPORT 组即可，不支持交接
+             */
+            bool enable_handoff(const InetAddress &addr, const bool include_idle, const double drain_timeout_sec, const DrainCallback &cb);
         private:
             void new_connection(int sockfd, const InetAddress &peer_addr);
+            void add_connection_in_loop(const TcpConnectionPtr &conn);
             void remove_connection(const TcpConnectionPtr &conn);
             void remove_connection_in_loop(const TcpConnectionPtr &conn);
+        private:
+            // shared-nothing 模式下一个 io loop 的监听 socket 与连接，只在该 loop 线程中访问
+            struct Shard {
+                clia::reactor::EventLoop *loop;
+                int cpu;
+                std::unique_ptr<Acceptor> acceptor;
+                std::map<int, TcpConnectionPtr> connections;
+                std::atomic<std::uint64_t> accepted;
+                std::atomic<std::uint64_t> cpu_mismatches;
+            };
+            void start_shards();
+            void new_connection_in_shard(Shard *shard, int sockfd, const InetAddress &peer_addr);
+            void remove_connection_in_shard(Shard *shard, const TcpConnectionPtr &conn);
+            void setup_connection(const TcpConnectionPtr &conn);
+        private:
+            // 一次热重启交接，只在 base loop 中访问
+            struct Handoff {
+                std::unique_ptr<Acceptor> acceptor;
+                std::unique_ptr<Socket> socket;     // 与新进程的连接，同一时间只处理一个
+                std::unique_ptr<clia::reactor::Channel> channel;
+                std::unique_ptr<handoff::Sender> sender;
+                std::string path;                   // 文件系统中的 socket 路径，抽象命名空间时为空
+                ::ino_t path_ino;                   // bind 创建的 socket 文件，删除前确认未被替换
+                bool include_idle;
+                double drain_timeout_sec;
+                DrainCallback callback;
+                std::vector<TcpConnectionPtr> suspended;
+            };
+            void drain_in_loop(const double timeout_sec, const DrainCallback &cb, const std::size_t handed_off);
+            void check_drain();
+            void handle_handoff_connection(int sockfd, const InetAddress &peer_addr);
+            void handle_handoff_write();
+            void handle_handoff_read();
+            void finish_handoff(const bool ready);
         private:
             using ConnectionMap = std::map<int, TcpConnectionPtr>;
             clia::reactor::EventLoop *const loop_;
+            const InetAddress listen_addr_;
+            const bool reuse_port_;
             std::unique_ptr<Acceptor> acceptor_;
             std::shared_ptr<clia::reactor::EventLoopThreadPool> threadpool_;
             int next_conn_id_;
@@ -38,7 +126,20 @@ namespace clia {
             MessageCallback message_callback_;
             WriteCompleteCallback write_complete_callback_;
             clia::reactor::EventLoopThread::ThreadInitCallBack thread_init_callback_;
+            clia::reactor::FairnessOptions fairness_;
+            SocketProfile socket_profile_;
+            bool shared_nothing_;
+            std::vector<std::unique_ptr<Shard>> shards_;
             ConnectionMap connections_;
+            std::atomic<std::size_t> live_connections_;
+            HandoffState inherited_;
+            std::unique_ptr<Handoff> handoff_;
+            bool draining_;
+            std::size_t drain_initial_;
+            std::int64_t drain_deadline_us_;
+            DrainStats drain_stats_;
+            DrainCallback drain_callback_;
+            clia::reactor::TimerId drain_timer_;
         };
     }
 }
@@ -0,0 +1,68 @@
+#ifndef CLIA_NET_UDP_SERVER_H_
+#define CLIA_NET_UDP_SERVER_H_
+
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include "clia/base/noncopyable.h"
+#include "clia/net/inet_address.h"
+#include "clia/net/udp_socket.h"
+#include "clia/reactor/base.h"
+#include "clia/util/timestamp.h"
+
+namespace clia {
+    namespace net {
+        /**
+         * 单个 EventLoop 上的 UDP 服务。可读时循环 recvmmsg，每批消息一次性交给回调；
+         * send 只把报文追加到待发送队列，在本轮 loop 的事件处理完后统一用 sendmmsg 发出。
+         * 多线程时每个 loop 各建一个实例并开启 reuse_port。
+         */
+        class UdpServer : Noncopyable {
+        public:
+            // msgs 指向的数据只在回调内有效
+            using MessageCallback = std::function<void(UdpServer *server, const UdpMessage *msgs, std::size_t count,
+                clia::util::Timestamp receive_time)>;
+            static constexpr std::size_t kMaxReadRounds = 16;   // 单次可读事件最多读多少批，避免饿死同 loop 的其他连接
+        public:
+            UdpServer(clia::reactor::EventLoop *loop, const InetAddress &listen_addr, const bool reuse_port = false,
+                const std::size_t batch = UdpSocket::kDefaultBatch);
+            ~UdpServer();
+        public:
+            void set_message_callback(const MessageCallback &cb);
+            // 需在 start 之前调用，内核不支持时返回 false
+            bool enable_gro();
+            bool enable_gso();
+            void start();
+            // 只能在 loop 线程调用
+            void send(const InetAddress &peer, const void *data, const std::size_t len);
+            void flush();
+            clia::reactor::EventLoop* get_loop() const noexcept;
+            int fd() const noexcept;
+            UdpStats stats() const noexcept;
+        private:
+            struct PendingSend {
+                std::size_t offset;
+                std::size_t len;
+                InetAddress peer;
+            };
+        private:
+            void start_in_loop();
+            void handle_read(clia::util::Timestamp receive_time);
+        private:
+            clia::reactor::EventLoop *const loop_;
+            UdpSocket socket_;
+            std::unique_ptr<clia::reactor::Channel> channel_;
+            MessageCallback message_callback_;
+            const std::size_t batch_;
+            std::vector<unsigned char> send_storage_;
+            std::vector<PendingSend> pending_;
+            std::vector<UdpMessage> send_msgs_;
+            bool flush_queued_;
+            std::uint64_t tx_dropped_;
+        };
+    }
+}
+
+#endif
@@ -0,0 +1,88 @@
+#ifndef CLIA_NET_UDP_SOCKET_H_
+#define CLIA_NET_UDP_SOCKET_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <sys/socket.h>
+#include <sys/uio.h>
+
+#include "clia/base/noncopyable.h"
+#include "clia/net/inet_address.h"
+
+namespace clia {
+    namespace net {
+        // 一个数据报的视图，data 指向 UdpSocket 的接收槽(或调用方的发送数据)，只在本次回调内有效
+        struct UdpMessage {
+            const unsigned char *data;
+            std::size_t len;
+            InetAddress peer;
+        };
+
+        struct UdpStats {
+            std::uint64_t rx_packets = 0;
+            std::uint64_t rx_syscalls = 0;
+            std::uint64_t rx_truncated = 0;     // 超过接收槽大小被截断的数据报
+            std::uint64_t tx_packets = 0;
+            std::uint64_t tx_syscalls = 0;
+            std::uint64_t tx_dropped = 0;       // 发送缓冲区满时 UdpServer 丢弃的数据报
+        };
+
+        /**
+         * 非阻塞 UDP socket，接收使用 recvmmsg 一次读入多个预分配的接收槽，发送使用 sendmmsg。
+         * 开启 GRO 后内核会把同一来源的连续报文合并到一个槽里，按 segment 大小拆回多个 UdpMessage；
+         * 开启 GSO 后，连续发往同一地址且长度相同的报文合并成一次发送，由内核(或网卡)切分。
+         */
+        class UdpSocket : Noncopyable {
+        public:
+            static constexpr std::size_t kDefaultBatch = 64;
+            static constexpr std::size_t kDefaultSlotSize = 2048;
+            static constexpr std::size_t kGroSlotSize = 65535;
+            static constexpr std::size_t kMaxGsoSegments = 64;
+            static constexpr std::size_t kMaxGsoBytes = 65000;
+        public:
+            explicit UdpSocket(const ::sa_family_t family, const std::size_t batch = kDefaultBatch,
+                const std::size_t slot_size = kDefaultSlotSize);
+            ~UdpSocket() noexcept;
+        public:
+            int fd() const noexcept;
+            void bind_address(const InetAddress &local_addr) noexcept;
+            void set_reuse_addr(const bool on) noexcept;
+            void set_reuse_port(const bool on) noexcept;
+            // 内核不支持时返回 false，保持原有行为
+            bool set_gro(const bool on);
+            bool set_gso(const bool on) noexcept;
+            bool gro() const noexcept;
+            bool gso() const noexcept;
+        public:
+            // 一次 recvmmsg，返回收到的消息数(GRO 拆分后)，出错返回 -1 并保留 errno
+            int recv_batch() noexcept;
+            const UdpMessage* messages() const noexcept;
+            // 返回成功交给内核的消息数，发送缓冲区满时提前返回，剩余部分由调用方决定重试或丢弃
+            std::size_t send_batch(const UdpMessage *msgs, const std::size_t count) noexcept;
+            const UdpStats& stats() const noexcept;
+        private:
+            void alloc_slots();
+        private:
+            const int sockfd_;
+            const std::size_t batch_;
+            std::size_t slot_size_;
+            bool gro_;
+            bool gso_;
+            std::vector<unsigned char> slots_;
+            std::vector<::sockaddr_in6> names_;
+            std::vector<::iovec> iovs_;
+            std::vector<::mmsghdr> hdrs_;
+            std::vector<char> controls_;
+            std::vector<UdpMessage> messages_;
+            // 发送侧
+            std::vector<::iovec> tx_iovs_;
+            std::vector<::mmsghdr> tx_hdrs_;
+            std::vector<char> tx_controls_;
+            UdpStats stats_;
+        };
+    }
+}
+
+#endif
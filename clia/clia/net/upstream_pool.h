@@ -0,0 +1,156 @@
+#ifndef CLIA_NET_UPSTREAM_POOL_H_
+#define CLIA_NET_UPSTREAM_POOL_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+#include "clia/base/noncopyable.h"
+#include "clia/net/base.h"
+#include "clia/net/inet_address.h"
+#include "clia/reactor/base.h"
+#include "clia/reactor/timer_queue.h"
+#include "clia/util/timestamp.h"
+
+namespace clia {
+    namespace net {
+        class Connector;
+
+        /**
+         * 绑定在单个 EventLoop 上的上游连接池，按 InetAddress 区分上游。
+         * 所有接口都必须在所属 loop 线程调用，内部不加锁；每个 IO loop 各建一个实例，
+         * 请求与上游连接始终在同一线程处理，不需要跨线程投递。
+         *
+         * acquire 优先选择未完成请求数最少的已有连接；没有可用连接时在上限内新建连接，
+         * 否则进入等待队列，超过截止时间以空指针回调。用完后必须调用 release。
+         *
+         * 连接的消息回调归连接池所有，使用方不能调用 set_message_callback。每次 acquire 带一个该次请求的
+         * 消息回调，同一连接上的请求(max_outstanding > 1 时可以有多个)按租用顺序排队，收到的数据总是交给
+         * 最早的未完成请求：它从 Buffer 中取走属于自己的响应并在响应完整时调用 release，剩余数据接着交给下一个请求；
+         * 没有取走任何数据时等待更多数据到达。因此请求必须在 AcquireCallback 中立即发出，
+         * 上游按请求顺序返回响应(如 HTTP/1.1、Redis 的流水线)，release(conn, true) 总是结束最早的请求
+         */
+        class UpstreamPool : Noncopyable {
+        public:
+            using AcquireCallback = std::function<void(const TcpConnectionPtr &conn)>;
+
+            struct Options {
+                std::size_t min_idle = 0;                   // 每个上游保持的最少空闲连接数，不足时由健康检查补齐
+                std::size_t max_idle = 8;                   // 超出部分在归还时直接关闭
+                std::size_t max_connections = 64;           // 每个上游的连接上限(含正在连接的)
+                std::size_t max_outstanding = 1;            // 单个连接同时承载的请求数，大于 1 用于可流水线化的协议
+                double idle_timeout_sec = 60.0;             // 空闲超过该时间的连接会被回收(保留 min_idle 个)
+                double connect_timeout_sec = 3.0;
+                double wait_timeout_sec = 1.0;              // acquire 默认的等待截止时间
+                double health_check_interval_sec = 1.0;
+            };
+
+            struct Stats {
+                std::uint64_t acquires = 0;
+                std::uint64_t hits = 0;                     // 直接复用已有连接
+                std::uint64_t misses = 0;                   // 需要等待(新建连接或排队)
+                std::uint64_t wait_timeouts = 0;
+                std::uint64_t connects = 0;
+                std::uint64_t connect_failures = 0;
+                std::uint64_t evictions = 0;                // 空闲超时、超出 max_idle 或健康检查失败而关闭
+                std::uint64_t wait_count = 0;               // 排队后成功拿到连接的次数
+                std::uint64_t wait_total_us = 0;
+                std::uint64_t wait_max_us = 0;
+                std::size_t connections = 0;
+                std::size_t idle = 0;
+                std::size_t waiting = 0;
+
+                double hit_rate() const noexcept {
+                    return acquires > 0 ? static_cast<double>(hits) / static_cast<double>(acquires) : 0.0;
+                }
+                double avg_wait_us() const noexcept {
+                    return wait_count > 0 ? static_cast<double>(wait_total_us) / static_cast<double>(wait_count) : 0.0;
+                }
+            };
+        public:
+            explicit UpstreamPool(clia::reactor::EventLoop *loop);
+            UpstreamPool(clia::reactor::EventLoop *loop, const Options &options);
+            ~UpstreamPool();
+        public:
+            // on_message 接收该次请求的响应；timeout_sec <= 0 时使用 Options::wait_timeout_sec；命中时在调用栈内同步回调
+            void acquire(const InetAddress &addr, const AcquireCallback &cb, const MessageCallback &on_message, const double timeout_sec = 0.0);
+            // 结束该连接上最早的未完成请求；reusable 为 false 时(如协议出错、请求超时)直接关闭该连接，其余未完成的请求随之失效
+            void release(const TcpConnectionPtr &conn, const bool reusable = true);
+            Stats stats() const;
+            clia::reactor::EventLoop* get_loop() const noexcept;
+        private:
+            struct Upstream;
+
+            struct Lease {
+                std::uint64_t id;
+                MessageCallback on_message;
+            };
+
+            struct PooledConn {
+                Upstream *upstream;
+                TcpConnectionPtr conn;
+                std::deque<Lease> leases;           // 未完成的请求，按发出顺序
+                clia::util::Timestamp last_used;
+            };
+
+            struct Waiter {
+                std::uint64_t id;
+                AcquireCallback callback;
+                MessageCallback on_message;
+                clia::util::Timestamp enqueue_time;
+                clia::reactor::TimerId timer;
+            };
+
+            struct Pending {
+                std::shared_ptr<Connector> connector;
+                clia::reactor::TimerId timer;
+            };
+
+            struct Upstream {
+                explicit Upstream(const InetAddress &a) : addr(a) {}
+                InetAddress addr;
+                std::vector<TcpConnection*> conns;
+                std::map<std::uint64_t, Pending> connecting;
+                std::deque<Waiter> waiters;
+            };
+
+            struct AddressHash {
+                std::size_t operator()(const InetAddress &addr) const noexcept;
+            };
+
+            using UpstreamMap = std::unordered_map<InetAddress, std::unique_ptr<Upstream>, AddressHash>;
+            using ConnMap = std::unordered_map<TcpConnection*, PooledConn>;
+        private:
+            Upstream* get_upstream(const InetAddress &addr);
+            PooledConn* pick(Upstream *upstream);
+            void lease(PooledConn *pooled, const AcquireCallback &cb, const MessageCallback &on_message);
+            void serve_waiters(Upstream *upstream);
+            void maybe_connect(Upstream *upstream);
+            void open_connection(Upstream *upstream);
+            void on_connected(Upstream *upstream, const std::uint64_t connect_id, const int sockfd);
+            void on_connect_timeout(Upstream *upstream, const std::uint64_t connect_id);
+            void on_wait_timeout(Upstream *upstream, const std::uint64_t waiter_id);
+            void on_close(const TcpConnectionPtr &conn);
+            void on_message(const TcpConnectionPtr &conn, Buffer *buf, clia::util::Timestamp receive_time);
+            void fail_waiters_if_unreachable(Upstream *upstream);
+            void evict(PooledConn *pooled);
+            void health_check();
+            std::size_t idle_count(const Upstream *upstream) const;
+        private:
+            clia::reactor::EventLoop *const loop_;
+            const Options options_;
+            UpstreamMap upstreams_;
+            ConnMap conns_;
+            std::uint64_t next_id_;
+            clia::reactor::TimerId health_timer_;
+            Stats stats_;
+        };
+    }
+}
+
+#endif
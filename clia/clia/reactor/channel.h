@@ -37,6 +37,9 @@ namespace clia {
 
             int index() const noexcept;
             void set_index(int index) noexcept;
+            // 是否在 EventLoop 的就绪队列中等待处理
+            bool is_deferred() const noexcept;
+            void set_deferred(const bool on) noexcept;
 
             EventLoop* owner_loop() noexcept;
             void remove() noexcept;
@@ -52,6 +55,7 @@ namespace clia {
             bool event_handling_;
             bool added_to_loop_;
             bool tied_;
+            bool deferred_;
             std::weak_ptr<void> tie_;
             ReadEventCallback read_callback_;
             EventCallback write_callback_;
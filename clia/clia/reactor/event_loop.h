@@ -2,15 +2,39 @@
 #define CLIA_REACTOR_EVENT_LOOP_H_
 
 #include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
 #include <mutex>
 #include <memory>
 
 #include "clia/base/noncopyable.h"
 #include "clia/reactor/base.h"
+#include "clia/reactor/timer_queue.h"
 #include "clia/util/timestamp.h"
 
 namespace clia {
     namespace reactor {
+        /**
+         * 每个连接每轮的读预算。连接在一轮中读满字节预算或用完时间预算后仍有数据，
+         * 会被放入就绪队列，下一轮不等 epoll 就按轮转顺序继续处理，避免单个大流量连接独占 loop
+         */
+        struct FairnessOptions {
+            std::size_t read_budget_bytes = 0;          // 0 表示不限制字节数
+            std::int64_t time_budget_us = 0;            // 读取加消息回调的耗时，0 表示不限制
+            std::int64_t starvation_threshold_us = 10000;   // 在就绪队列中等待超过该值记为一次饥饿
+            bool enabled() const noexcept { return read_budget_bytes > 0 || time_budget_us > 0; }
+        };
+
+        struct FairnessStats {
+            std::uint64_t deferrals = 0;        // 超预算被放入就绪队列的次数
+            std::uint64_t ready_runs = 0;       // 从就绪队列处理的次数
+            std::uint64_t time_overruns = 0;    // 单次读取加回调就超过时间预算的次数，回调本身无法被打断
+            std::uint64_t starvations = 0;
+            std::int64_t max_ready_wait_us = 0;
+            std::size_t max_ready_size = 0;
+        };
+
         class EventLoop final : Noncopyable {
         public:
             EventLoop();
@@ -27,11 +51,27 @@ namespace clia {
             void wakeup();
             // 判断eventloop对象是否在自己的线程
             bool is_in_loop_thread() const;
+        public:
+            // 定时器，线程安全；时间单位为秒
+            TimerId run_at(const clia::util::Timestamp time, Functor cb);
+            TimerId run_after(const double delay_sec, Functor cb);
+            TimerId run_every(const double interval_sec, Functor cb);
+            void cancel(const TimerId timer_id);
         public:
             void remove_channel(Channel *channel);
             void update_channel(Channel *channel);
             bool has_channel(Channel *channel) const;
+        public:
+            // 只能在 loop 线程或 loop() 开始之前调用
+            void set_fairness(const FairnessOptions &options) noexcept;
+            const FairnessOptions& fairness() const noexcept;
+            // 只能在 loop 线程中读取
+            const FairnessStats& fairness_stats() const noexcept;
+            // 超出预算的 channel 放入就绪队列，下一轮以 EPOLLIN 重新分发
+            void defer_channel(Channel *channel);
+            void record_time_overrun() noexcept;
         private:
+            void run_ready_channels();
             // 给eventfd返回的文件描述符wakeup绑定的事件回调，唤醒epoll_wait
             void handle_read();
             // 执行上层回调
@@ -46,10 +86,15 @@ namespace clia {
             Channel *current_active_channel_;
             clia::util::Timestamp poll_return_time_;
             std::unique_ptr<clia::reactor::Epoller> poller_;
+            std::unique_ptr<TimerQueue> timer_queue_;
             std::unique_ptr<Channel> wakeup_channel_;
             ChannelList active_channels_;
             std::vector<Functor> pending_functors_;     // 存储loop需要执行的所有回调操作
             std::mutex mutex_;
+            FairnessOptions fairness_;
+            FairnessStats fairness_stats_;
+            std::deque<std::pair<Channel*, clia::util::Timestamp>> ready_channels_;
+            std::size_t ready_count_;   // 本轮要处理的就绪队列前缀，即之前各轮留下的 channel 数
         };
     }
 }
@@ -0,0 +1,86 @@
+#ifndef CLIA_REACTOR_TIMER_QUEUE_H_
+#define CLIA_REACTOR_TIMER_QUEUE_H_
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <set>
+#include <utility>
+#include <vector>
+
+#include "clia/base/copyable.h"
+#include "clia/base/noncopyable.h"
+#include "clia/reactor/base.h"
+#include "clia/util/timestamp.h"
+
+namespace clia {
+    namespace reactor {
+        class Timer final : Noncopyable {
+        public:
+            Timer(Functor cb, const clia::util::Timestamp when, const double interval_sec) noexcept;
+            ~Timer() noexcept;
+        public:
+            void run() const;
+            clia::util::Timestamp expiration() const noexcept;
+            bool repeat() const noexcept;
+            std::int64_t sequence() const noexcept;
+            void restart(const clia::util::Timestamp now) noexcept;
+        private:
+            const Functor callback_;
+            clia::util::Timestamp expiration_;
+            const double interval_sec_;
+            const bool repeat_;
+            const std::int64_t sequence_;
+            static std::atomic<std::int64_t> kNumCreated;
+        };
+
+        /// 定时器句柄，仅用于取消；定时器到期(非重复)后句柄自动失效
+        class TimerId final : Copyable {
+            friend class TimerQueue;
+        public:
+            TimerId() noexcept : timer_(nullptr), sequence_(0) {}
+            TimerId(Timer *timer, const std::int64_t seq) noexcept : timer_(timer), sequence_(seq) {}
+        public:
+            bool valid() const noexcept { return timer_ != nullptr; }
+        private:
+            Timer *timer_;
+            std::int64_t sequence_;
+        };
+
+        /**
+         * 基于 timerfd 的定时器队列，定时器到期事件与 IO 事件在同一个 loop 中分发。
+         * 所有对 timers_ 的修改都在 loop 线程内完成，因此无需加锁。
+         */
+        class TimerQueue final : Noncopyable {
+        public:
+            explicit TimerQueue(EventLoop *loop);
+            ~TimerQueue();
+        public:
+            // 线程安全，可在任意线程调用
+            TimerId add_timer(Functor cb, const clia::util::Timestamp when, const double interval_sec);
+            void cancel(const TimerId timer_id);
+        private:
+            using Entry = std::pair<clia::util::Timestamp, Timer*>;
+            using TimerList = std::set<Entry>;
+            using ActiveTimer = std::pair<Timer*, std::int64_t>;
+            using ActiveTimerSet = std::set<ActiveTimer>;
+        private:
+            void add_timer_in_loop(Timer *timer);
+            void cancel_in_loop(const TimerId timer_id);
+            void handle_read();
+            std::vector<Entry> get_expired(const clia::util::Timestamp now);
+            void reset(const std::vector<Entry> &expired, const clia::util::Timestamp now);
+            bool insert(Timer *timer);
+        private:
+            EventLoop *const loop_;
+            const int timerfd_;
+            std::unique_ptr<Channel> timerfd_channel_;
+            TimerList timers_;                  // 按到期时间排序
+            ActiveTimerSet active_timers_;      // 按对象地址排序，用于取消
+            bool calling_expired_timers_;
+            ActiveTimerSet canceling_timers_;   // 在回调中被取消的重复定时器
+        };
+    }
+}
+
+#endif
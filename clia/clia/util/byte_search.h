@@ -0,0 +1,33 @@
+#ifndef CLIA_UTIL_BYTE_SEARCH_H_
+#define CLIA_UTIL_BYTE_SEARCH_H_
+
+#include <cstddef>
+
+namespace clia {
+    namespace util {
+        namespace byte_search {
+            enum class Kernel {
+                kScalar,
+                kSse2,
+                kAvx2,
+            };
+
+            /// @brief 进程启动时按 CPU 能力选择的实现(AVX2 > SSE2 > 标量)
+            extern Kernel active_kernel() noexcept;
+            extern const char* kernel_name(const Kernel kernel) noexcept;
+            /// @brief 强制切换实现，主要用于基准测试与对拍
+            /// @return CPU 不支持该实现时返回 false 且不做切换
+            extern bool use_kernel(const Kernel kernel) noexcept;
+
+            /// @brief 以下函数在 [begin, end) 中查找，找不到返回 nullptr
+            extern const unsigned char* find_byte(const unsigned char *begin, const unsigned char *end, const unsigned char c) noexcept;
+            /// @brief 查找 "\r\n"，返回指向 '\r' 的指针
+            extern const unsigned char* find_crlf(const unsigned char *begin, const unsigned char *end) noexcept;
+            /// @brief 查找 set 中任意一个字节，set 不超过 16 字节时走向量化路径
+            extern const unsigned char* find_any_of(const unsigned char *begin, const unsigned char *end,
+                const unsigned char *set, const std::size_t set_len) noexcept;
+        }
+    }
+}
+
+#endif
@@ -1,24 +1,184 @@
-#ifndef CLIA_BASE_MEMORY_POOL_H_
-#define CLIA_BASE_MEMORY_POOL_H_
+#ifndef CLIA_UTIL_MEMORY_POOL_H_
+#define CLIA_UTIL_MEMORY_POOL_H_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <vector>
+
+#include "clia/base/noncopyable.h"
 
 namespace clia {
     namespace util {
-        template <int Nm, int Sz>
-        class MemoryPool {
+        /**
+         * 定长块的 slab 池，每个线程各持有一个，只有所属线程从中分配。
+         * 所属线程释放时直接挂回本地空闲链表；其他线程释放(如 base loop 分配、io loop 销毁的连接)
+         * 压入无锁的远端释放栈，所属线程本地链表用空时一次性取回。
+         * 所属线程退出时调用 release 放弃所有权，池在最后一个块归还后销毁，仍存活在其他线程的块不会悬空
+         */
+        class SlabPool : Noncopyable {
+        public:
+            static constexpr std::size_t kAlignment = 16;
+        public:
+            struct Stats {
+                std::uint64_t hits = 0;         // 由空闲链表直接满足的分配
+                std::uint64_t misses = 0;       // 空闲链表为空、需要新建 slab 的分配
+                std::uint64_t remote_frees = 0; // 其他线程归还的块
+                std::uint64_t slabs = 0;
+                std::uint64_t bytes = 0;        // slab 占用的总字节数
+            };
         public:
-            MemoryPool();
-            ~MemoryPool();
+            SlabPool(const char *name, const std::size_t block_size, const std::size_t blocks_per_slab);
+        private:
+            // 由 release 或最后一次 deallocate 销毁
+            ~SlabPool() noexcept;
+        public:
+            // 只能在创建该池的线程调用
+            void* allocate();
+            // 任意线程可调用，根据块头找到所属的池
+            static void deallocate(void *ptr) noexcept;
+            // 所属线程退出时调用，之后不能再 allocate；没有未归还的块时立即销毁
+            void release() noexcept;
+
+            const char* name() const noexcept;
+            std::size_t block_size() const noexcept;
+            Stats stats() const noexcept;
+            // 汇总所有线程中同名池的统计
+            static Stats aggregate(const char *name);
+        private:
+            // 块头，空闲时通过 next 串成链表，分配出去后 owner 用于找回所属的池
+            struct alignas(kAlignment) Header {
+                SlabPool *owner;
+                Header *next;
+            };
+        private:
+            void add_slab();
+            void push_remote(Header *header) noexcept;
+            void unref() noexcept;
+        private:
+            const char *const name_;
+            const std::size_t block_size_;
+            const std::size_t stride_;
+            const std::size_t blocks_per_slab_;
+            std::atomic<int> owner_tid_;        // release 后为 0，之后的归还都走远端释放栈
+            Header *free_list_;
+            std::atomic<Header*> remote_free_;
+            std::atomic<std::size_t> refs_;     // 未归还的块数，所属线程存活期间另加 1
+            std::vector<unsigned char*> slabs_;
+            // 计数只由所属线程写入(remote_frees 除外)，原子变量保证其他线程读取统计时不产生数据竞争
+            std::atomic<std::uint64_t> hits_;
+            std::atomic<std::uint64_t> misses_;
+            std::atomic<std::uint64_t> remote_frees_;
+        };
+
+        // 线程局部的池指针，线程退出时释放池的所有权
+        struct LocalSlabPool {
+            SlabPool *pool = nullptr;
 
-            void* allocate() {
-                // Allocate memory from the pool
-                return nullptr; // Placeholder
+            ~LocalSlabPool() {
+                if (pool != nullptr) {
+                    pool->release();
+                }
             }
+        };
 
-            void deallocate(void* ptr) {
-                // Deallocate memory back to the pool
+        // 当前线程中 Tag 标记的、块大小为 Size 的池
+        template <typename Tag, std::size_t Size>
+        SlabPool* local_slab_pool() {
+            static thread_local LocalSlabPool local;
+            if (nullptr == local.pool) {
+                local.pool = new SlabPool(Tag::name(), Size, Tag::kBlocksPerSlab);
             }
-        }; 
+            return local.pool;
+        }
+
+        /**
+         * 单对象分配走 slab 的 allocator，配合 std::allocate_shared 让对象与控制块只做一次分配。
+         * Tag 提供 name() 与 kBlocksPerSlab，rebind 后同一个 Tag 的池按名字汇总统计
+         */
+        template <typename T, typename Tag>
+        class PoolAllocator {
+        public:
+            using value_type = T;
+            template <typename U>
+            struct rebind {
+                using other = PoolAllocator<U, Tag>;
+            };
+        public:
+            PoolAllocator() noexcept = default;
+            template <typename U>
+            PoolAllocator(const PoolAllocator<U, Tag>&) noexcept {}
+        public:
+            T* allocate(const std::size_t n) {
+                if (1 == n && alignof(T) <= SlabPool::kAlignment) {
+                    return static_cast<T*>(local_slab_pool<Tag, sizeof(T)>()->allocate());
+                }
+                return static_cast<T*>(::operator new(n * sizeof(T)));
+            }
+
+            void deallocate(T *ptr, const std::size_t n) noexcept {
+                if (1 == n && alignof(T) <= SlabPool::kAlignment) {
+                    SlabPool::deallocate(ptr);
+                } else {
+                    ::operator delete(ptr);
+                }
+            }
+        };
+
+        template <typename T, typename U, typename Tag>
+        bool operator==(const PoolAllocator<T, Tag>&, const PoolAllocator<U, Tag>&) noexcept {
+            return true;
+        }
+
+        template <typename T, typename U, typename Tag>
+        bool operator!=(const PoolAllocator<T, Tag>&, const PoolAllocator<U, Tag>&) noexcept {
+            return false;
+        }
+
+        /**
+         * 只池化长度恰为 Bytes 的数组分配，其余交给 operator new。
+         * 用于 std::vector 的初始存储：扩容产生的其他尺寸不进池
+         */
+        template <typename T, typename Tag, std::size_t Bytes>
+        class SizeClassAllocator {
+        public:
+            using value_type = T;
+            template <typename U>
+            struct rebind {
+                using other = SizeClassAllocator<U, Tag, Bytes>;
+            };
+        public:
+            SizeClassAllocator() noexcept = default;
+            template <typename U>
+            SizeClassAllocator(const SizeClassAllocator<U, Tag, Bytes>&) noexcept {}
+        public:
+            T* allocate(const std::size_t n) {
+                if (n * sizeof(T) == Bytes && alignof(T) <= SlabPool::kAlignment) {
+                    return static_cast<T*>(local_slab_pool<Tag, Bytes>()->allocate());
+                }
+                return static_cast<T*>(::operator new(n * sizeof(T)));
+            }
+
+            void deallocate(T *ptr, const std::size_t n) noexcept {
+                if (n * sizeof(T) == Bytes && alignof(T) <= SlabPool::kAlignment) {
+                    SlabPool::deallocate(ptr);
+                } else {
+                    ::operator delete(ptr);
+                }
+            }
+        };
+
+        template <typename T, typename U, typename Tag, std::size_t Bytes>
+        bool operator==(const SizeClassAllocator<T, Tag, Bytes>&, const SizeClassAllocator<U, Tag, Bytes>&) noexcept {
+            return true;
+        }
+
+        template <typename T, typename U, typename Tag, std::size_t Bytes>
+        bool operator!=(const SizeClassAllocator<T, Tag, Bytes>&, const SizeClassAllocator<U, Tag, Bytes>&) noexcept {
+            return false;
+        }
     }
 }
 
-#endif
\ No newline at end of file
+#endif
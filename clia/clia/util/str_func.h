@@ -1,40 +1,154 @@
 #ifndef CLIA_UTIL_STR_FUNC_H_
 #define CLIA_UTIL_STR_FUNC_H_
 
-#include <algorithm>
 #include <cassert>
 #include <cstddef>
+#include <cstdint>
 #include <cstdlib>
+#include <cstring>
+#include <type_traits>
 
 namespace clia {
     namespace util {
         namespace str_func {
+            // 十六进制输出的包装，FixedOStream << hex(value)
+            struct Hex {
+                std::uint64_t value;
+            };
+
+            template <typename Integral>
+            inline Hex hex(const Integral value) noexcept;
+
+            // 以下 convert 系列函数在 size < 32 时不写入并返回 0，否则写入结果与结尾的 '\0'，返回不含 '\0' 的长度
+
+            // 十进制整数，查表每次输出两位
             template<typename Integral>
             inline std::size_t convert(char *outbuf, const int size, const Integral value) noexcept;
+            // 能够精确还原原值的最短十进制表示(Grisu2)，如 0.1、3.25、1e+100；nan 与 inf 同 printf
+            extern std::size_t convert(char *outbuf, const int size, const double value) noexcept;
+            extern std::size_t convert(char *outbuf, const int size, const float value) noexcept;
+            // 小写十六进制，不带前缀
+            inline std::size_t convert_hex(char *outbuf, const int size, const std::uint64_t value) noexcept;
+            // "0x" 加小写十六进制
+            inline std::size_t convert_pointer(char *outbuf, const int size, const void *ptr) noexcept;
+
+            // "00" 到 "99" 依次排列的两位数字表
+            inline const char* digit_pairs() noexcept;
+            // 写入 value (< 100) 的两位数字，不足两位补 0
+            inline void write_2digits(char *out, const unsigned value) noexcept;
+            // 写入无符号整数的十进制表示，out 至少要有 20 字节，不写 '\0'，返回长度
+            inline std::size_t write_unsigned(char *out, std::uint64_t value) noexcept;
+            // 写入小写十六进制，out 至少要有 16 字节，不写 '\0'，返回长度
+            inline std::size_t write_hex(char *out, const std::uint64_t value) noexcept;
+
+            // str 开头一个合法 UTF-8 字符的字节数(1-4)；不完整、过长编码、代理区或超出 U+10FFFF 时返回 0
+            extern std::size_t utf8_char_length(const char *str, const std::size_t len) noexcept;
+            // 去掉 str 前 len 字节末尾不完整的多字节字符后的长度，用于截断时不把字符从中间截开
+            extern std::size_t utf8_truncate(const char *str, const std::size_t len) noexcept;
         }
     }
 }
 
+template <typename Integral>
+inline clia::util::str_func::Hex clia::util::str_func::hex(const Integral value) noexcept {
+    static_assert(std::is_integral<Integral>::value, "T must be an integral type");
+    return Hex{static_cast<std::uint64_t>(static_cast<typename std::make_unsigned<Integral>::type>(value))};
+}
+
+inline const char* clia::util::str_func::digit_pairs() noexcept {
+    static constexpr char kPairs[] =
+        "00010203040506070809101112131415161718192021222324252627282930313233343536373839"
+        "40414243444546474849505152535455565758596061626364656667686970717273747576777879"
+        "8081828384858687888990919293949596979899";
+    return kPairs;
+}
+
+inline void clia::util::str_func::write_2digits(char *out, const unsigned value) noexcept {
+    assert(value < 100);
+    std::memcpy(out, digit_pairs() + value * 2, 2);
+}
+
+inline std::size_t clia::util::str_func::write_unsigned(char *out, std::uint64_t value) noexcept {
+    std::size_t len = 1;
+    for (std::uint64_t v = value; ; v /= 10000, len += 4) {
+        if (v < 10) {
+            break;
+        } else if (v < 100) {
+            len += 1;
+            break;
+        } else if (v < 1000) {
+            len += 2;
+            break;
+        } else if (v < 10000) {
+            len += 3;
+            break;
+        }
+    }
+    // 从低位向高位每次写两位
+    char *p = out + len;
+    while (value >= 100) {
+        const unsigned i = static_cast<unsigned>(value % 100);
+        value /= 100;
+        p -= 2;
+        write_2digits(p, i);
+    }
+    if (value >= 10) {
+        write_2digits(p - 2, static_cast<unsigned>(value));
+    } else {
+        *--p = static_cast<char>('0' + value);
+    }
+    return len;
+}
+
 template <typename Integer>
 inline std::size_t clia::util::str_func::convert(char *outbuf, const int size, const Integer value) noexcept {
     if (size < 32) {
         return 0; // Not enough space to convert
     }
     static_assert(std::is_integral<Integer>::value, "T must be an integral type");
-    constexpr char kDigits[] = "0123456789";
-    char* p = outbuf;
-    Integer i = value;
-    do {
-        const int lsd = static_cast<int>(i % 10);
-        *p++ = kDigits[lsd];
-        i /= 10;
-    } while (i != 0);
+    using Unsigned = typename std::make_unsigned<Integer>::type;
+    char *p = outbuf;
+    Unsigned magnitude = static_cast<Unsigned>(value);
     if (value < 0) {
         *p++ = '-';
+        // 取反在无符号类型上进行，最小负数也不会溢出
+        magnitude = static_cast<Unsigned>(Unsigned(0) - magnitude);
     }
+    p += write_unsigned(p, magnitude);
     *p = '\0';
-    std::reverse(outbuf, p);
     return p - outbuf;
 }
 
-#endif
\ No newline at end of file
+inline std::size_t clia::util::str_func::write_hex(char *out, const std::uint64_t value) noexcept {
+    constexpr char kHexDigits[] = "0123456789abcdef";
+    std::size_t len = 1;
+    while (len < 16 && (value >> (len * 4)) != 0) {
+        ++len;
+    }
+    for (std::size_t i = 0; i < len; ++i) {
+        out[len - 1 - i] = kHexDigits[(value >> (i * 4)) & 0xf];
+    }
+    return len;
+}
+
+inline std::size_t clia::util::str_func::convert_hex(char *outbuf, const int size, const std::uint64_t value) noexcept {
+    if (size < 32) {
+        return 0;
+    }
+    const std::size_t len = write_hex(outbuf, value);
+    outbuf[len] = '\0';
+    return len;
+}
+
+inline std::size_t clia::util::str_func::convert_pointer(char *outbuf, const int size, const void *ptr) noexcept {
+    if (size < 32) {
+        return 0;
+    }
+    outbuf[0] = '0';
+    outbuf[1] = 'x';
+    const std::size_t len = 2 + write_hex(outbuf + 2, reinterpret_cast<std::uintptr_t>(ptr));
+    outbuf[len] = '\0';
+    return len;
+}
+
+#endif
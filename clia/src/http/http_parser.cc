@@ -0,0 +1,423 @@
+#include <cassert>
+#include <cstring>
+
+#include "clia/http/http_parser.h"
+#include "clia/net/buffer.h"
+#include "clia/util/byte_search.h"
+
+namespace {
+    constexpr std::size_t kCRLFLen = 2;
+    constexpr std::size_t kHeadEndLen = 4;
+    constexpr std::size_t kMaxChunkLine = 1024;
+
+    inline const char* find_crlf(const char *begin, const char *end) noexcept {
+        return reinterpret_cast<const char*>(clia::util::byte_search::find_crlf(
+            reinterpret_cast<const unsigned char*>(begin), reinterpret_cast<const unsigned char*>(end)));
+    }
+
+    // 查找 "\r\n\r\n"，返回指向第一个 '\r' 的指针
+    inline const char* find_head_end(const char *begin, const char *end) noexcept {
+        const char *p = begin;
+        while ((p = ::find_crlf(p, end)) != nullptr) {
+            if (end - p < static_cast<std::ptrdiff_t>(kHeadEndLen)) {
+                return nullptr;
+            }
+            if ('\r' == p[2] && '\n' == p[3]) {
+                return p;
+            }
+            p += kCRLFLen;
+        }
+        return nullptr;
+    }
+
+    inline bool is_token_char(const char c) noexcept {
+        return c > 0x20 && c < 0x7f && c != ':' && c != '(' && c != ')' && c != ','
+            && c != '/' && c != ';' && c != '<' && c != '=' && c != '>' && c != '?'
+            && c != '@' && c != '[' && c != '\\' && c != ']' && c != '{' && c != '}' && c != '"';
+    }
+
+    inline int hex_value(const char c) noexcept {
+        if (c >= '0' && c <= '9') return c - '0';
+        if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+        if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+        return -1;
+    }
+
+    // 逗号分隔的 token 列表中是否包含 token，如 "Connection: keep-alive, Upgrade"
+    inline bool has_token(const clia::StringView &list, const clia::StringView &token) noexcept {
+        const char *p = list.begin();
+        const char *end = list.end();
+        while (p < end) {
+            while (p < end && (*p == ' ' || *p == '\t' || *p == ',')) {
+                ++p;
+            }
+            const char *q = p;
+            while (q < end && *q != ',') {
+                ++q;
+            }
+            const char *e = q;
+            while (e > p && (e[-1] == ' ' || e[-1] == '\t')) {
+                --e;
+            }
+            if (clia::StringView(p, e - p).iequals(token)) {
+                return true;
+            }
+            p = q;
+        }
+        return false;
+    }
+
+    clia::http::Method to_method(const clia::StringView &str) noexcept {
+        switch (str.size()) {
+        case 3:
+            if (str == "GET") return clia::http::Method::kGet;
+            if (str == "PUT") return clia::http::Method::kPut;
+            break;
+        case 4:
+            if (str == "HEAD") return clia::http::Method::kHead;
+            if (str == "POST") return clia::http::Method::kPost;
+            break;
+        case 5:
+            if (str == "PATCH") return clia::http::Method::kPatch;
+            break;
+        case 6:
+            if (str == "DELETE") return clia::http::Method::kDelete;
+            break;
+        case 7:
+            if (str == "OPTIONS") return clia::http::Method::kOptions;
+            break;
+        default:
+            break;
+        }
+        return clia::http::Method::kInvalid;
+    }
+}
+
+clia::http::HttpParser::HttpParser() noexcept {
+    this->reset();
+}
+
+clia::http::HttpParser::~HttpParser() noexcept = default;
+
+const clia::http::HttpRequest& clia::http::HttpParser::request() const noexcept {
+    return request_;
+}
+
+std::size_t clia::http::HttpParser::consumed() const noexcept {
+    return consumed_;
+}
+
+int clia::http::HttpParser::error_status() const noexcept {
+    return error_status_;
+}
+
+void clia::http::HttpParser::reset() noexcept {
+    state_ = State::kHead;
+    scan_ = 0;
+    body_begin_ = 0;
+    body_end_ = 0;
+    content_length_ = 0;
+    chunk_remain_ = 0;
+    consumed_ = 0;
+    error_status_ = 0;
+    request_.reset();
+}
+
+clia::http::HttpParser::Result clia::http::HttpParser::parse(clia::net::Buffer *buf) noexcept {
+    if (State::kError == state_) {
+        return Result::kError;
+    }
+    if (State::kComplete == state_) {
+        return Result::kComplete;
+    }
+    const char *base = reinterpret_cast<const char*>(buf->peek());
+    const std::size_t readable = buf->readable_bytes();
+
+    if (State::kHead == state_) {
+        // 跳过请求之间多余的空行(RFC 7230 3.5)
+        if (0 == scan_) {
+            std::size_t skip = 0;
+            while (skip + 1 < readable && base[skip] == '\r' && base[skip + 1] == '\n') {
+                skip += 2;
+            }
+            if (skip > 0) {
+                buf->retrieve(skip);
+                return this->parse(buf);
+            }
+        }
+        const char *pos = ::find_head_end(base + scan_, base + readable);
+        if (nullptr == pos) {
+            if (readable > kMaxHeaderBytes) {
+                return this->fail(431);
+            }
+            // 下次从可能跨越边界的位置继续扫描
+            scan_ = readable >= 3 ? readable - 3 : 0;
+            return Result::kIncomplete;
+        }
+        const std::size_t head_len = pos - base + ::kHeadEndLen;
+        if (head_len > kMaxHeaderBytes) {
+            return this->fail(431);
+        }
+        if (!this->parse_head(base, head_len)) {
+            return this->fail(0 == error_status_ ? 400 : error_status_);
+        }
+        body_begin_ = head_len;
+        body_end_ = head_len;
+        scan_ = head_len;
+        if (request_.chunked_) {
+            state_ = State::kChunkSize;
+        } else if (content_length_ > 0) {
+            state_ = State::kBody;
+        } else {
+            consumed_ = head_len;
+            state_ = State::kComplete;
+        }
+    }
+
+    if (State::kBody == state_) {
+        if (readable < body_begin_ + content_length_) {
+            return Result::kIncomplete;
+        }
+        request_.body_.off = static_cast<std::uint32_t>(body_begin_);
+        request_.body_.len = static_cast<std::uint32_t>(content_length_);
+        consumed_ = body_begin_ + content_length_;
+        state_ = State::kComplete;
+    } else if (State::kComplete != state_) {
+        const auto result = this->parse_chunked(buf);
+        if (result != Result::kComplete) {
+            return result;
+        }
+    }
+
+    assert(State::kComplete == state_);
+    request_.base_ = reinterpret_cast<const char*>(buf->peek());
+    return Result::kComplete;
+}
+
+clia::http::HttpParser::Result clia::http::HttpParser::parse_chunked(clia::net::Buffer *buf) noexcept {
+    char *base = reinterpret_cast<char*>(buf->peek());
+    const std::size_t readable = buf->readable_bytes();
+    while (true) {
+        switch (state_) {
+        case State::kChunkSize: {
+            const char *eol = ::find_crlf(base + scan_, base + readable);
+            if (nullptr == eol) {
+                return readable - scan_ > ::kMaxChunkLine ? this->fail(400) : Result::kIncomplete;
+            }
+            const char *p = base + scan_;
+            std::size_t size = 0;
+            int digits = 0;
+            for (; p < eol; ++p) {
+                const int v = ::hex_value(*p);
+                if (v < 0) {
+                    break;
+                }
+                if (++digits > 16) {
+                    return this->fail(413);
+                }
+                size = (size << 4) | static_cast<std::size_t>(v);
+            }
+            // 允许 chunk 扩展(;name=value)，内容直接忽略
+            if (0 == digits || (p < eol && *p != ';' && *p != ' ' && *p != '\t')) {
+                return this->fail(400);
+            }
+            if (size > kMaxBodyBytes || body_end_ - body_begin_ + size > kMaxBodyBytes) {
+                return this->fail(413);
+            }
+            scan_ = eol - base + ::kCRLFLen;
+            if (0 == size) {
+                state_ = State::kTrailer;
+            } else {
+                chunk_remain_ = size;
+                state_ = State::kChunkData;
+            }
+            break;
+        }
+        case State::kChunkData: {
+            // 把分块数据前移，与之前的分块拼接成连续的请求体
+            const std::size_t avail = readable - scan_;
+            const std::size_t n = avail < chunk_remain_ ? avail : chunk_remain_;
+            if (n > 0 && body_end_ != scan_) {
+                std::memmove(base + body_end_, base + scan_, n);
+            }
+            body_end_ += n;
+            scan_ += n;
+            chunk_remain_ -= n;
+            if (chunk_remain_ > 0) {
+                return Result::kIncomplete;
+            }
+            state_ = State::kChunkDataEnd;
+            break;
+        }
+        case State::kChunkDataEnd:
+            if (readable - scan_ < 2) {
+                return Result::kIncomplete;
+            }
+            if (base[scan_] != '\r' || base[scan_ + 1] != '\n') {
+                return this->fail(400);
+            }
+            scan_ += 2;
+            state_ = State::kChunkSize;
+            break;
+        case State::kTrailer: {
+            const char *eol = ::find_crlf(base + scan_, base + readable);
+            if (nullptr == eol) {
+                return readable - scan_ > kMaxHeaderBytes ? this->fail(431) : Result::kIncomplete;
+            }
+            const std::size_t line_begin = scan_;
+            scan_ = eol - base + ::kCRLFLen;
+            if (static_cast<std::size_t>(eol - base) == line_begin) {
+                request_.body_.off = static_cast<std::uint32_t>(body_begin_);
+                request_.body_.len = static_cast<std::uint32_t>(body_end_ - body_begin_);
+                consumed_ = scan_;
+                state_ = State::kComplete;
+                return Result::kComplete;
+            }
+            break;
+        }
+        default:
+            assert(false);
+            return this->fail(500);
+        }
+    }
+}
+
+bool clia::http::HttpParser::parse_head(const char *base, const std::size_t head_len) noexcept {
+    const char *p = base;
+    // head 以空行结尾，最后 2 字节不参与逐行解析
+    const char *end = base + head_len - 2;
+    const char *eol = ::find_crlf(p, end);
+    assert(eol != nullptr);
+    if (!this->parse_request_line(base, p, eol)) {
+        return false;
+    }
+
+    bool has_length = false;
+    bool close = false;
+    bool keep_alive = false;
+    p = eol + ::kCRLFLen;
+    while (p < end) {
+        eol = ::find_crlf(p, end);
+        assert(eol != nullptr);
+        if (!this->parse_header_line(base, p, eol)) {
+            return false;
+        }
+        const int i = request_.header_count_ - 1;
+        const clia::StringView name = clia::StringView(base + request_.header_names_[i].off, request_.header_names_[i].len);
+        const clia::StringView value = clia::StringView(base + request_.header_values_[i].off, request_.header_values_[i].len);
+        if (name.iequals("Content-Length")) {
+            if (has_length || value.empty()) {
+                return false;
+            }
+            std::size_t len = 0;
+            for (const char c : value) {
+                if (c < '0' || c > '9') {
+                    return false;
+                }
+                len = len * 10 + (c - '0');
+                if (len > kMaxBodyBytes) {
+                    error_status_ = 413;
+                    return false;
+                }
+            }
+            content_length_ = len;
+            has_length = true;
+        } else if (name.iequals("Transfer-Encoding")) {
+            if (!::has_token(value, "chunked")) {
+                error_status_ = 501;
+                return false;
+            }
+            request_.chunked_ = true;
+        } else if (name.iequals("Connection")) {
+            close = close || ::has_token(value, "close");
+            keep_alive = keep_alive || ::has_token(value, "keep-alive");
+        }
+        p = eol + ::kCRLFLen;
+    }
+    // 同时出现两者时存在请求走私风险，直接拒绝
+    if (has_length && request_.chunked_) {
+        return false;
+    }
+    if (Version::kHttp11 == request_.version_) {
+        request_.keep_alive_ = !close;
+    } else {
+        request_.keep_alive_ = keep_alive && !close;
+    }
+    return true;
+}
+
+bool clia::http::HttpParser::parse_request_line(const char *base, const char *begin, const char *end) noexcept {
+    const char *sp1 = static_cast<const char*>(std::memchr(begin, ' ', end - begin));
+    if (nullptr == sp1 || sp1 == begin) {
+        return false;
+    }
+    const char *target = sp1 + 1;
+    const char *sp2 = static_cast<const char*>(std::memchr(target, ' ', end - target));
+    if (nullptr == sp2 || sp2 == target) {
+        return false;
+    }
+    const clia::StringView method(begin, sp1 - begin);
+    request_.method_ = ::to_method(method);
+    if (Method::kInvalid == request_.method_) {
+        error_status_ = 501;
+        return false;
+    }
+    const clia::StringView version(sp2 + 1, end - sp2 - 1);
+    if (version == "HTTP/1.1") {
+        request_.version_ = Version::kHttp11;
+    } else if (version == "HTTP/1.0") {
+        request_.version_ = Version::kHttp10;
+    } else {
+        error_status_ = 505;
+        return false;
+    }
+    request_.method_str_.off = 0;
+    request_.method_str_.len = static_cast<std::uint32_t>(sp1 - begin);
+    request_.target_.off = static_cast<std::uint32_t>(target - base);
+    request_.target_.len = static_cast<std::uint32_t>(sp2 - target);
+    const char *question = static_cast<const char*>(std::memchr(target, '?', sp2 - target));
+    request_.path_.off = request_.target_.off;
+    if (question != nullptr) {
+        request_.path_.len = static_cast<std::uint32_t>(question - target);
+        request_.query_.off = static_cast<std::uint32_t>(question + 1 - base);
+        request_.query_.len = static_cast<std::uint32_t>(sp2 - question - 1);
+    } else {
+        request_.path_.len = request_.target_.len;
+    }
+    return true;
+}
+
+bool clia::http::HttpParser::parse_header_line(const char *base, const char *begin, const char *end) noexcept {
+    if (request_.header_count_ >= HttpRequest::kMaxHeaders) {
+        error_status_ = 431;
+        return false;
+    }
+    const char *colon = begin;
+    while (colon < end && ::is_token_char(*colon)) {
+        ++colon;
+    }
+    // 名字为空、含非法字符或使用已废弃的折行(obs-fold)
+    if (colon == begin || colon == end || *colon != ':') {
+        return false;
+    }
+    const char *value = colon + 1;
+    while (value < end && (*value == ' ' || *value == '\t')) {
+        ++value;
+    }
+    const char *value_end = end;
+    while (value_end > value && (value_end[-1] == ' ' || value_end[-1] == '\t')) {
+        --value_end;
+    }
+    const int i = request_.header_count_++;
+    request_.header_names_[i].off = static_cast<std::uint32_t>(begin - base);
+    request_.header_names_[i].len = static_cast<std::uint32_t>(colon - begin);
+    request_.header_values_[i].off = static_cast<std::uint32_t>(value - base);
+    request_.header_values_[i].len = static_cast<std::uint32_t>(value_end - value);
+    return true;
+}
+
+clia::http::HttpParser::Result clia::http::HttpParser::fail(const int status) noexcept {
+    state_ = State::kError;
+    error_status_ = status;
+    return Result::kError;
+}
@@ -0,0 +1,108 @@
+#include <cstring>
+
+#include "clia/http/http_request.h"
+
+const char* clia::http::method_to_string(const Method method) noexcept {
+    switch (method) {
+    case Method::kGet:
+        return "GET";
+    case Method::kHead:
+        return "HEAD";
+    case Method::kPost:
+        return "POST";
+    case Method::kPut:
+        return "PUT";
+    case Method::kDelete:
+        return "DELETE";
+    case Method::kOptions:
+        return "OPTIONS";
+    case Method::kPatch:
+        return "PATCH";
+    default:
+        return "INVALID";
+    }
+}
+
+clia::http::HttpRequest::HttpRequest() noexcept {
+    this->reset();
+}
+
+clia::http::HttpRequest::~HttpRequest() noexcept = default;
+
+clia::http::Method clia::http::HttpRequest::method() const noexcept {
+    return method_;
+}
+
+clia::http::Version clia::http::HttpRequest::version() const noexcept {
+    return version_;
+}
+
+clia::StringView clia::http::HttpRequest::method_str() const noexcept {
+    return this->view(method_str_);
+}
+
+clia::StringView clia::http::HttpRequest::target() const noexcept {
+    return this->view(target_);
+}
+
+clia::StringView clia::http::HttpRequest::path() const noexcept {
+    return this->view(path_);
+}
+
+clia::StringView clia::http::HttpRequest::query() const noexcept {
+    return this->view(query_);
+}
+
+clia::StringView clia::http::HttpRequest::body() const noexcept {
+    return this->view(body_);
+}
+
+int clia::http::HttpRequest::header_count() const noexcept {
+    return header_count_;
+}
+
+clia::StringView clia::http::HttpRequest::header_name(const int i) const noexcept {
+    return (i >= 0 && i < header_count_) ? this->view(header_names_[i]) : clia::StringView();
+}
+
+clia::StringView clia::http::HttpRequest::header_value(const int i) const noexcept {
+    return (i >= 0 && i < header_count_) ? this->view(header_values_[i]) : clia::StringView();
+}
+
+clia::StringView clia::http::HttpRequest::header(const clia::StringView &name) const noexcept {
+    for (int i = 0; i < header_count_; ++i) {
+        if (this->view(header_names_[i]).iequals(name)) {
+            return this->view(header_values_[i]);
+        }
+    }
+    return clia::StringView();
+}
+
+bool clia::http::HttpRequest::keep_alive() const noexcept {
+    return keep_alive_;
+}
+
+bool clia::http::HttpRequest::chunked() const noexcept {
+    return chunked_;
+}
+
+clia::StringView clia::http::HttpRequest::view(const Slice &slice) const noexcept {
+    if (nullptr == base_ || 0 == slice.len) {
+        return clia::StringView();
+    }
+    return clia::StringView(base_ + slice.off, slice.len);
+}
+
+void clia::http::HttpRequest::reset() noexcept {
+    base_ = nullptr;
+    method_ = Method::kInvalid;
+    version_ = Version::kUnknown;
+    keep_alive_ = false;
+    chunked_ = false;
+    std::memset(&method_str_, 0, sizeof(method_str_));
+    std::memset(&target_, 0, sizeof(target_));
+    std::memset(&path_, 0, sizeof(path_));
+    std::memset(&query_, 0, sizeof(query_));
+    std::memset(&body_, 0, sizeof(body_));
+    header_count_ = 0;
+}
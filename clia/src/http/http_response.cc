@@ -0,0 +1,228 @@
+#include <cassert>
+#include <cstring>
+#include <ctime>
+
+#include "clia/http/http_response.h"
+#include "clia/net/buffer.h"
+#include "clia/util/str_func.h"
+
+namespace {
+    constexpr char kCRLF[] = "\r\n";
+    // 每个 loop 线程各自缓存一份 Date 头，秒数变化时才重新格式化
+    thread_local std::time_t kDateSec = 0;
+    thread_local char kDateBuf[64] = {0};
+    thread_local std::size_t kDateLen = 0;
+
+    inline std::size_t format_hex(char *outbuf, std::size_t value) noexcept {
+        constexpr char kHex[] = "0123456789abcdef";
+        char tmp[2 * sizeof(std::size_t)];
+        std::size_t n = 0;
+        do {
+            tmp[n++] = kHex[value & 0xf];
+            value >>= 4;
+        } while (value != 0);
+        for (std::size_t i = 0; i < n; ++i) {
+            outbuf[i] = tmp[n - 1 - i];
+        }
+        return n;
+    }
+}
+
+clia::http::HttpResponse::HttpResponse(clia::net::Buffer *output, const Version version, const bool close_connection, const bool head_only) noexcept
+    : output_(output)
+    , version_(version)
+    , head_only_(head_only)
+    , close_connection_(close_connection)
+    , head_written_(false)
+    , chunked_(false)
+    , finished_(false)
+    , status_(200)
+{
+    assert(output_ != nullptr);
+}
+
+clia::http::HttpResponse::~HttpResponse() noexcept = default;
+
+void clia::http::HttpResponse::set_status(const int code, const clia::StringView &reason) noexcept {
+    assert(!head_written_);
+    status_ = code;
+    reason_ = reason;
+}
+
+void clia::http::HttpResponse::set_close_connection(const bool on) noexcept {
+    assert(!head_written_);
+    close_connection_ = on;
+}
+
+bool clia::http::HttpResponse::close_connection() const noexcept {
+    return close_connection_;
+}
+
+void clia::http::HttpResponse::add_header(const clia::StringView &name, const clia::StringView &value) {
+    assert(!finished_);
+    if (!head_written_) {
+        this->write_head();
+    }
+    this->append(name);
+    this->append(": ");
+    this->append(value);
+    this->append(::kCRLF);
+}
+
+void clia::http::HttpResponse::set_content_type(const clia::StringView &type) {
+    this->add_header("Content-Type", type);
+}
+
+void clia::http::HttpResponse::set_body(const void *data, const std::size_t len) {
+    assert(!finished_ && !chunked_);
+    if (!head_written_) {
+        this->write_head();
+    }
+    char buf[64];
+    constexpr char kContentLength[] = "Content-Length: ";
+    std::memcpy(buf, kContentLength, sizeof(kContentLength) - 1);
+    std::size_t n = sizeof(kContentLength) - 1;
+    n += clia::util::str_func::convert(buf + n, static_cast<int>(sizeof(buf) - n), len);
+    buf[n++] = '\r';
+    buf[n++] = '\n';
+    output_->append(buf, n);
+    if (close_connection_) {
+        this->append("Connection: close\r\n");
+    } else if (Version::kHttp10 == version_) {
+        this->append("Connection: keep-alive\r\n");
+    }
+    this->append(::kCRLF);
+    if (len > 0 && !head_only_) {
+        output_->append(data, len);
+    }
+    finished_ = true;
+}
+
+void clia::http::HttpResponse::set_body(const clia::StringView &body) {
+    this->set_body(body.data(), body.size());
+}
+
+void clia::http::HttpResponse::begin_chunked() {
+    assert(!finished_ && !chunked_);
+    if (!head_written_) {
+        this->write_head();
+    }
+    chunked_ = true;
+    if (Version::kHttp10 == version_) {
+        // HTTP/1.0 不支持 chunked，以关闭连接作为响应体结束标志
+        close_connection_ = true;
+    } else {
+        this->append("Transfer-Encoding: chunked\r\n");
+    }
+    if (close_connection_) {
+        this->append("Connection: close\r\n");
+    }
+    this->append(::kCRLF);
+}
+
+void clia::http::HttpResponse::write_chunk(const void *data, const std::size_t len) {
+    assert(chunked_ && !finished_);
+    if (0 == len || head_only_) {
+        return;
+    }
+    if (Version::kHttp10 == version_) {
+        output_->append(data, len);
+        return;
+    }
+    char buf[32];
+    std::size_t n = ::format_hex(buf, len);
+    buf[n++] = '\r';
+    buf[n++] = '\n';
+    output_->append(buf, n);
+    output_->append(data, len);
+    this->append(::kCRLF);
+}
+
+void clia::http::HttpResponse::end_chunked() {
+    assert(chunked_ && !finished_);
+    if (Version::kHttp10 != version_ && !head_only_) {
+        this->append("0\r\n\r\n");
+    }
+    finished_ = true;
+}
+
+void clia::http::HttpResponse::finish() {
+    if (finished_) {
+        return;
+    }
+    if (chunked_) {
+        this->end_chunked();
+    } else {
+        this->set_body(nullptr, 0);
+    }
+}
+
+bool clia::http::HttpResponse::finished() const noexcept {
+    return finished_;
+}
+
+void clia::http::HttpResponse::refresh_date(const std::time_t now) noexcept {
+    if (now == ::kDateSec && ::kDateLen > 0) {
+        return;
+    }
+    ::tm tm_time;
+    ::gmtime_r(&now, &tm_time);
+    ::kDateLen = std::strftime(::kDateBuf, sizeof(::kDateBuf), "Date: %a, %d %b %Y %H:%M:%S GMT\r\n", &tm_time);
+    ::kDateSec = now;
+}
+
+const char* clia::http::HttpResponse::reason_phrase(const int code) noexcept {
+    switch (code) {
+    case 100: return "Continue";
+    case 200: return "OK";
+    case 201: return "Created";
+    case 202: return "Accepted";
+    case 204: return "No Content";
+    case 206: return "Partial Content";
+    case 301: return "Moved Permanently";
+    case 302: return "Found";
+    case 304: return "Not Modified";
+    case 400: return "Bad Request";
+    case 401: return "Unauthorized";
+    case 403: return "Forbidden";
+    case 404: return "Not Found";
+    case 405: return "Method Not Allowed";
+    case 408: return "Request Timeout";
+    case 411: return "Length Required";
+    case 413: return "Payload Too Large";
+    case 414: return "URI Too Long";
+    case 429: return "Too Many Requests";
+    case 431: return "Request Header Fields Too Large";
+    case 500: return "Internal Server Error";
+    case 501: return "Not Implemented";
+    case 502: return "Bad Gateway";
+    case 503: return "Service Unavailable";
+    case 504: return "Gateway Timeout";
+    case 505: return "HTTP Version Not Supported";
+    default: return "Unknown";
+    }
+}
+
+void clia::http::HttpResponse::write_head() {
+    assert(!head_written_);
+    head_written_ = true;
+    char buf[32];
+    const int code = (status_ >= 100 && status_ <= 999) ? status_ : 500;
+    std::memcpy(buf, Version::kHttp10 == version_ ? "HTTP/1.0 " : "HTTP/1.1 ", 9);
+    buf[9] = static_cast<char>('0' + code / 100);
+    buf[10] = static_cast<char>('0' + code / 10 % 10);
+    buf[11] = static_cast<char>('0' + code % 10);
+    buf[12] = ' ';
+    output_->append(buf, 13);
+    this->append(reason_.empty() ? clia::StringView(reason_phrase(code)) : reason_);
+    this->append(::kCRLF);
+    if (0 == ::kDateLen) {
+        refresh_date(std::time(nullptr));
+    }
+    output_->append(::kDateBuf, ::kDateLen);
+    this->append("Server: clia\r\n");
+}
+
+void clia::http::HttpResponse::append(const clia::StringView &str) {
+    output_->append(str.data(), str.size());
+}
@@ -0,0 +1,86 @@
+#include <cassert>
+
+#include "clia/http/http_server.h"
+#include "clia/http/http_parser.h"
+#include "clia/net/buffer.h"
+#include "clia/net/tcp_connection.h"
+#include "clia/log.h"
+
+namespace {
+    // 每个连接一份：解析状态 + 复用的响应缓冲，流水线请求的响应攒在一起一次发送
+    struct HttpContext {
+        clia::http::HttpParser parser;
+        clia::net::Buffer output;
+    };
+}
+
+clia::http::HttpServer::HttpServer(clia::reactor::EventLoop *loop, const clia::net::InetAddress &listen_addr, const bool reuse_port)
+    : server_(loop, listen_addr, reuse_port)
+{
+    server_.set_connection_callback(std::bind(&HttpServer::on_connection, this, std::placeholders::_1));
+    server_.set_message_callback(std::bind(&HttpServer::on_message, this,
+        std::placeholders::_1, std::placeholders::_2, std::placeholders::_3));
+}
+
+clia::http::HttpServer::~HttpServer() = default;
+
+void clia::http::HttpServer::set_http_callback(const HttpCallback &cb) {
+    http_callback_ = cb;
+}
+
+void clia::http::HttpServer::set_thread_num(const int num) {
+    server_.set_thread_num(num);
+}
+
+void clia::http::HttpServer::start() {
+    server_.start();
+}
+
+void clia::http::HttpServer::on_connection(const clia::net::TcpConnectionPtr &conn) {
+    if (conn->connected()) {
+        conn->set_context(std::make_shared<HttpContext>());
+    }
+}
+
+void clia::http::HttpServer::on_message(const clia::net::TcpConnectionPtr &conn, clia::net::Buffer *buf, clia::util::Timestamp receive_time) {
+    const auto context = std::static_pointer_cast<HttpContext>(conn->context());
+    assert(context != nullptr);
+    HttpResponse::refresh_date(receive_time.sec_since_epoch());
+
+    bool close = false;
+    while (!close && buf->readable_bytes() > 0) {
+        const auto result = context->parser.parse(buf);
+        if (HttpParser::Result::kIncomplete == result) {
+            break;
+        }
+        if (HttpParser::Result::kError == result) {
+            CLIA_LOG_DEBUG << "HttpServer bad request from " << conn->peer_addr().get_addr()
+                << ", status = " << context->parser.error_status();
+            HttpResponse response(&context->output, Version::kHttp11, true);
+            response.set_status(context->parser.error_status());
+            response.finish();
+            buf->retrieve_all();
+            close = true;
+            break;
+        }
+
+        const HttpRequest &request = context->parser.request();
+        HttpResponse response(&context->output, request.version(), !request.keep_alive(), Method::kHead == request.method());
+        if (http_callback_) {
+            http_callback_(request, &response);
+        } else {
+            response.set_status(404);
+        }
+        response.finish();
+        close = response.close_connection();
+        buf->retrieve(context->parser.consumed());
+        context->parser.reset();
+    }
+
+    if (context->output.readable_bytes() > 0) {
+        conn->send(&context->output);
+    }
+    if (close) {
+        conn->shutdown();
+    }
+}
@@ -1,3 +1,4 @@
+#include <algorithm>
 #include <cassert>
 #include <chrono>
 #include <cstring>
@@ -7,46 +8,232 @@
 #include <thread>
 #include <condition_variable>
 
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
 #include "clia/log/async_logger.h"
+#include "clia/log/binary.h"
 #include "clia/util/timestamp.h"
+#include "clia/util/process.h"
 #include "clia/container/fixed_buffer.h"
+#include "clia/container/spsc_ring.h"
+
+namespace {
+    using RecordStamp = std::int64_t;
+    // 环形缓冲区中每条记录的头：排序键、级别，以及二进制记录的调用点(文本记录为空)
+    struct RecordHeader {
+        RecordStamp stamp;
+        const clia::log::binary::Site *site;
+        clia::log::Level level;
+    };
+    // 二进制记录格式化后的最大长度
+    constexpr std::size_t kMaxBinaryLine = 2 * clia::log::binary::Encoder::kMaxSize;
+    // 后台线程即使没有被唤醒也按这个间隔取一次各线程的缓冲区
+    constexpr std::chrono::milliseconds kDrainInterval(20);
+
+    std::atomic<std::uint64_t> g_next_logger_id(1);
+
+    // 只用于归并排序，x86 上直接读 TSC(各核同步的 invariant TSC)，比 clock_gettime 便宜
+    RecordStamp record_stamp() noexcept {
+#if defined(__x86_64__) || defined(__i386__)
+        return static_cast<RecordStamp>(__rdtsc());
+#else
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+    }
+}
+
+struct clia::log::AsyncLogger::ThreadRing {
+    explicit ThreadRing(const std::size_t bytes) : ring(bytes), detached(false), closed(false), shed(false) {}
+
+    clia::container::SpscRing ring;
+    std::atomic<bool> detached;     // 写日志的线程已退出，取空后可以回收
+    std::atomic<bool> closed;       // logger 已析构，线程本地缓存中的该项可以丢弃
+    std::atomic<bool> shed;         // 写满且策略为 kDropOldest，请求后台线程丢弃最早的记录
+};
+
+std::uint64_t clia::log::AsyncLogger::DropStats::total_lines() const noexcept {
+    std::uint64_t total = 0;
+    for (const auto n : lines) {
+        total += n;
+    }
+    return total;
+}
+
+std::uint64_t clia::log::AsyncLogger::DropStats::total_bytes() const noexcept {
+    std::uint64_t total = 0;
+    for (const auto n : bytes) {
+        total += n;
+    }
+    return total;
+}
 
-clia::log::AsyncLogger::AsyncLogger(const Level level, std::shared_ptr<trait::Appender> appender, const int flush_interval_sec) noexcept
+clia::log::AsyncLogger::AsyncLogger(const Level level, std::shared_ptr<trait::Appender> appender, const int flush_interval_sec,
+    const std::size_t ring_bytes) noexcept
     : trait::Logger(level, appender)
     , flush_interval_sec_(flush_interval_sec)
     , current_buffer_(new Buffer)
     , next_buffer_(new Buffer)
+    , id_(::g_next_logger_id.fetch_add(1, std::memory_order_relaxed))
+    , ring_bytes_(ring_bytes)
+    , wakeup_(false)
+    , shed_(false)
+    , overflow_(Overflow::kBlock)
+    , keep_level_(Level::kWarn)
 {
+    for (int i = 0; i < kLevelCount; ++i) {
+        dropped_lines_[i].store(0, std::memory_order_relaxed);
+        dropped_bytes_[i].store(0, std::memory_order_relaxed);
+    }
+    current_tally_ = DropStats();
     buffers_.reserve(16);
     running_ = true;
-    thread_ = std::thread(&AsyncLogger::sync_thread, this);
+    if (ring_bytes_ > 0) {
+        thread_ = std::thread(&AsyncLogger::ring_thread, this);
+    } else {
+        thread_ = std::thread(&AsyncLogger::sync_thread, this);
+    }
 }
 
 clia::log::AsyncLogger::~AsyncLogger() noexcept {
-    running_ = false;
+    {
+        // 加锁保证等待中的写日志线程能看到 running_ 的变化
+        std::lock_guard<std::mutex> lck(lck_);
+        running_ = false;
+    }
     cond_.notify_one();
+    not_full_.notify_all();
     if (thread_.joinable()) {
         thread_.join();
     }
+    std::lock_guard<std::mutex> lck(rings_lck_);
+    for (const auto &ring : rings_) {
+        ring->closed.store(true, std::memory_order_release);
+    }
 }
 
 void clia::log::AsyncLogger::log(const Level level, const void *message, const std::size_t len) noexcept {
-    if (level < level_ || nullptr == message || 0 == len || len > Buffer::max_size() || !running_) {
+    if (level < this->level() || nullptr == message || 0 == len || !running_) {
         return; // Ignore messages below the current log level
     }
-    std::lock_guard<std::mutex> lck(lck_);
-    if (current_buffer_->avail() > len) {
-        current_buffer_->append(static_cast<const char*>(message), len);
-    } else {
+    if (ring_bytes_ > 0) {
+        this->push_record(level, nullptr, message, len);
+        return;
+    }
+    if (len >= static_cast<std::size_t>(Buffer::max_size())) {
+        this->count_drop(level, 1, len);
+        return;
+    }
+    std::unique_lock<std::mutex> lck(lck_);
+    if (current_buffer_->avail() <= static_cast<int>(len)) {
+        while (buffers_.size() >= kMaxPendingBuffers) {
+            if (Overflow::kDropOldest == this->overflow()) {
+                // 丢弃最早的待写缓冲区，腾出来的缓冲区留作下一个
+                const DropStats &tally = tallies_.front();
+                for (int i = 0; i < kLevelCount; ++i) {
+                    this->count_drop(static_cast<Level>(i), tally.lines[i], tally.bytes[i]);
+                }
+                BufferPtr recycled = std::move(buffers_.front());
+                buffers_.erase(buffers_.begin());
+                tallies_.erase(tallies_.begin());
+                if (!next_buffer_) {
+                    recycled->reset();
+                    next_buffer_ = std::move(recycled);
+                }
+            } else if (!this->wait_on_overflow(level) || !running_) {
+                this->count_drop(level, 1, len);
+                return;
+            } else {
+                cond_.notify_one();
+                not_full_.wait(lck);
+            }
+        }
         buffers_.emplace_back(std::move(current_buffer_));
+        tallies_.push_back(current_tally_);
+        current_tally_ = DropStats();
         if (next_buffer_) {
             current_buffer_ = std::move(next_buffer_);
         } else {
             current_buffer_.reset(new Buffer);
         }
-        current_buffer_->append(static_cast<const char*>(message), len);
         cond_.notify_one();
     }
+    current_buffer_->append(static_cast<const char*>(message), len);
+    const int index = static_cast<int>(level);
+    current_tally_.lines[index] += 1;
+    current_tally_.bytes[index] += len;
+}
+
+void clia::log::AsyncLogger::set_overflow(const Overflow policy, const Level keep_level) noexcept {
+    keep_level_.store(keep_level, std::memory_order_relaxed);
+    overflow_.store(policy, std::memory_order_relaxed);
+    // 原来阻塞的线程按新策略重新判断
+    std::lock_guard<std::mutex> lck(lck_);
+    not_full_.notify_all();
+}
+
+clia::log::AsyncLogger::Overflow clia::log::AsyncLogger::overflow() const noexcept {
+    return overflow_.load(std::memory_order_relaxed);
+}
+
+clia::log::AsyncLogger::DropStats clia::log::AsyncLogger::drop_stats() const noexcept {
+    DropStats stats;
+    for (int i = 0; i < kLevelCount; ++i) {
+        stats.lines[i] = dropped_lines_[i].load(std::memory_order_relaxed);
+        stats.bytes[i] = dropped_bytes_[i].load(std::memory_order_relaxed);
+    }
+    return stats;
+}
+
+bool clia::log::AsyncLogger::wait_on_overflow(const Level level) const noexcept {
+    switch (this->overflow()) {
+    case Overflow::kBlock:
+        return true;
+    case Overflow::kDropByLevel:
+        return level >= keep_level_.load(std::memory_order_relaxed);
+    default:
+        return false;
+    }
+}
+
+void clia::log::AsyncLogger::count_drop(const Level level, const std::uint64_t lines, const std::uint64_t bytes) noexcept {
+    if (0 == lines) {
+        return;
+    }
+    const int index = static_cast<int>(level);
+    dropped_lines_[index].fetch_add(lines, std::memory_order_relaxed);
+    dropped_bytes_[index].fetch_add(bytes, std::memory_order_relaxed);
+}
+
+void clia::log::AsyncLogger::report_drops(DropStats *reported) noexcept {
+    const DropStats now = this->drop_stats();
+    if (now.total_lines() == reported->total_lines()) {
+        return;
+    }
+    char detail[256];
+    int n = 0;
+    for (int i = 0; i < kLevelCount; ++i) {
+        const std::uint64_t lines = now.lines[i] - reported->lines[i];
+        if (lines > 0 && n < static_cast<int>(sizeof(detail))) {
+            n += std::snprintf(detail + n, sizeof(detail) - n, " %s %llu", level_to_string(static_cast<Level>(i)),
+                static_cast<unsigned long long>(lines));
+        }
+    }
+    const auto stamp = clia::util::Timestamp::now();
+    char timebuf[32];
+    stamp.to_format_str(timebuf, sizeof(timebuf), false);
+    char line[512];
+    const int len = std::snprintf(line, sizeof(line), "%s.%06d %d %d WARN [async_logger.cc:report_drops:%d]:: "
+        "%llu lines (%llu bytes) dropped by overflow policy:%s\n",
+        timebuf, static_cast<int>(stamp.micro_sec_since_epoch() % clia::util::Timestamp::kMicroSecPerSec),
+        clia::util::process::get_pid(), clia::util::process::get_tid(), __LINE__,
+        static_cast<unsigned long long>(now.total_lines() - reported->total_lines()),
+        static_cast<unsigned long long>(now.total_bytes() - reported->total_bytes()), detail);
+    if (len > 0) {
+        appender_->append(line, std::min(static_cast<std::size_t>(len), sizeof(line) - 1));
+    }
+    *reported = now;
 }
 
 inline void clia::log::AsyncLogger::sync_thread() {
@@ -55,6 +242,8 @@ inline void clia::log::AsyncLogger::sync_thread() {
     BufferPtr new_buffer2(new Buffer);
     BufferVector write_buffers;
     write_buffers.reserve(16);
+    DropStats reported = DropStats();
+    auto last_report = std::chrono::steady_clock::now();
 
     while (running_ || current_buffer_->size() != 0) {
         assert(new_buffer1 && new_buffer1->size() == 0);
@@ -67,26 +256,17 @@ inline void clia::log::AsyncLogger::sync_thread() {
             }
             buffers_.push_back(std::move(current_buffer_));
             current_buffer_ = std::move(new_buffer1);
+            current_tally_ = DropStats();
             if (!next_buffer_) {
                 next_buffer_ = std::move(new_buffer2);
             }
             write_buffers.swap(buffers_);
+            tallies_.clear();
         }
+        not_full_.notify_all();
 
         assert(!write_buffers.empty());
 
-        if (write_buffers.size() > 25) {
-            char buf[256] = {0};
-            char timebuf[32] = {0};
-            const auto now = clia::util::Timestamp::now();
-            now.to_format_str(timebuf, sizeof(timebuf));
-            std::snprintf(buf, sizeof(buf), "Dropped log messages at %s, %zd larger buffers\n",
-                    timebuf, write_buffers.size() - 2);
-            std::fputs(buf, stderr);
-            appender_->append(buf, std::strlen(buf));
-            write_buffers.erase(write_buffers.begin() + 2, write_buffers.end());
-        }
-
         for (const auto &buffer : write_buffers) {
             if (buffer->size() <= 0) {
                 continue; // Skip empty buffers
@@ -109,7 +289,238 @@ inline void clia::log::AsyncLogger::sync_thread() {
         }
 
         write_buffers.clear();
+        const auto now = std::chrono::steady_clock::now();
+        if (now - last_report >= std::chrono::seconds(flush_interval_sec_)) {
+            this->report_drops(&reported);
+            last_report = now;
+        }
         appender_->flush();
     }
+    this->report_drops(&reported);
     appender_->flush();
 }
+
+void clia::log::AsyncLogger::log_binary(const binary::Site *site, const void *record, const std::size_t len) noexcept {
+    if (0 == ring_bytes_) {
+        trait::Logger::log_binary(site, record, len);
+        return;
+    }
+    if (site->level < this->level() || !running_) {
+        return;
+    }
+    this->push_record(site->level, site, record, len);
+}
+
+void clia::log::AsyncLogger::push_record(const Level level, const binary::Site *site, const void *data, const std::size_t len) noexcept {
+    ThreadRing *tr = this->local_ring();
+    const std::size_t total = sizeof(RecordHeader) + len;
+    if (total > tr->ring.max_record_size()) {
+        this->count_drop(level, 1, len);
+        return;
+    }
+    void *record = nullptr;
+    while (nullptr == (record = tr->ring.reserve(total))) {
+        // 缓冲区已满：按策略丢弃，或者唤醒后台线程并让出 CPU，等它取走(或丢弃)数据
+        const Overflow policy = this->overflow();
+        if (Overflow::kDropOldest == policy) {
+            tr->shed.store(true, std::memory_order_relaxed);
+            shed_.store(true, std::memory_order_release);
+        } else if (!this->wait_on_overflow(level)) {
+            this->count_drop(level, 1, len);
+            this->wakeup();
+            return;
+        }
+        this->wakeup();
+        if (!running_) {
+            this->count_drop(level, 1, len);
+            return;
+        }
+        std::this_thread::yield();
+    }
+    RecordHeader header;
+    header.stamp = ::record_stamp();
+    header.site = site;
+    header.level = level;
+    std::memcpy(record, &header, sizeof(header));
+    std::memcpy(static_cast<char*>(record) + sizeof(header), data, len);
+    tr->ring.commit();
+    if (tr->ring.producer_used() > tr->ring.capacity() / 2) {
+        this->wakeup();
+    }
+}
+
+clia::log::AsyncLogger::ThreadRing* clia::log::AsyncLogger::local_ring() {
+    // 线程退出时标记它注册过的缓冲区，由后台线程在取空后回收
+    struct LocalRings {
+        std::vector<std::pair<std::uint64_t, std::shared_ptr<ThreadRing>>> rings;
+
+        ~LocalRings() {
+            for (const auto &it : rings) {
+                it.second->detached.store(true, std::memory_order_release);
+            }
+        }
+    };
+    // 最近一次使用的 logger 单独缓存，平凡类型的 thread_local 不需要经过初始化检查
+    static thread_local std::uint64_t last_id = 0;
+    static thread_local ThreadRing *last = nullptr;
+    if (last_id == id_) {
+        return last;
+    }
+    static thread_local LocalRings local;
+    ThreadRing *found = nullptr;
+    for (auto it = local.rings.begin(); it != local.rings.end();) {
+        if (it->second->closed.load(std::memory_order_acquire)) {
+            it = local.rings.erase(it);
+            continue;
+        }
+        if (it->first == id_) {
+            found = it->second.get();
+        }
+        ++it;
+    }
+    if (nullptr == found) {
+        std::shared_ptr<ThreadRing> ring(new ThreadRing(ring_bytes_));
+        {
+            std::lock_guard<std::mutex> lck(rings_lck_);
+            rings_.push_back(ring);
+        }
+        local.rings.emplace_back(id_, ring);
+        found = ring.get();
+    }
+    last_id = id_;
+    last = found;
+    return found;
+}
+
+void clia::log::AsyncLogger::wakeup() noexcept {
+    // 不加锁通知，可能错过正要进入等待的后台线程，后台线程的等待有超时，只影响延迟
+    if (!wakeup_.load(std::memory_order_relaxed) && !wakeup_.exchange(true, std::memory_order_acq_rel)) {
+        cond_.notify_one();
+    }
+}
+
+// 每轮取各线程缓冲区中已提交的日志行，按时间戳归并后写入 appender。
+// 每轮最多取出相当于每个缓冲区一次容量的数据，持续高负载时也能定期重新取快照、刷盘和报告丢弃
+inline void clia::log::AsyncLogger::ring_thread() {
+    assert(appender_ != nullptr);
+    BufferPtr out(new Buffer);
+    std::vector<std::shared_ptr<ThreadRing>> rings;
+    auto last_flush = std::chrono::steady_clock::now();
+    bool dirty = false;
+    DropStats reported = DropStats();
+    auto last_report = last_flush;
+    bool backlog = false;
+    while (true) {
+        const bool running = running_;
+        // 上一轮因预算用完而停下时不等待
+        if (running && !backlog && !wakeup_.load(std::memory_order_acquire)) {
+            std::unique_lock<std::mutex> lck(lck_);
+            cond_.wait_for(lck, ::kDrainInterval);
+        }
+        wakeup_.store(false, std::memory_order_release);
+        {
+            std::lock_guard<std::mutex> lck(rings_lck_);
+            for (auto it = rings_.begin(); it != rings_.end();) {
+                if ((*it)->detached.load(std::memory_order_acquire) && (*it)->ring.empty()) {
+                    it = rings_.erase(it);
+                } else {
+                    ++it;
+                }
+            }
+            rings = rings_;
+        }
+
+        std::size_t drained = 0;
+        std::size_t drained_bytes = 0;
+        const std::size_t budget = ring_bytes_ * rings.size();
+        backlog = false;
+        while (true) {
+            if (drained_bytes >= budget) {
+                backlog = true;
+                break;
+            }
+            if (shed_.load(std::memory_order_relaxed)) {
+                this->shed_oldest(rings);
+            }
+            ThreadRing *next = nullptr;
+            RecordHeader next_header{};
+            const char *next_data = nullptr;
+            std::size_t next_len = 0;
+            for (const auto &tr : rings) {
+                std::size_t len = 0;
+                const char *data = static_cast<const char*>(tr->ring.front(&len));
+                if (nullptr == data) {
+                    continue;
+                }
+                RecordHeader header;
+                std::memcpy(&header, data, sizeof(header));
+                if (nullptr == next || header.stamp < next_header.stamp) {
+                    next = tr.get();
+                    next_header = header;
+                    next_data = data + sizeof(header);
+                    next_len = len - sizeof(header);
+                }
+            }
+            if (nullptr == next) {
+                break;
+            }
+            const std::size_t need = nullptr == next_header.site ? next_len : ::kMaxBinaryLine;
+            if (static_cast<std::size_t>(out->avail()) <= need) {
+                appender_->append(out->data(), out->size());
+                out->reset();
+            }
+            if (nullptr == next_header.site) {
+                out->append(next_data, next_len);
+            } else {
+                out->add(binary::format(*next_header.site, next_data, next_len, out->current(), ::kMaxBinaryLine));
+            }
+            next->ring.pop();
+            ++drained;
+            drained_bytes += sizeof(next_header) + next_len;
+        }
+        if (shed_.load(std::memory_order_relaxed)) {
+            this->shed_oldest(rings);
+        }
+        if (out->size() > 0) {
+            appender_->append(out->data(), out->size());
+            out->reset();
+        }
+
+        const auto now = std::chrono::steady_clock::now();
+        dirty = dirty || drained > 0;
+        if (now - last_report >= std::chrono::seconds(flush_interval_sec_)) {
+            this->report_drops(&reported);
+            last_report = now;
+        }
+        if (dirty && now - last_flush >= std::chrono::seconds(flush_interval_sec_)) {
+            appender_->flush();
+            last_flush = now;
+            dirty = false;
+        }
+        if (!running && 0 == drained) {
+            break;
+        }
+    }
+    this->report_drops(&reported);
+    appender_->flush();
+}
+
+void clia::log::AsyncLogger::shed_oldest(const std::vector<std::shared_ptr<ThreadRing>> &rings) noexcept {
+    shed_.store(false, std::memory_order_relaxed);
+    for (const auto &tr : rings) {
+        if (!tr->shed.exchange(false, std::memory_order_acquire)) {
+            continue;
+        }
+        while (tr->ring.used() > tr->ring.capacity() / 2) {
+            std::size_t len = 0;
+            const void *data = tr->ring.front(&len);
+            if (nullptr == data) {
+                break;
+            }
+            RecordHeader header;
+            std::memcpy(&header, data, sizeof(header));
+            this->count_drop(header.level, 1, len - sizeof(header));
+            tr->ring.pop();
+        }
+    }
+}
@@ -0,0 +1,294 @@
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+
+#include "clia/log/binary.h"
+#include "clia/util/process.h"
+#include "clia/util/str_func.h"
+#include "clia/util/timestamp.h"
+
+namespace {
+    std::mutex &registry_mutex() {
+        static std::mutex mutex;
+        return mutex;
+    }
+
+    std::vector<const clia::log::binary::Site*> &registry() {
+        static std::vector<const clia::log::binary::Site*> sites;
+        return sites;
+    }
+
+    std::uint32_t register_site(const clia::log::binary::Site *site) {
+        std::lock_guard<std::mutex> lock(::registry_mutex());
+        ::registry().push_back(site);
+        return static_cast<std::uint32_t>(::registry().size());
+    }
+
+    constexpr std::size_t kRecordHeaderSize = sizeof(std::int64_t) + sizeof(std::int32_t);
+
+    // 从 out 的剩余空间追加，空间不足时在 UTF-8 字符边界处截断，之后不再追加
+    class Writer {
+    public:
+        Writer(char *out, const std::size_t cap) noexcept : out_(out), cap_(cap), len_(0) {}
+    public:
+        void append(const char *data, const std::size_t len) noexcept {
+            if (len <= cap_ - len_) {
+                std::memcpy(out_ + len_, data, len);
+                len_ += len;
+                return;
+            }
+            const std::size_t n = clia::util::str_func::utf8_truncate(data, cap_ - len_);
+            std::memcpy(out_ + len_, data, n);
+            len_ += n;
+            cap_ = len_;
+        }
+
+        template <typename... Args>
+        void printf(const char *fmt, Args... args) noexcept {
+            if (len_ >= cap_) {
+                return;
+            }
+            const int n = std::snprintf(out_ + len_, cap_ - len_, fmt, args...);
+            if (n <= 0) {
+                return;
+            }
+            if (static_cast<std::size_t>(n) < cap_ - len_) {
+                len_ += static_cast<std::size_t>(n);
+            } else {
+                len_ += clia::util::str_func::utf8_truncate(out_ + len_, cap_ - len_ - 1);
+                cap_ = len_;
+            }
+        }
+
+        std::size_t size() const noexcept { return len_; }
+    private:
+        char *const out_;
+        std::size_t cap_;
+        std::size_t len_;
+    };
+
+    // 解析出的一个转换说明，spec 不含长度修饰符
+    struct Conversion {
+        char spec[32];
+        std::size_t spec_len;
+        char conv;
+    };
+
+    // fmt 指向 '%'，返回转换说明之后的位置
+    const char* parse_conversion(const char *fmt, Conversion *c) noexcept {
+        c->spec_len = 0;
+        c->spec[c->spec_len++] = *fmt++;
+        while (*fmt != '\0' && std::strchr("-+ #0123456789.", *fmt) != nullptr) {
+            if (c->spec_len < sizeof(c->spec) - 4) {
+                c->spec[c->spec_len++] = *fmt;
+            }
+            ++fmt;
+        }
+        while (*fmt != '\0' && std::strchr("hlLqjzt", *fmt) != nullptr) {
+            ++fmt;
+        }
+        c->conv = *fmt;
+        return '\0' == *fmt ? fmt : fmt + 1;
+    }
+}
+
+clia::log::binary::Site::Site(const Level level, const char *format, const char *file, const int line, const char *func) noexcept
+    : level(level)
+    , format(format)
+    , file(file)
+    , line(line)
+    , func(func)
+    , id(::register_site(this))
+{
+    ;
+}
+
+std::vector<const clia::log::binary::Site*> clia::log::binary::sites() {
+    std::lock_guard<std::mutex> lock(::registry_mutex());
+    return ::registry();
+}
+
+constexpr std::size_t clia::log::binary::Encoder::kMaxSize;
+
+clia::log::binary::Encoder::Encoder() noexcept
+    : len_(::kRecordHeaderSize)
+{
+    const std::int64_t now = clia::util::Timestamp::now().micro_sec_since_epoch();
+    const std::int32_t tid = clia::util::process::get_tid();
+    std::memcpy(buf_, &now, sizeof(now));
+    std::memcpy(buf_ + sizeof(now), &tid, sizeof(tid));
+}
+
+void clia::log::binary::Encoder::put(const Tag tag, const void *value, const std::size_t len) noexcept {
+    if (len_ + 1 + len > kMaxSize) {
+        return;
+    }
+    buf_[len_++] = static_cast<char>(tag);
+    std::memcpy(buf_ + len_, value, len);
+    len_ += len;
+}
+
+void clia::log::binary::Encoder::put_string(const char *str, const std::size_t len) noexcept {
+    constexpr std::size_t kOverhead = 1 + sizeof(std::uint32_t);
+    if (len_ + kOverhead > kMaxSize) {
+        return;
+    }
+    std::size_t n = len;
+    if (len_ + kOverhead + len > kMaxSize) {
+        // 截断时不拆开多字节字符
+        n = clia::util::str_func::utf8_truncate(str, kMaxSize - len_ - kOverhead);
+    }
+    buf_[len_++] = static_cast<char>(Tag::kString);
+    const std::uint32_t n32 = static_cast<std::uint32_t>(n);
+    std::memcpy(buf_ + len_, &n32, sizeof(n32));
+    len_ += sizeof(n32);
+    std::memcpy(buf_ + len_, str, n);
+    len_ += n;
+}
+
+std::size_t clia::log::binary::format(const Site &site, const void *record, const std::size_t len, char *out, const std::size_t cap) noexcept {
+    if (cap < 2 || len < ::kRecordHeaderSize) {
+        return 0;
+    }
+    const char *p = static_cast<const char*>(record);
+    const char *const end = p + len;
+    std::int64_t micro = 0;
+    std::int32_t tid = 0;
+    std::memcpy(&micro, p, sizeof(micro));
+    std::memcpy(&tid, p + sizeof(micro), sizeof(tid));
+    p += ::kRecordHeaderSize;
+
+    // 留一个字节给换行
+    ::Writer w(out, cap - 1);
+    char timebuf[64];
+    const clia::util::Timestamp ts(micro);
+    const int n = ts.to_format_str(timebuf, sizeof(timebuf), false);
+    w.append(timebuf, n > 0 ? static_cast<std::size_t>(n) : 0);
+    const char *filename = std::strrchr(site.file, '/');
+    filename = nullptr == filename ? site.file : filename + 1;
+    w.printf(".%06d %d %d %s [%s:%s:%d]:: ", static_cast<int>(micro % clia::util::Timestamp::kMicroSecPerSec),
+        clia::util::process::get_pid(), tid, level_to_string(site.level), filename, site.func, site.line);
+
+    const char *fmt = site.format;
+    while (*fmt != '\0') {
+        const char *pct = std::strchr(fmt, '%');
+        if (nullptr == pct) {
+            w.append(fmt, std::strlen(fmt));
+            break;
+        }
+        w.append(fmt, pct - fmt);
+        if ('%' == pct[1]) {
+            w.append("%", 1);
+            fmt = pct + 2;
+            continue;
+        }
+        ::Conversion c;
+        fmt = ::parse_conversion(pct, &c);
+        if ('\0' == c.conv) {
+            break;
+        }
+        if (p >= end) {
+            w.append("<missing>", 9);
+            continue;
+        }
+        const Tag tag = static_cast<Tag>(*p++);
+        std::int64_t i64 = 0;
+        std::uint64_t u64 = 0;
+        double f64 = 0.0;
+        switch (tag) {
+        case Tag::kInt:
+        case Tag::kUint:
+        case Tag::kPointer:
+            if (end - p < 8) {
+                p = end;
+                continue;
+            }
+            std::memcpy(&u64, p, sizeof(u64));
+            i64 = static_cast<std::int64_t>(u64);
+            p += 8;
+            if ('c' == c.conv) {
+                const char ch = static_cast<char>(u64);
+                w.append(&ch, 1);
+            } else if ('p' == c.conv || Tag::kPointer == tag) {
+                w.printf("%p", reinterpret_cast<void*>(static_cast<std::uintptr_t>(u64)));
+            } else if (std::strchr("diuxXo", c.conv) != nullptr) {
+                c.spec[c.spec_len++] = 'l';
+                c.spec[c.spec_len++] = 'l';
+                c.spec[c.spec_len++] = c.conv;
+                c.spec[c.spec_len] = '\0';
+                if (Tag::kInt == tag) {
+                    w.printf(c.spec, static_cast<long long>(i64));
+                } else {
+                    w.printf(c.spec, static_cast<unsigned long long>(u64));
+                }
+            } else if (std::strchr("fFeEgGaA", c.conv) != nullptr) {
+                c.spec[c.spec_len++] = c.conv;
+                c.spec[c.spec_len] = '\0';
+                w.printf(c.spec, Tag::kInt == tag ? static_cast<double>(i64) : static_cast<double>(u64));
+            } else {
+                w.printf(Tag::kInt == tag ? "%lld" : "%llu", Tag::kInt == tag ? static_cast<long long>(i64) : static_cast<long long>(u64));
+            }
+            break;
+        case Tag::kDouble:
+            if (end - p < 8) {
+                p = end;
+                continue;
+            }
+            std::memcpy(&f64, p, sizeof(f64));
+            p += 8;
+            c.spec[c.spec_len++] = std::strchr("fFeEgGaA", c.conv) != nullptr ? c.conv : 'g';
+            c.spec[c.spec_len] = '\0';
+            w.printf(c.spec, f64);
+            break;
+        case Tag::kChar:
+            if (end - p < 1) {
+                p = end;
+                continue;
+            }
+            if ('c' == c.conv || 's' == c.conv) {
+                w.append(p, 1);
+            } else {
+                w.printf("%d", static_cast<int>(*p));
+            }
+            p += 1;
+            break;
+        case Tag::kString: {
+            std::uint32_t slen = 0;
+            if (end - p < 4) {
+                p = end;
+                continue;
+            }
+            std::memcpy(&slen, p, sizeof(slen));
+            p += sizeof(slen);
+            slen = static_cast<std::uint32_t>(std::min<std::size_t>(slen, end - p));
+            const char *dot = static_cast<const char*>(std::memchr(c.spec, '.', c.spec_len));
+            if (dot != nullptr) {
+                // 带精度时只取前 precision 个字节(不拆开多字节字符)，宽度忽略
+                const long precision = std::max(0L, std::strtol(dot + 1, nullptr, 10));
+                if (static_cast<std::size_t>(precision) < slen) {
+                    w.append(p, clia::util::str_func::utf8_truncate(p, static_cast<std::size_t>(precision)));
+                } else {
+                    w.append(p, slen);
+                }
+            } else {
+                c.spec[c.spec_len++] = '.';
+                c.spec[c.spec_len++] = '*';
+                c.spec[c.spec_len++] = 's';
+                c.spec[c.spec_len] = '\0';
+                w.printf(c.spec, static_cast<int>(slen), p);
+            }
+            p += slen;
+            break;
+        }
+        default:
+            p = end;
+            w.append("<bad record>", 12);
+            break;
+        }
+    }
+    const std::size_t written = w.size();
+    out[written] = '\n';
+    return written + 1;
+}
@@ -0,0 +1,158 @@
+#include <cerrno>
+#include <cstdio>
+#include <vector>
+
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/resource.h> // setpriority
+#include <sys/syscall.h>
+
+#ifdef CLIA_HAVE_ZLIB
+#include <zlib.h>
+#endif
+
+#include "clia/log/compressor.h"
+#include "clia/util/process.h"
+
+namespace {
+    // glibc 没有 ioprio_set 的封装，常量取自 linux/ioprio.h
+    constexpr int kIoprioWhoProcess = 1;
+    constexpr int kIoprioClassBe = 2;
+    constexpr int kIoprioClassIdle = 3;
+    constexpr int kIoprioClassShift = 13;
+
+    // 只影响调用线程：Linux 上 PRIO_PROCESS 与 IOPRIO_WHO_PROCESS 传线程 id 时作用于单个线程
+    void lower_priority() noexcept {
+        const int tid = clia::util::process::get_tid();
+        if (::setpriority(PRIO_PROCESS, tid, 19) != 0) {
+            std::fprintf(stderr, "clia::log::Compressor setpriority failed, errno = [%d][%s]\n", errno, clia::util::process::strerror(errno));
+        }
+#ifdef SYS_ioprio_set
+        if (::syscall(SYS_ioprio_set, kIoprioWhoProcess, tid, kIoprioClassIdle << kIoprioClassShift) != 0) {
+            // 不允许 idle 时退回 best-effort 的最低级别
+            ::syscall(SYS_ioprio_set, kIoprioWhoProcess, tid, (kIoprioClassBe << kIoprioClassShift) | 7);
+        }
+#endif
+    }
+}
+
+constexpr const char *clia::log::Compressor::kSuffix;
+constexpr const char *clia::log::Compressor::kTempSuffix;
+
+clia::log::Compressor::Compressor(const int level)
+    : level_(level < 1 ? 1 : (level > 9 ? 9 : level))
+    , running_(false)
+{
+    if (available()) {
+        running_ = true;
+        thread_ = std::thread(&Compressor::thread_func, this);
+    }
+}
+
+clia::log::Compressor::~Compressor() noexcept {
+    {
+        std::lock_guard<std::mutex> lck(lck_);
+        running_ = false;
+    }
+    cond_.notify_one();
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+}
+
+bool clia::log::Compressor::available() noexcept {
+#ifdef CLIA_HAVE_ZLIB
+    return true;
+#else
+    return false;
+#endif
+}
+
+void clia::log::Compressor::submit(const std::string &filename) {
+    if (!thread_.joinable()) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lck(lck_);
+        files_.push_back(filename);
+    }
+    cond_.notify_one();
+}
+
+std::size_t clia::log::Compressor::pending() const {
+    std::lock_guard<std::mutex> lck(lck_);
+    return files_.size();
+}
+
+void clia::log::Compressor::thread_func() noexcept {
+    ::lower_priority();
+    for (;;) {
+        std::string filename;
+        {
+            std::unique_lock<std::mutex> lck(lck_);
+            cond_.wait(lck, [this]() { return !files_.empty() || !running_; });
+            if (files_.empty()) {
+                break;
+            }
+            filename = std::move(files_.front());
+            files_.pop_front();
+        }
+        compress(filename, level_);
+    }
+}
+
+bool clia::log::Compressor::compress(const std::string &filename, const int level) noexcept {
+#ifdef CLIA_HAVE_ZLIB
+    const std::string target = filename + kSuffix;
+    const std::string temp = filename + kTempSuffix;
+    const int in = ::open(filename.c_str(), O_RDONLY | O_CLOEXEC);
+    if (in < 0) {
+        std::fprintf(stderr, "clia::log::Compressor open [%s] failed, errno = [%d][%s]\n", filename.c_str(), errno, clia::util::process::strerror(errno));
+        return false;
+    }
+    const int out = ::open(temp.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (out < 0) {
+        std::fprintf(stderr, "clia::log::Compressor open [%s] failed, errno = [%d][%s]\n", temp.c_str(), errno, clia::util::process::strerror(errno));
+        ::close(in);
+        return false;
+    }
+    // gzclose 会关闭传入的描述符，保留 out 用于 fsync
+    char mode[8];
+    std::snprintf(mode, sizeof(mode), "wb%d", level);
+    ::gzFile gz = ::gzdopen(::dup(out), mode);
+    bool ok = gz != nullptr;
+    if (ok) {
+        ::gzbuffer(gz, 256 * 1024);
+        std::vector<char> buf(256 * 1024);
+        for (;;) {
+            const ::ssize_t n = ::read(in, buf.data(), buf.size());
+            if (n < 0 && EINTR == errno) {
+                continue;
+            }
+            if (n <= 0) {
+                ok = 0 == n;
+                break;
+            }
+            if (::gzwrite(gz, buf.data(), static_cast<unsigned>(n)) != static_cast<int>(n)) {
+                ok = false;
+                break;
+            }
+        }
+        ok = Z_OK == ::gzclose(gz) && ok;
+    }
+    ok = ok && 0 == ::fsync(out);
+    ::close(out);
+    ::close(in);
+    if (!ok || ::rename(temp.c_str(), target.c_str()) != 0) {
+        std::fprintf(stderr, "clia::log::Compressor compress [%s] failed, errno = [%d][%s]\n", filename.c_str(), errno, clia::util::process::strerror(errno));
+        ::unlink(temp.c_str());
+        return false;
+    }
+    ::unlink(filename.c_str());
+    return true;
+#else
+    (void)filename;
+    (void)level;
+    return false;
+#endif
+}
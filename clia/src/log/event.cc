@@ -1,18 +1,20 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
 #include <cstring>
 
 #include "clia/log/event.h"
 #include "clia/util/timestamp.h"
 #include "clia/util/process.h"
+#include "clia/util/str_func.h"
 
 namespace {
     thread_local int kMicroSecPos = 0;
     thread_local char kTimeBuf[64] = {0};
     thread_local std::time_t kLastUpdateSec = 0;
 
-    template <typename OStream>
-    inline static void tips_message(OStream &out, const clia::log::Level level, const char *file, const int line, const char *func) noexcept {
-        assert(file != nullptr && line != -1 && func != nullptr);
-        constexpr char kSpacer = ' ';
+    // 当前时间，精确到微秒，每个线程每秒只完整格式化一次
+    inline static const char* format_now() noexcept {
         const auto now = clia::util::Timestamp::now();
         const auto sec = now.sec_since_epoch();
         if (sec != ::kLastUpdateSec) {
@@ -20,22 +22,59 @@ namespace {
             ::kLastUpdateSec = sec;
         }
         std::sprintf(::kTimeBuf + ::kMicroSecPos, ".%06d", static_cast<int>(now.micro_sec_since_epoch() % clia::util::Timestamp::kMicroSecPerSec));
+        return ::kTimeBuf;
+    }
 
+    inline static const char* base_name(const char *file) noexcept {
         const char *filename = std::strrchr(file, '/');
-        if (!filename) {
-            filename = file; // 如果没有找到斜杠，使用完整路径
-        } else {
-            ++filename; // 跳过斜杠
-        }
-        out << ::kTimeBuf << kSpacer 
+        return filename ? filename + 1 : file; // 没有斜杠时使用完整路径
+    }
+
+    template <typename OStream>
+    inline static void tips_message(OStream &out, const clia::log::Level level, const char *file, const int line, const char *func) noexcept {
+        assert(file != nullptr && line != -1 && func != nullptr);
+        constexpr char kSpacer = ' ';
+        out << ::format_now() << kSpacer 
             << clia::util::process::get_pid() << kSpacer
             << clia::util::process::get_tid() << kSpacer
             << clia::log::level_to_string(level) << kSpacer
-            << '[' << filename << ':' << func << ':' << line << "]::" << kSpacer;
+            << '[' << ::base_name(file) << ':' << func << ':' << line << "]::" << kSpacer;
+    }
+
+    // 键只允许这些字符，输出时不需要转义
+    inline static bool valid_key(const char *key, const std::size_t len) noexcept {
+        for (std::size_t i = 0; i < len; ++i) {
+            const char c = key[i];
+            if (!((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || '_' == c || '.' == c || '-' == c)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // logfmt 中值含有这些字符时需要加引号
+    inline static bool needs_quote(const char *str, const std::size_t len) noexcept {
+        if (0 == len) {
+            return true;
+        }
+        for (std::size_t i = 0; i < len; ++i) {
+            const unsigned char c = static_cast<unsigned char>(str[i]);
+            if (c <= ' ' || '=' == c || '"' == c || '\\' == c || 0x7f == c) {
+                return true;
+            }
+        }
+        return false;
     }
+
+    // 行尾保留：截断标记、'}'、'\n'，以及 FixedBuffer 要求的一个空闲字节
+    constexpr std::size_t kTailReserve = sizeof(",\"_truncated\":true}\n");
+    // 键之外给一个数值预留的长度，str_func::convert 要求至少 32 字节
+    constexpr std::size_t kNumberReserve = 32;
+    // 非法 UTF-8 字节替换为 U+FFFD
+    constexpr char kReplacement[] = "\xef\xbf\xbd";
 }
 
-clia::log::Event::Event(std::shared_ptr<trait::Logger> logger, const Level level, const char *file, const int line, const char *func) noexcept
+clia::log::Event::Event(trait::Logger *logger, const Level level, const char *file, const int line, const char *func) noexcept
     : logger_(logger)
     , level_(level)
 {
@@ -60,7 +99,7 @@ void clia::log::Event::format(const char *fmt, ...) noexcept {
     va_end(al);
 }
 
-clia::log::LargeEvent::LargeEvent(std::shared_ptr<trait::Logger> logger, const Level level, const char *file, const int line, const char *func) noexcept
+clia::log::LargeEvent::LargeEvent(trait::Logger *logger, const Level level, const char *file, const int line, const char *func) noexcept
     : logger_(logger)
     , level_(level)
 {
@@ -89,4 +128,210 @@ void clia::log::LargeEvent::format(const char *fmt, ...) noexcept {
         std::free(buf);
     }
     va_end(al);
-}
\ No newline at end of file
+}
+
+std::atomic<clia::log::StructuredEvent::Format> clia::log::StructuredEvent::format_(clia::log::StructuredEvent::Format::kLogfmt);
+
+clia::log::StructuredEvent::StructuredEvent(trait::Logger *logger, const Level level, const char *event, const char *file, const int line, const char *func) noexcept
+    : logger_(logger)
+    , level_(level)
+    , fmt_(format())
+{
+    if (Format::kLogfmt == fmt_) {
+        ::tips_message(stream_, level, file, line, func);
+        this->put_raw("event=", 6);
+    } else {
+        assert(file != nullptr && line != -1 && func != nullptr);
+        stream_ << "{\"ts\":\"" << ::format_now()
+            << "\",\"pid\":" << clia::util::process::get_pid()
+            << ",\"tid\":" << clia::util::process::get_tid()
+            << ",\"level\":\"" << clia::log::level_to_string(level)
+            << "\",\"src\":";
+        char src[256];
+        const int n = std::snprintf(src, sizeof(src), "%s:%s:%d", ::base_name(file), func, line);
+        this->put_string(src, n > 0 ? std::min(static_cast<std::size_t>(n), sizeof(src) - 1) : 0);
+        this->put_raw(",\"event\":", 9);
+    }
+    this->put_value(event);
+}
+
+clia::log::StructuredEvent::~StructuredEvent() noexcept {
+    // room() 之外保留的空间保证这里总能写下
+    if (Format::kLogfmt == fmt_) {
+        if (truncated_) {
+            stream_ << " _truncated=true";
+        }
+    } else {
+        if (truncated_) {
+            stream_ << ",\"_truncated\":true";
+        }
+        stream_ << '}';
+    }
+    stream_ << '\n';
+    if (logger_) {
+        logger_->log(level_, stream_.data(), stream_.size());
+    }
+}
+
+std::size_t clia::log::StructuredEvent::room() const noexcept {
+    const std::size_t avail = stream_.avail();
+    return avail > ::kTailReserve ? avail - ::kTailReserve : 0;
+}
+
+void clia::log::StructuredEvent::put_raw(const char *data, const std::size_t len) noexcept {
+    if (len > this->room()) {
+        truncated_ = true;
+        return;
+    }
+    std::memcpy(stream_.current(), data, len);
+    stream_.add(len);
+}
+
+bool clia::log::StructuredEvent::put_key(const char *key, const std::size_t len) noexcept {
+    assert(::valid_key(key, len));
+    if (truncated_ || len + 4 + ::kNumberReserve > this->room()) {
+        truncated_ = true;
+        return false;
+    }
+    char *p = stream_.current();
+    if (Format::kLogfmt == fmt_) {
+        *p++ = ' ';
+        std::memcpy(p, key, len);
+        p += len;
+        *p++ = '=';
+    } else {
+        *p++ = ',';
+        *p++ = '"';
+        std::memcpy(p, key, len);
+        p += len;
+        *p++ = '"';
+        *p++ = ':';
+    }
+    stream_.add(p - stream_.current());
+    return true;
+}
+
+void clia::log::StructuredEvent::put_int(const long long value) noexcept {
+    // put_key 已经保证了 kNumberReserve 的空间
+    const auto n = clia::util::str_func::convert(stream_.current(), static_cast<int>(::kNumberReserve), value);
+    stream_.add(n);
+}
+
+void clia::log::StructuredEvent::put_uint(const unsigned long long value) noexcept {
+    const auto n = clia::util::str_func::convert(stream_.current(), static_cast<int>(::kNumberReserve), value);
+    stream_.add(n);
+}
+
+void clia::log::StructuredEvent::put_value(const bool value) noexcept {
+    if (value) {
+        this->put_raw("true", 4);
+    } else {
+        this->put_raw("false", 5);
+    }
+}
+
+void clia::log::StructuredEvent::put_value(const double value) noexcept {
+    if (Format::kJson == fmt_ && !std::isfinite(value)) {
+        // JSON 不能表示 nan 与 inf
+        this->put_raw("null", 4);
+        return;
+    }
+    const auto n = clia::util::str_func::convert(stream_.current(), static_cast<int>(::kNumberReserve), value);
+    stream_.add(n);
+}
+
+void clia::log::StructuredEvent::put_value(const char *value) noexcept {
+    if (nullptr == value) {
+        if (Format::kJson == fmt_) {
+            this->put_raw("null", 4);
+        } else {
+            this->put_raw("(null)", 6);
+        }
+        return;
+    }
+    this->put_string(value, std::strlen(value));
+}
+
+void clia::log::StructuredEvent::put_value(const void *value) noexcept {
+    char *p = stream_.current();
+    std::size_t n = 0;
+    if (Format::kJson == fmt_) {
+        p[n++] = '"';
+    }
+    n += clia::util::str_func::convert_pointer(p + n, static_cast<int>(::kNumberReserve), value);
+    if (Format::kJson == fmt_) {
+        p[n++] = '"';
+    }
+    stream_.add(n);
+}
+
+void clia::log::StructuredEvent::put_string(const char *str, const std::size_t len) noexcept {
+    constexpr char kHexDigits[] = "0123456789abcdef";
+    const bool quote = Format::kJson == fmt_ || ::needs_quote(str, len);
+    // 先扣除结尾的引号
+    std::size_t room = this->room();
+    if (quote) {
+        if (room < 2) {
+            truncated_ = true;
+            return;
+        }
+        room -= 1;
+    }
+    char *const begin = stream_.current();
+    char *p = begin;
+    char *const end = begin + room;
+    if (quote) {
+        *p++ = '"';
+    }
+    for (std::size_t i = 0; i < len; ++i) {
+        const unsigned char c = static_cast<unsigned char>(str[i]);
+        char esc = 0;
+        switch (c) {
+        case '"': esc = '"'; break;
+        case '\\': esc = '\\'; break;
+        case '\n': esc = 'n'; break;
+        case '\r': esc = 'r'; break;
+        case '\t': esc = 't'; break;
+        default: break;
+        }
+        if (esc != 0) {
+            if (end - p < 2) {
+                truncated_ = true;
+                break;
+            }
+            *p++ = '\\';
+            *p++ = esc;
+        } else if (c < 0x20 || 0x7f == c) {
+            if (end - p < 6) {
+                truncated_ = true;
+                break;
+            }
+            std::memcpy(p, "\\u00", 4);
+            p[4] = kHexDigits[c >> 4];
+            p[5] = kHexDigits[c & 0xf];
+            p += 6;
+        } else if (c >= 0x80) {
+            // 多字节字符整体写入或整体截掉；非法字节逐个替换
+            const std::size_t n = clia::util::str_func::utf8_char_length(str + i, len - i);
+            const char *const seq = n > 0 ? str + i : ::kReplacement;
+            const std::size_t seq_len = n > 0 ? n : sizeof(::kReplacement) - 1;
+            if (static_cast<std::size_t>(end - p) < seq_len) {
+                truncated_ = true;
+                break;
+            }
+            std::memcpy(p, seq, seq_len);
+            p += seq_len;
+            i += n > 0 ? n - 1 : 0;
+        } else {
+            if (p == end) {
+                truncated_ = true;
+                break;
+            }
+            *p++ = static_cast<char>(c);
+        }
+    }
+    if (quote) {
+        *p++ = '"';
+    }
+    stream_.add(p - begin);
+}
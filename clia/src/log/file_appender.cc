@@ -1,3 +1,5 @@
+#include <algorithm>
+#include <cerrno>
 #include <cstddef>
 #include <cstdio>
 #include <cassert>
@@ -7,6 +9,7 @@
 
 #include <unistd.h> // access
 #include <sys/stat.h> // stat
+#include <sys/uio.h> // writev
 #include <dirent.h>
 #include <fcntl.h>
 
@@ -20,6 +23,48 @@ namespace {
         // 格式化时间到缓冲区（不含毫秒）
         return std::strftime(outbuf, size, "%Y%m%d%H%M%S", &tm_info);
     }
+
+    // 写完 iov 中的全部数据，处理部分写入与 EINTR
+    bool writev_fully(const int fd, ::iovec *iov, int iovcnt) noexcept {
+        while (iovcnt > 0) {
+            const ::ssize_t n = ::writev(fd, iov, iovcnt);
+            if (n < 0) {
+                if (EINTR == errno) {
+                    continue;
+                }
+                std::fprintf(stderr, "clia::log::FileAppender writev failed, errno = [%d][%s]\n", errno, clia::util::process::strerror(errno));
+                return false;
+            }
+            std::size_t done = static_cast<std::size_t>(n);
+            while (iovcnt > 0 && done >= iov->iov_len) {
+                done -= iov->iov_len;
+                ++iov;
+                --iovcnt;
+            }
+            if (iovcnt > 0) {
+                iov->iov_base = static_cast<char*>(iov->iov_base) + done;
+                iov->iov_len -= done;
+            }
+        }
+        return true;
+    }
+
+    bool pwrite_fully(const int fd, const char *data, std::size_t len, ::off_t offset) noexcept {
+        while (len > 0) {
+            const ::ssize_t n = ::pwrite(fd, data, len, offset);
+            if (n < 0) {
+                if (EINTR == errno) {
+                    continue;
+                }
+                std::fprintf(stderr, "clia::log::FileAppender pwrite failed, errno = [%d][%s]\n", errno, clia::util::process::strerror(errno));
+                return false;
+            }
+            data += n;
+            len -= static_cast<std::size_t>(n);
+            offset += n;
+        }
+        return true;
+    }
 }
 
 clia::log::FileAppender::FileAppender(
@@ -29,7 +74,8 @@ clia::log::FileAppender::FileAppender(
     const int roll_period_days,
     const int retain_period_day, 
     const int check_every, // 每1024次检查一次是否需要滚动
-    const bool thread_safe 
+    const bool thread_safe,
+    const Options &options
 )   : path_(path)
     , logname_(logname)
     , roll_size_byte_(roll_size_byte)
@@ -42,20 +88,43 @@ clia::log::FileAppender::FileAppender(
     , lck_(thread_safe ? new std::mutex : nullptr) 
     , written_bytes_(0)
     , file_(nullptr)
+    , options_(options)
+    , fd_(-1)
+    , o_direct_(false)
+    , staging_(nullptr)
+    , staged_(0)
+    , file_offset_(0)
+    , unsynced_bytes_(0)
+    , last_sync_(0)
 {
     if (::access(path_.c_str(), F_OK) != 0) {
         ::mkdir(path_.c_str(), 0755);
     }
-    buffer_.resize(kBufferSize);
+    constexpr char kSuffix[] = ".log";
+    file_suffix_ = '.' + logname_;
+    if (logname_.find(kSuffix) == std::string::npos) {
+        file_suffix_ += kSuffix;
+    }
+    if (options_.compress_rotated) {
+        if (Compressor::available()) {
+            compressor_.reset(new Compressor(options_.compress_level));
+        } else {
+            std::fprintf(stderr, "clia::log::FileAppender built without zlib, rotated files will not be compressed\n");
+        }
+    }
+    if (options_.direct_write) {
+        // 多分配一个对齐单位，O_DIRECT 要求缓冲区地址对齐
+        buffer_.resize(kBufferSize + kDirectAlignment);
+        const auto addr = reinterpret_cast<std::uintptr_t>(buffer_.data());
+        staging_ = buffer_.data() + ((kDirectAlignment - addr % kDirectAlignment) % kDirectAlignment);
+    } else {
+        buffer_.resize(kBufferSize);
+    }
     this->roll_file();
 }
 
 clia::log::FileAppender::~FileAppender() {
-    if (file_ != nullptr && file_ != stdout && file_ != stderr) {
-        std::fflush(file_);
-        ::fsync(::fileno(file_));
-        std::fclose(file_);
-    }
+    this->close_file();
 }
 
 void clia::log::FileAppender::append(const void *buf, const std::size_t size) noexcept {
@@ -71,7 +140,11 @@ void clia::log::FileAppender::append(const void *buf, const std::size_t size) no
 }
 
 void clia::log::FileAppender::flush() noexcept {
-    std::fflush(file_);
+    if (options_.direct_write) {
+        this->write_staged(true);
+    } else {
+        std::fflush(file_);
+    }
 }
 
 void clia::log::FileAppender::roll_file() noexcept {
@@ -80,16 +153,26 @@ void clia::log::FileAppender::roll_file() noexcept {
         const auto filename = this->get_logfilename();
         last_roll_time_ = now;
         this_roll_period_ = now / roll_period_sec_ * roll_period_sec_;
-        if (file_ != nullptr && file_ != stdout && file_ != stderr) {
-            std::fflush(file_);
-            ::fsync(::fileno(file_));
-            std::fclose(file_);
+        this->close_file();
+        if (compressor_ && !filename_.empty()) {
+            compressor_->submit(filename_);
         }
+        this->open_file(filename);
+        filename_ = filename;
+        written_bytes_ = 0;
+        this->del_old_files();
+    }
+}
+
+void clia::log::FileAppender::open_file(const std::string &filename) noexcept {
+    int fd = -1;
+    if (!options_.direct_write) {
         file_ = std::fopen(filename.c_str(), "a");
         if (file_ != nullptr) {
             if (std::setvbuf(file_, buffer_.data(), _IOFBF, buffer_.size()) != 0) {
                 std::fprintf(stderr, "setvbuf buf err, errno = [%d][%s]\n", errno, clia::util::process::strerror(errno));
             }
+            fd = ::fileno(file_);
         } else {
             std::fprintf(stderr, "fopen log [%s] err, errno = [%d][%s]\n", filename.c_str(), errno, clia::util::process::strerror(errno));
 #ifdef NDEBUG
@@ -98,9 +181,156 @@ void clia::log::FileAppender::roll_file() noexcept {
             file_ = stderr;
 #endif
         } 
-        written_bytes_ = 0;
-        this->del_old_files();
+    } else {
+        o_direct_ = false;
+        staged_ = 0;
+        file_offset_ = 0;
+        if (options_.o_direct) {
+            // O_DIRECT 下按偏移 pwrite，已有内容的长度必须是块大小的整数倍
+            fd = ::open(filename.c_str(), O_WRONLY | O_CREAT | O_CLOEXEC | O_DIRECT, 0644);
+            struct stat st;
+            if (fd >= 0 && ::fstat(fd, &st) == 0 && st.st_size % kDirectAlignment == 0) {
+                o_direct_ = true;
+                file_offset_ = static_cast<std::uint64_t>(st.st_size);
+            } else {
+                std::fprintf(stderr, "open log [%s] with O_DIRECT err, fall back to buffered write, errno = [%d][%s]\n",
+                    filename.c_str(), errno, clia::util::process::strerror(errno));
+                if (fd >= 0) {
+                    ::close(fd);
+                    fd = -1;
+                }
+            }
+        }
+        if (fd < 0) {
+            fd = ::open(filename.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+        }
+        if (fd >= 0) {
+            fd_ = fd;
+        } else {
+            std::fprintf(stderr, "open log [%s] err, errno = [%d][%s]\n", filename.c_str(), errno, clia::util::process::strerror(errno));
+#ifdef NDEBUG
+            fd_ = STDOUT_FILENO;
+#else
+            fd_ = STDERR_FILENO;
+#endif
+        }
     }
+    if (fd >= 0 && options_.preallocate_bytes > 0) {
+        // 只分配空间不改变文件大小，文件内容与未预分配时一致
+        if (::fallocate(fd, FALLOC_FL_KEEP_SIZE, 0, static_cast<::off_t>(options_.preallocate_bytes)) != 0) {
+            std::fprintf(stderr, "fallocate log [%s] err, errno = [%d][%s]\n", filename.c_str(), errno, clia::util::process::strerror(errno));
+        }
+    }
+    unsynced_bytes_ = 0;
+    last_sync_ = std::time(nullptr);
+}
+
+void clia::log::FileAppender::close_file() noexcept {
+    if (options_.direct_write) {
+        if (fd_ < 0) {
+            return;
+        }
+        this->write_staged(true);
+        staged_ = 0;
+        if (fd_ != STDOUT_FILENO && fd_ != STDERR_FILENO) {
+            ::fsync(fd_);
+            ::close(fd_);
+        }
+        fd_ = -1;
+    } else if (file_ != nullptr && file_ != stdout && file_ != stderr) {
+        std::fflush(file_);
+        ::fsync(::fileno(file_));
+        std::fclose(file_);
+        file_ = nullptr;
+    }
+}
+
+void clia::log::FileAppender::write_direct(const void *buf, const std::size_t size) noexcept {
+    const char *p = static_cast<const char*>(buf);
+    if (!o_direct_ && size >= kWriteThrough) {
+        // 大块数据连同已缓存的部分一次 writev 写出
+        ::iovec iov[2];
+        int iovcnt = 0;
+        if (staged_ > 0) {
+            iov[iovcnt].iov_base = staging_;
+            iov[iovcnt].iov_len = staged_;
+            ++iovcnt;
+        }
+        iov[iovcnt].iov_base = const_cast<char*>(p);
+        iov[iovcnt].iov_len = size;
+        ++iovcnt;
+        ::writev_fully(fd_, iov, iovcnt);
+        staged_ = 0;
+        return;
+    }
+    std::size_t remain = size;
+    while (remain > 0) {
+        const std::size_t n = std::min(remain, static_cast<std::size_t>(kBufferSize) - staged_);
+        std::memcpy(staging_ + staged_, p, n);
+        staged_ += n;
+        p += n;
+        remain -= n;
+        if (staged_ == static_cast<std::size_t>(kBufferSize)) {
+            this->write_staged(false);
+        }
+    }
+}
+
+void clia::log::FileAppender::write_staged(const bool all) noexcept {
+    if (0 == staged_ || fd_ < 0) {
+        return;
+    }
+    if (!o_direct_) {
+        ::iovec iov;
+        iov.iov_base = staging_;
+        iov.iov_len = staged_;
+        ::writev_fully(fd_, &iov, 1);
+        staged_ = 0;
+        return;
+    }
+    const std::size_t blocks = staged_ / kDirectAlignment * kDirectAlignment;
+    if (blocks > 0) {
+        ::pwrite_fully(fd_, staging_, blocks, static_cast<::off_t>(file_offset_));
+        file_offset_ += blocks;
+        staged_ -= blocks;
+        std::memmove(staging_, staging_ + blocks, staged_);
+    }
+    if (all && staged_ > 0) {
+        // 不足一块的尾部临时关闭 O_DIRECT 写入，数据仍留在 staging_ 中，凑满一块后在同一偏移重写
+        const int flags = ::fcntl(fd_, F_GETFL);
+        ::fcntl(fd_, F_SETFL, flags & ~O_DIRECT);
+        ::pwrite_fully(fd_, staging_, staged_, static_cast<::off_t>(file_offset_));
+        ::fcntl(fd_, F_SETFL, flags);
+    }
+}
+
+void clia::log::FileAppender::maybe_sync(const std::size_t size) noexcept {
+    if (0 == options_.sync_every_bytes && 0 == options_.sync_every_sec) {
+        return;
+    }
+    unsynced_bytes_ += size;
+    bool due = options_.sync_every_bytes > 0 && unsynced_bytes_ >= options_.sync_every_bytes;
+    std::time_t now = 0;
+    if (!due && options_.sync_every_sec > 0) {
+        now = std::time(nullptr);
+        due = now - last_sync_ >= options_.sync_every_sec;
+    }
+    if (!due) {
+        return;
+    }
+    int fd = -1;
+    if (options_.direct_write) {
+        this->write_staged(true);
+        fd = fd_;
+    } else if (file_ != nullptr) {
+        std::fflush(file_);
+        fd = ::fileno(file_);
+    }
+    if (fd > STDERR_FILENO) {
+        ::fdatasync(fd);
+    }
+    unsynced_bytes_ = 0;
+    last_sync_ = now != 0 ? now : std::time(nullptr);
 }
 
 std::string clia::log::FileAppender::get_logfilename() noexcept {
@@ -120,13 +350,7 @@ std::string clia::log::FileAppender::get_logfilename() noexcept {
     char pidbuf[32];
     std::snprintf(pidbuf, sizeof pidbuf, "%d", clia::util::process::get_pid());
     filename += pidbuf;
-    filename += '.';
-
-    constexpr char kSuffix[] = ".log";
-    filename += logname_;
-    if (logname_.find(kSuffix) == std::string::npos) {
-        filename += kSuffix;
-    }
+    filename += file_suffix_;
 
     return filename;
 }
@@ -145,6 +369,13 @@ void clia::log::FileAppender::append_unlocked(const void *buf, const std::size_t
         }
     }
 
+    if (options_.direct_write) {
+        this->write_direct(buf, size);
+        written_bytes_ += size;
+        this->maybe_sync(size);
+        return;
+    }
+
     std::size_t written = 0;
     while (written != size) {
         const std::size_t remain = size - written;
@@ -159,6 +390,7 @@ void clia::log::FileAppender::append_unlocked(const void *buf, const std::size_t
         written += n;
     }
     written_bytes_ += written;
+    this->maybe_sync(written);
 }
 
 void clia::log::FileAppender::del_old_files() noexcept {
@@ -176,8 +408,8 @@ void clia::log::FileAppender::del_old_files() noexcept {
         if (entry->d_type != DT_REG) {
             continue;
         }
-        if (std::strncmp(entry->d_name, timebuf, timebuflen) >= 0) {
-            continue; // 跳过隐藏文件
+        if (!this->is_own_file(entry->d_name) || std::strncmp(entry->d_name, timebuf, timebuflen) >= 0) {
+            continue;
         }
         old_files.emplace_back(path_ + "/" + entry->d_name);
     }
@@ -186,4 +418,27 @@ void clia::log::FileAppender::del_old_files() noexcept {
     for (const auto &oldfile : old_files) {
         std::remove(oldfile.c_str());
     }
-} 
\ No newline at end of file
+}
+
+bool clia::log::FileAppender::is_own_file(const char *name) const noexcept {
+    // 时间前缀.pid + file_suffix_ [+ .gz | .gz.tmp]
+    constexpr std::size_t kDateLen = 14;
+    const std::size_t len = std::strlen(name);
+    if (len <= kDateLen + 1 || name[kDateLen] != '.') {
+        return false;
+    }
+    for (std::size_t i = 0; i < kDateLen; ++i) {
+        if (name[i] < '0' || name[i] > '9') {
+            return false;
+        }
+    }
+    const char *p = name + kDateLen + 1;
+    while (*p >= '0' && *p <= '9') {
+        ++p;
+    }
+    if (p == name + kDateLen + 1 || std::strncmp(p, file_suffix_.c_str(), file_suffix_.size()) != 0) {
+        return false;
+    }
+    p += file_suffix_.size();
+    return '\0' == *p || 0 == std::strcmp(p, Compressor::kSuffix) || 0 == std::strcmp(p, Compressor::kTempSuffix);
+}
@@ -1,7 +1,18 @@
 #include "clia/log.h"
 
-clia::log::LoggerManger::LoggerManger() noexcept = default;
-clia::log::LoggerManger::~LoggerManger() noexcept = default;
+std::atomic<clia::log::trait::Logger*> clia::log::LoggerManger::default_ptr_(nullptr);
+
+clia::log::LoggerManger::LoggerManger() noexcept
+    : registry_(nullptr)
+{
+    std::unique_ptr<const Registry> empty(new Registry);
+    registry_.store(empty.get(), std::memory_order_release);
+    snapshots_.push_back(std::move(empty));
+}
+
+clia::log::LoggerManger::~LoggerManger() noexcept {
+    default_ptr_.store(nullptr, std::memory_order_release);
+}
 
 clia::log::LoggerManger* clia::log::LoggerManger::instance() noexcept {
     static LoggerManger kInstance;
@@ -9,23 +20,68 @@ clia::log::LoggerManger* clia::log::LoggerManger::instance() noexcept {
 }
 
 std::shared_ptr<clia::log::trait::Logger> clia::log::LoggerManger::logger(const std::string &name) noexcept {
-    auto it = loggers_.find(name);
-    if (it != loggers_.end()) {
+    const Registry *registry = registry_.load(std::memory_order_acquire);
+    auto it = registry->find(name);
+    if (it != registry->end()) {
         return it->second;
     }
-    return default_logger_; 
+    return this->default_logger();
 }
+
 std::shared_ptr<clia::log::trait::Logger> clia::log::LoggerManger::default_logger() noexcept {
+    // default_logger_ 在 default_ptr_ 发布之前写入，之后不再修改
+    if (nullptr == default_ptr()) {
+        return nullptr;
+    }
     return default_logger_;
 }
+
 void clia::log::LoggerManger::set_default(std::shared_ptr<clia::log::trait::Logger> logger) noexcept {
     std::lock_guard<std::mutex> lock(lck_);
-    if (!default_logger_) {
+    if (!default_logger_ && logger) {
         default_logger_ = std::move(logger);
+        default_ptr_.store(default_logger_.get(), std::memory_order_release);
     }
 }
 
 void clia::log::LoggerManger::register_logger(const std::string &name, std::shared_ptr<clia::log::trait::Logger> logger) noexcept {
     std::lock_guard<std::mutex> lock(lck_);
-    loggers_[name] = std::move(logger);
-}
\ No newline at end of file
+    trait::Logger *raw = logger.get();
+    std::unique_ptr<Registry> next(new Registry(*registry_.load(std::memory_order_relaxed)));
+    (*next)[name] = std::move(logger);
+    registry_.store(next.get(), std::memory_order_release);
+    snapshots_.push_back(std::move(next));
+    auto it = slots_.find(name);
+    if (it != slots_.end()) {
+        it->second->store(raw, std::memory_order_release);
+    }
+}
+
+bool clia::log::LoggerManger::set_level(const std::string &name, const Level level) noexcept {
+    trait::Logger *logger = nullptr;
+    if (name.empty()) {
+        logger = default_ptr();
+    } else {
+        const Registry *registry = registry_.load(std::memory_order_acquire);
+        auto it = registry->find(name);
+        if (it != registry->end()) {
+            logger = it->second.get();
+        }
+    }
+    if (nullptr == logger) {
+        return false;
+    }
+    logger->set_level(level);
+    return true;
+}
+
+const clia::log::LoggerManger::Slot* clia::log::LoggerManger::slot(const std::string &name) noexcept {
+    std::lock_guard<std::mutex> lock(lck_);
+    auto &slot = slots_[name];
+    if (!slot) {
+        const Registry *registry = registry_.load(std::memory_order_relaxed);
+        auto it = registry->find(name);
+        slot.reset(new Slot(it != registry->end() ? it->second.get() : nullptr));
+    }
+    return slot.get();
+}
@@ -9,7 +9,7 @@ clia::log::SyncLogger::SyncLogger(const Level level, std::shared_ptr<trait::Appe
 clia::log::SyncLogger::~SyncLogger() noexcept = default;
 
 void clia::log::SyncLogger::log(const Level level, const void *message, const std::size_t len) noexcept {
-    if (level < level_ || nullptr == message || 0 == len) {
+    if (level < this->level() || nullptr == message || 0 == len) {
         return; // Ignore messages below the current log level
     }
     appender_->append(message, len);
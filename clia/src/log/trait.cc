@@ -1,6 +1,7 @@
 #include <memory>
 
 #include "clia/log/trait.h"
+#include "clia/log/binary.h"
 
 const char* clia::log::level_to_string(const Level level) noexcept {
     switch (level) {
@@ -27,6 +28,8 @@ clia::log::trait::Logger::Logger(const Level level, std::shared_ptr<Appender> ap
     ;
 }
 
-clia::log::Level clia::log::trait::Logger::level() const noexcept {
-    return level_;
+void clia::log::trait::Logger::log_binary(const binary::Site *site, const void *record, const std::size_t len) noexcept {
+    char line[2 * binary::Encoder::kMaxSize];
+    const std::size_t n = binary::format(*site, record, len, line, sizeof(line));
+    this->log(site->level, line, n);
 }
\ No newline at end of file
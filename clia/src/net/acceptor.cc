@@ -1,8 +1,11 @@
 #include <cassert>
+#include <cerrno>
 #include <cstdlib>
 
 #include <unistd.h>
 #include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
 
 #include "clia/net/acceptor.h"
 #include "clia/log.h"
@@ -12,28 +15,68 @@
 #include "clia/util/process.h"
 #include "clia/reactor/event_loop.h"
 
+namespace {
+    // 上次进程退出时残留的 socket 文件会导致 bind 失败(EADDRINUSE)。
+    // 只删除确认没有进程在监听的 socket 文件：其他类型的文件以及仍能连上的 socket 都保留，bind 会以 EADDRINUSE 失败
+    void remove_stale_unix_socket(const ::sockaddr_un *addr, const ::socklen_t len) {
+        struct stat st;
+        if (::lstat(addr->sun_path, &st) != 0) {
+            return;
+        }
+        if (!S_ISSOCK(st.st_mode)) {
+            CLIA_FMT_LOG_ERROR("unix socket path [%s] exists and is not a socket", addr->sun_path);
+            return;
+        }
+        const int probe = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        if (probe < 0) {
+            return;
+        }
+        const int ret = ::connect(probe, reinterpret_cast<const ::sockaddr*>(addr), len);
+        const int err = errno;
+        ::close(probe);
+        if (ret < 0 && ECONNREFUSED == err) {
+            ::unlink(addr->sun_path);
+        } else {
+            CLIA_FMT_LOG_ERROR("unix socket path [%s] is in use by another listener", addr->sun_path);
+        }
+    }
+}
+
 clia::net::Acceptor::Acceptor(clia::reactor::EventLoop *loop, const InetAddress &listen_addr, const bool reuseport) 
     : loop_(loop)
     , listening_(false)
 {
-    const int listenfd = ::socket(listen_addr.family(), SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, IPPROTO_TCP);
-    if (-1 == listenfd) {
-        CLIA_FMT_LOG_FATAL("socket fail, errno = [%d][%s]", errno, clia::util::process::strerror((errno)));
-        std::abort();
-    }
-    
+    const int listenfd = Socket::create_nonblocking(listen_addr.family());
     accept_socket_.reset(new Socket(listenfd));
-    accept_socket_->set_reuse_addr(true);
-    accept_socket_->set_reuse_port(reuseport);
+    if (listen_addr.is_unix()) {
+        const auto *addr = reinterpret_cast<const ::sockaddr_un*>(listen_addr.get_sockaddr());
+        if (addr->sun_path[0] != '\0') {
+            ::remove_stale_unix_socket(addr, listen_addr.socklen());
+        }
+    } else {
+        accept_socket_->set_reuse_addr(true);
+        accept_socket_->set_reuse_port(reuseport);
+    }
     accept_socket_->bind_address(listen_addr);
 
     accept_channel_.reset(new clia::reactor::Channel(loop_, accept_socket_->fd()));
     accept_channel_->set_read_callback(std::bind(&Acceptor::handle_read, this));
 }
 
+clia::net::Acceptor::Acceptor(clia::reactor::EventLoop *loop, const int listenfd)
+    : loop_(loop)
+    , listening_(false)
+    , accept_socket_(new Socket(listenfd))
+    , accept_channel_(new clia::reactor::Channel(loop, listenfd))
+{
+    accept_channel_->set_read_callback(std::bind(&Acceptor::handle_read, this));
+}
+
 clia::net::Acceptor::~Acceptor() noexcept {
-    accept_channel_->disable_all();
-    accept_channel_->remove();
+    if (accept_channel_) {
+        accept_channel_->disable_all();
+        accept_channel_->remove();
+    }
 }
 
 void clia::net::Acceptor::set_new_connection_callback(const NewConnectionCallback &cb) {
@@ -42,6 +85,7 @@ void clia::net::Acceptor::set_new_connection_callback(const NewConnectionCallbac
 
 void clia::net::Acceptor::listen() noexcept {
     assert(loop_->is_in_loop_thread());
+    assert(accept_socket_ && accept_channel_);
     listening_ = true;
     accept_socket_->listen();
     accept_channel_->enable_reading();
@@ -51,8 +95,34 @@ bool clia::net::Acceptor::listening() const noexcept {
     return listening_;
 }
 
+void clia::net::Acceptor::stop_listening() noexcept {
+    assert(loop_->is_in_loop_thread());
+    if (!accept_channel_) {
+        return;
+    }
+    listening_ = false;
+    accept_channel_->disable_all();
+    // 可能正处于本轮事件处理中(如交接完成的回调)，channel 留到本轮之后再移除，socket 随之关闭
+    std::shared_ptr<clia::reactor::Channel> channel(std::move(accept_channel_));
+    std::shared_ptr<Socket> socket(std::move(accept_socket_));
+    loop_->queue_in_loop([channel, socket]() {
+        channel->remove();
+    });
+}
+
+int clia::net::Acceptor::fd() const noexcept {
+    return accept_socket_ ? accept_socket_->fd() : -1;
+}
+
+bool clia::net::Acceptor::attach_reuseport_cpu_steering(const std::vector<int> &cpu_to_index) {
+    return accept_socket_ && accept_socket_->attach_reuseport_cpu_steering(cpu_to_index);
+}
+
 void clia::net::Acceptor::handle_read() {
     assert(loop_->is_in_loop_thread());
+    if (!accept_socket_) {
+        return; // 本轮中已经 stop_listening
+    }
     InetAddress peer_addr;
     const int connfd = accept_socket_->accept(&peer_addr);
     if (connfd >= 0) {
@@ -62,6 +132,8 @@ void clia::net::Acceptor::handle_read() {
             ::close(connfd);
         }
     } else {
-        CLIA_FMT_LOG_ERROR("accept err: errno = [%d][%s]", errno, clia::util::process::strerror((errno)));
+        // fd 耗尽时监听套接字一直可读，每次循环都会失败
+        const int err = errno;
+        CLIA_FMT_LOG_RATE_LIMIT(clia::log::Level::kError, 10, 100, "accept err: errno = [%d][%s]", err, clia::util::process::strerror(err));
     }
 }
\ No newline at end of file
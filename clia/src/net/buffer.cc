@@ -1,11 +1,79 @@
+#include <algorithm>
 #include <cassert>
+#include <cerrno>
+#include <cstring>
 
+#include <endian.h>
 #include <unistd.h>
 #include <sys/uio.h>
 
 #include "clia/net/buffer.h"
 #include "clia/log.h"
 #include "clia/util/process.h"
+#include "clia/util/byte_search.h"
+
+namespace {
+    inline void store_be(unsigned char *p, const std::uint16_t x) noexcept {
+        const std::uint16_t be = htobe16(x);
+        std::memcpy(p, &be, sizeof(be));
+    }
+
+    inline void store_be(unsigned char *p, const std::uint32_t x) noexcept {
+        const std::uint32_t be = htobe32(x);
+        std::memcpy(p, &be, sizeof(be));
+    }
+
+    inline void store_be(unsigned char *p, const std::uint64_t x) noexcept {
+        const std::uint64_t be = htobe64(x);
+        std::memcpy(p, &be, sizeof(be));
+    }
+
+    template <typename T>
+    inline T load_be(const unsigned char *p) noexcept;
+
+    template <>
+    inline std::uint16_t load_be<std::uint16_t>(const unsigned char *p) noexcept {
+        std::uint16_t be = 0;
+        std::memcpy(&be, p, sizeof(be));
+        return be16toh(be);
+    }
+
+    template <>
+    inline std::uint32_t load_be<std::uint32_t>(const unsigned char *p) noexcept {
+        std::uint32_t be = 0;
+        std::memcpy(&be, p, sizeof(be));
+        return be32toh(be);
+    }
+
+    template <>
+    inline std::uint64_t load_be<std::uint64_t>(const unsigned char *p) noexcept {
+        std::uint64_t be = 0;
+        std::memcpy(&be, p, sizeof(be));
+        return be64toh(be);
+    }
+
+    // 返回写入的字节数，p 至少要有 kMaxVarintLen 字节空间
+    inline std::size_t encode_varint(unsigned char *p, std::uint64_t x) noexcept {
+        std::size_t n = 0;
+        while (x >= 0x80) {
+            p[n++] = static_cast<unsigned char>(x | 0x80);
+            x >>= 7;
+        }
+        p[n++] = static_cast<unsigned char>(x);
+        return n;
+    }
+
+    inline std::uint64_t zigzag_encode(const std::int64_t x) noexcept {
+        return (static_cast<std::uint64_t>(x) << 1) ^ static_cast<std::uint64_t>(x >> 63);
+    }
+
+    inline std::int64_t zigzag_decode(const std::uint64_t x) noexcept {
+        return static_cast<std::int64_t>((x >> 1) ^ (~(x & 1) + 1));
+    }
+}
+
+constexpr std::size_t clia::net::Buffer::kExtraReadSize;
+constexpr std::size_t clia::net::Buffer::kMaxVarintLen;
 
 clia::net::Buffer::Buffer(const std::size_t inital_size)
     : buffer_(kCheapPrepend + inital_size)
@@ -70,10 +138,18 @@ std::size_t clia::net::Buffer::prependable_bytes() const noexcept {
     return reader_index_;
 }
 
+clia::util::SlabPool::Stats clia::net::Buffer::pool_stats() {
+    return clia::util::SlabPool::aggregate(PoolTag::name());
+}
+
 const unsigned char* clia::net::Buffer::peek() const noexcept {
     return this->begin() + reader_index_;
 }
 
+unsigned char* clia::net::Buffer::peek() noexcept {
+    return this->begin() + reader_index_;
+}
+
 void clia::net::Buffer::retrieve(const std::size_t len) noexcept {
     assert(len <= readable_bytes());
     if (len < readable_bytes()) {
@@ -113,6 +189,18 @@ void clia::net::Buffer::append(const void *data, const std::size_t len) {
     writer_index_ += len;
 }
 
+void clia::net::Buffer::prepend(const void *data, const std::size_t len) noexcept {
+    assert(len <= this->prependable_bytes());
+    reader_index_ -= len;
+    const unsigned char *p = static_cast<const unsigned char*>(data);
+    std::copy(p, p + len, this->begin() + reader_index_);
+}
+
+void clia::net::Buffer::has_written(const std::size_t len) noexcept {
+    assert(len <= this->writable_bytes());
+    writer_index_ += len;
+}
+
 unsigned char* clia::net::Buffer::begin_write() noexcept {
     return this->begin() + writer_index_;
 }
@@ -122,7 +210,7 @@ const unsigned char* clia::net::Buffer::begin_write() const noexcept {
 }
 
 ::ssize_t clia::net::Buffer::read_fd(const int fd) noexcept {
-    unsigned char extrabuf[65536];
+    unsigned char extrabuf[kExtraReadSize];
     const auto writable = this->writable_bytes();
     const int kIovCnt = 2;
     ::iovec vec[kIovCnt];
@@ -135,28 +223,282 @@ const unsigned char* clia::net::Buffer::begin_write() const noexcept {
 
     const auto n = ::readv(fd, vec, kIovCnt);
     if (n < 0) {
-        CLIA_FMT_LOG_ERROR("fd = [%d], readv fail, errno = [%d][%s]", fd, errno, clia::util::process::strerror(errno));
+        const int err = errno;
+        if (err != EAGAIN && err != EWOULDBLOCK) {
+            // 故障期间每个连接都可能反复失败，限流避免日志本身加重故障
+            CLIA_FMT_LOG_RATE_LIMIT(clia::log::Level::kError, 10, 100, "fd = [%d], readv fail, errno = [%d][%s]", fd, err, clia::util::process::strerror(err));
+        }
+        // 调用方根据 errno 区分 EAGAIN 与真正的错误，写日志可能改写 errno
+        errno = err;
     } else if (n <= writable) {
         writer_index_ += n;
     } else {
         writer_index_ += writable;
         this->append(extrabuf, n - writable);
     }
-    std::memcpy(extrabuf, this->peek(), this->readable_bytes());
-    *(extrabuf + this->readable_bytes()) = '\0';
     return n;
 }
 
 ::ssize_t clia::net::Buffer::write_fd(int fd) noexcept {
     const auto n = ::write(fd, this->peek(), this->readable_bytes());
     if (n < 0) {
-        CLIA_FMT_LOG_ERROR("write fail, errno = [%d][%s]", errno, clia::util::process::strerror(errno));
+        const int err = errno;
+        CLIA_FMT_LOG_RATE_LIMIT(clia::log::Level::kError, 10, 100, "write fail, errno = [%d][%s]", err, clia::util::process::strerror(err));
+        errno = err;
     } else {
         this->retrieve(n);
     }
     return n;
 }
 
+void clia::net::Buffer::append_int8(const std::int8_t x) {
+    this->append(&x, sizeof(x));
+}
+
+void clia::net::Buffer::append_int16(const std::int16_t x) {
+    this->ensure_writable_bytes(sizeof(x));
+    ::store_be(this->begin_write(), static_cast<std::uint16_t>(x));
+    writer_index_ += sizeof(x);
+}
+
+void clia::net::Buffer::append_int32(const std::int32_t x) {
+    this->ensure_writable_bytes(sizeof(x));
+    ::store_be(this->begin_write(), static_cast<std::uint32_t>(x));
+    writer_index_ += sizeof(x);
+}
+
+void clia::net::Buffer::append_int64(const std::int64_t x) {
+    this->ensure_writable_bytes(sizeof(x));
+    ::store_be(this->begin_write(), static_cast<std::uint64_t>(x));
+    writer_index_ += sizeof(x);
+}
+
+std::int8_t clia::net::Buffer::peek_int8() const noexcept {
+    assert(this->readable_bytes() >= sizeof(std::int8_t));
+    return static_cast<std::int8_t>(*this->peek());
+}
+
+std::int16_t clia::net::Buffer::peek_int16() const noexcept {
+    assert(this->readable_bytes() >= sizeof(std::int16_t));
+    return static_cast<std::int16_t>(::load_be<std::uint16_t>(this->peek()));
+}
+
+std::int32_t clia::net::Buffer::peek_int32() const noexcept {
+    assert(this->readable_bytes() >= sizeof(std::int32_t));
+    return static_cast<std::int32_t>(::load_be<std::uint32_t>(this->peek()));
+}
+
+std::int64_t clia::net::Buffer::peek_int64() const noexcept {
+    assert(this->readable_bytes() >= sizeof(std::int64_t));
+    return static_cast<std::int64_t>(::load_be<std::uint64_t>(this->peek()));
+}
+
+std::int8_t clia::net::Buffer::read_int8() noexcept {
+    const auto x = this->peek_int8();
+    this->retrieve(sizeof(x));
+    return x;
+}
+
+std::int16_t clia::net::Buffer::read_int16() noexcept {
+    const auto x = this->peek_int16();
+    this->retrieve(sizeof(x));
+    return x;
+}
+
+std::int32_t clia::net::Buffer::read_int32() noexcept {
+    const auto x = this->peek_int32();
+    this->retrieve(sizeof(x));
+    return x;
+}
+
+std::int64_t clia::net::Buffer::read_int64() noexcept {
+    const auto x = this->peek_int64();
+    this->retrieve(sizeof(x));
+    return x;
+}
+
+void clia::net::Buffer::prepend_int8(const std::int8_t x) noexcept {
+    this->prepend(&x, sizeof(x));
+}
+
+void clia::net::Buffer::prepend_int16(const std::int16_t x) noexcept {
+    assert(sizeof(x) <= this->prependable_bytes());
+    reader_index_ -= sizeof(x);
+    ::store_be(this->peek(), static_cast<std::uint16_t>(x));
+}
+
+void clia::net::Buffer::prepend_int32(const std::int32_t x) noexcept {
+    assert(sizeof(x) <= this->prependable_bytes());
+    reader_index_ -= sizeof(x);
+    ::store_be(this->peek(), static_cast<std::uint32_t>(x));
+}
+
+void clia::net::Buffer::prepend_int64(const std::int64_t x) noexcept {
+    assert(sizeof(x) <= this->prependable_bytes());
+    reader_index_ -= sizeof(x);
+    ::store_be(this->peek(), static_cast<std::uint64_t>(x));
+}
+
+void clia::net::Buffer::append_varint(const std::uint64_t x) {
+    this->ensure_writable_bytes(kMaxVarintLen);
+    writer_index_ += ::encode_varint(this->begin_write(), x);
+}
+
+void clia::net::Buffer::append_svarint(const std::int64_t x) {
+    this->append_varint(::zigzag_encode(x));
+}
+
+int clia::net::Buffer::peek_varint(std::uint64_t *x) const noexcept {
+    const unsigned char *p = this->peek();
+    const std::size_t limit = std::min(this->readable_bytes(), kMaxVarintLen);
+    std::uint64_t value = 0;
+    for (std::size_t i = 0; i < limit; ++i) {
+        value |= static_cast<std::uint64_t>(p[i] & 0x7f) << (7 * i);
+        if (0 == (p[i] & 0x80)) {
+            *x = value;
+            return static_cast<int>(i + 1);
+        }
+    }
+    return limit == kMaxVarintLen ? -1 : 0;
+}
+
+int clia::net::Buffer::read_varint(std::uint64_t *x) noexcept {
+    const int n = this->peek_varint(x);
+    if (n > 0) {
+        this->retrieve(static_cast<std::size_t>(n));
+    }
+    return n;
+}
+
+int clia::net::Buffer::read_svarint(std::int64_t *x) noexcept {
+    std::uint64_t value = 0;
+    const int n = this->read_varint(&value);
+    if (n > 0) {
+        *x = ::zigzag_decode(value);
+    }
+    return n;
+}
+
+clia::net::Buffer::Builder::Builder(Buffer *buf, const std::size_t max_len)
+    : buf_((buf->ensure_writable_bytes(max_len), buf))
+    , begin_(buf->begin_write())
+    , cur_(begin_)
+    , end_(begin_ + max_len)
+{
+    ;
+}
+
+clia::net::Buffer::Builder::~Builder() noexcept {
+    this->commit();
+}
+
+clia::net::Buffer::Builder& clia::net::Buffer::Builder::put_int8(const std::int8_t x) noexcept {
+    assert(cur_ + sizeof(x) <= end_);
+    *cur_++ = static_cast<unsigned char>(x);
+    return *this;
+}
+
+clia::net::Buffer::Builder& clia::net::Buffer::Builder::put_int16(const std::int16_t x) noexcept {
+    assert(cur_ + sizeof(x) <= end_);
+    ::store_be(cur_, static_cast<std::uint16_t>(x));
+    cur_ += sizeof(x);
+    return *this;
+}
+
+clia::net::Buffer::Builder& clia::net::Buffer::Builder::put_int32(const std::int32_t x) noexcept {
+    assert(cur_ + sizeof(x) <= end_);
+    ::store_be(cur_, static_cast<std::uint32_t>(x));
+    cur_ += sizeof(x);
+    return *this;
+}
+
+clia::net::Buffer::Builder& clia::net::Buffer::Builder::put_int64(const std::int64_t x) noexcept {
+    assert(cur_ + sizeof(x) <= end_);
+    ::store_be(cur_, static_cast<std::uint64_t>(x));
+    cur_ += sizeof(x);
+    return *this;
+}
+
+clia::net::Buffer::Builder& clia::net::Buffer::Builder::put_varint(const std::uint64_t x) noexcept {
+    assert(cur_ + Buffer::kMaxVarintLen <= end_);
+    cur_ += ::encode_varint(cur_, x);
+    return *this;
+}
+
+clia::net::Buffer::Builder& clia::net::Buffer::Builder::put_svarint(const std::int64_t x) noexcept {
+    return this->put_varint(::zigzag_encode(x));
+}
+
+clia::net::Buffer::Builder& clia::net::Buffer::Builder::put_bytes(const void *data, const std::size_t len) noexcept {
+    assert(cur_ + len <= end_);
+    std::memcpy(cur_, data, len);
+    cur_ += len;
+    return *this;
+}
+
+std::size_t clia::net::Buffer::Builder::size() const noexcept {
+    return static_cast<std::size_t>(cur_ - begin_);
+}
+
+void clia::net::Buffer::Builder::commit() noexcept {
+    // 可以多次提交，每次只提交上次之后新写入的部分
+    if (cur_ != begin_) {
+        buf_->has_written(this->size());
+        begin_ = cur_;
+    }
+}
+
+const unsigned char* clia::net::Buffer::find_crlf() const noexcept {
+    return clia::util::byte_search::find_crlf(this->peek(), this->begin_write());
+}
+
+const unsigned char* clia::net::Buffer::find_crlf(std::size_t *resume) const noexcept {
+    assert(resume != nullptr && *resume <= this->readable_bytes());
+    const auto hit = clia::util::byte_search::find_crlf(this->peek() + *resume, this->begin_write());
+    // '\r' 可能是最后一个字节，下次需要从它开始重新匹配
+    return this->update_resume(hit, resume, 1);
+}
+
+const unsigned char* clia::net::Buffer::find_eol() const noexcept {
+    return clia::util::byte_search::find_byte(this->peek(), this->begin_write(), '\n');
+}
+
+const unsigned char* clia::net::Buffer::find_eol(std::size_t *resume) const noexcept {
+    return this->find_byte('\n', resume);
+}
+
+const unsigned char* clia::net::Buffer::find_byte(const unsigned char c) const noexcept {
+    return clia::util::byte_search::find_byte(this->peek(), this->begin_write(), c);
+}
+
+const unsigned char* clia::net::Buffer::find_byte(const unsigned char c, std::size_t *resume) const noexcept {
+    assert(resume != nullptr && *resume <= this->readable_bytes());
+    const auto hit = clia::util::byte_search::find_byte(this->peek() + *resume, this->begin_write(), c);
+    return this->update_resume(hit, resume, 0);
+}
+
+const unsigned char* clia::net::Buffer::find_any_of(const char *set, const std::size_t set_len) const noexcept {
+    return clia::util::byte_search::find_any_of(this->peek(), this->begin_write(),
+        reinterpret_cast<const unsigned char*>(set), set_len);
+}
+
+const unsigned char* clia::net::Buffer::find_any_of(const char *set, const std::size_t set_len, std::size_t *resume) const noexcept {
+    assert(resume != nullptr && *resume <= this->readable_bytes());
+    const auto hit = clia::util::byte_search::find_any_of(this->peek() + *resume, this->begin_write(),
+        reinterpret_cast<const unsigned char*>(set), set_len);
+    return this->update_resume(hit, resume, 0);
+}
+
+const unsigned char* clia::net::Buffer::update_resume(const unsigned char *hit, std::size_t *resume, const std::size_t overlap) const noexcept {
+    if (hit != nullptr) {
+        *resume = hit - this->peek();
+    } else {
+        const auto readable = this->readable_bytes();
+        *resume = readable > overlap ? readable - overlap : 0;
+    }
+    return hit;
+}
+
 unsigned char* clia::net::Buffer::begin() noexcept {
     return buffer_.data();
 }
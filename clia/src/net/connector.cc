@@ -0,0 +1,248 @@
+#include <algorithm>
+#include <cassert>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+
+#include <unistd.h>
+#include <sys/socket.h>
+
+#include "clia/net/connector.h"
+#include "clia/log.h"
+#include "clia/net/socket.h"
+#include "clia/reactor/channel.h"
+#include "clia/reactor/event_loop.h"
+#include "clia/util/process.h"
+
+namespace {
+    int get_socket_error(const int sockfd) noexcept {
+        int optval = 0;
+        ::socklen_t optlen = static_cast<::socklen_t>(sizeof(optval));
+        if (::getsockopt(sockfd, SOL_SOCKET, SO_ERROR, &optval, &optlen) < 0) {
+            return errno;
+        }
+        return optval;
+    }
+
+    // 本地端口与目标端口相同时，内核可能让 socket 连上自己(TCP 同时打开)
+    bool is_self_connect(const int sockfd) noexcept {
+        ::sockaddr_in6 local;
+        ::sockaddr_in6 peer;
+        std::memset(&local, 0, sizeof(local));
+        std::memset(&peer, 0, sizeof(peer));
+        ::socklen_t local_len = static_cast<::socklen_t>(sizeof(local));
+        ::socklen_t peer_len = static_cast<::socklen_t>(sizeof(peer));
+        if (::getsockname(sockfd, reinterpret_cast<::sockaddr*>(&local), &local_len) < 0
+            || ::getpeername(sockfd, reinterpret_cast<::sockaddr*>(&peer), &peer_len) < 0) {
+            return false;
+        }
+        if (AF_INET == local.sin6_family) {
+            const auto *laddr = reinterpret_cast<const ::sockaddr_in*>(&local);
+            const auto *raddr = reinterpret_cast<const ::sockaddr_in*>(&peer);
+            return laddr->sin_port == raddr->sin_port && laddr->sin_addr.s_addr == raddr->sin_addr.s_addr;
+        } else if (AF_INET6 == local.sin6_family) {
+            return local.sin6_port == peer.sin6_port
+                && 0 == std::memcmp(&local.sin6_addr, &peer.sin6_addr, sizeof(local.sin6_addr));
+        }
+        return false;
+    }
+}
+
+constexpr int clia::net::Connector::kInitRetryDelayMs;
+constexpr int clia::net::Connector::kMaxRetryDelayMs;
+
+clia::net::Connector::Connector(clia::reactor::EventLoop *loop, const InetAddress &server_addr)
+    : loop_(loop)
+    , server_addr_(server_addr)
+    , connect_(false)
+    , state_(State::kDisconnected)
+    , init_retry_delay_ms_(kInitRetryDelayMs)
+    , max_retry_delay_ms_(kMaxRetryDelayMs)
+    , retry_delay_ms_(kInitRetryDelayMs)
+    , rng_(std::random_device{}())
+{
+    assert(loop_ != nullptr);
+}
+
+clia::net::Connector::~Connector() {
+    assert(!channel_);
+    if (retry_timer_.valid()) {
+        loop_->cancel(retry_timer_);
+    }
+}
+
+void clia::net::Connector::set_new_connection_callback(const NewConnectionCallback &cb) {
+    new_connection_callback_ = cb;
+}
+
+void clia::net::Connector::set_retry_delay(const int init_ms, const int max_ms) noexcept {
+    init_retry_delay_ms_ = std::max(init_ms, 1);
+    max_retry_delay_ms_ = std::max(max_ms, init_retry_delay_ms_);
+    retry_delay_ms_ = init_retry_delay_ms_;
+}
+
+const clia::net::InetAddress& clia::net::Connector::server_addr() const noexcept {
+    return server_addr_;
+}
+
+void clia::net::Connector::start() {
+    connect_ = true;
+    loop_->run_in_loop(std::bind(&Connector::start_in_loop, this->shared_from_this()));
+}
+
+void clia::net::Connector::restart() {
+    assert(loop_->is_in_loop_thread());
+    this->set_state(State::kDisconnected);
+    retry_delay_ms_ = init_retry_delay_ms_;
+    connect_ = true;
+    this->start_in_loop();
+}
+
+void clia::net::Connector::stop() {
+    connect_ = false;
+    loop_->queue_in_loop(std::bind(&Connector::stop_in_loop, this->shared_from_this()));
+}
+
+void clia::net::Connector::set_state(const State state) noexcept {
+    state_ = state;
+}
+
+void clia::net::Connector::start_in_loop() {
+    assert(loop_->is_in_loop_thread());
+    retry_timer_ = clia::reactor::TimerId();
+    if (State::kDisconnected != state_) {
+        return;
+    }
+    if (connect_) {
+        this->connect();
+    } else {
+        CLIA_LOG_DEBUG << "Connector::start_in_loop do not connect";
+    }
+}
+
+void clia::net::Connector::stop_in_loop() {
+    assert(loop_->is_in_loop_thread());
+    if (retry_timer_.valid()) {
+        loop_->cancel(retry_timer_);
+        retry_timer_ = clia::reactor::TimerId();
+    }
+    if (State::kConnecting == state_) {
+        this->set_state(State::kDisconnected);
+        const int sockfd = this->remove_and_reset_channel();
+        this->retry(sockfd);
+    }
+}
+
+void clia::net::Connector::connect() {
+    const int sockfd = Socket::create_nonblocking(server_addr_.family());
+    const int ret = ::connect(sockfd, server_addr_.get_sockaddr(), server_addr_.socklen());
+    const int saved_errno = (0 == ret) ? 0 : errno;
+    switch (saved_errno) {
+    case 0:
+    case EINPROGRESS:
+    case EINTR:
+    case EISCONN:
+        this->connecting(sockfd);
+        break;
+    case EAGAIN:
+    case EADDRINUSE:
+    case EADDRNOTAVAIL:
+    case ECONNREFUSED:
+    case ENETUNREACH:
+    case EHOSTUNREACH:
+    case ETIMEDOUT:
+    case ENOENT:        // Unix 域 socket 文件尚未创建
+        this->retry(sockfd);
+        break;
+    default:
+        // EACCES、EPERM、EAFNOSUPPORT 等不可恢复的错误，重试没有意义
+        CLIA_FMT_LOG_ERROR("connect %s fail, errno = [%d][%s]", server_addr_.get_addr().c_str(),
+            saved_errno, clia::util::process::strerror(saved_errno));
+        ::close(sockfd);
+        break;
+    }
+}
+
+void clia::net::Connector::connecting(const int sockfd) {
+    this->set_state(State::kConnecting);
+    assert(!channel_);
+    channel_.reset(new clia::reactor::Channel(loop_, sockfd));
+    channel_->set_write_callback(std::bind(&Connector::handle_write, this));
+    channel_->set_error_callback(std::bind(&Connector::handle_error, this));
+    channel_->enable_writing();
+}
+
+void clia::net::Connector::handle_write() {
+    if (State::kConnecting != state_) {
+        assert(State::kDisconnected == state_);
+        return;
+    }
+    const int sockfd = this->remove_and_reset_channel();
+    const int err = ::get_socket_error(sockfd);
+    if (err != 0) {
+        CLIA_FMT_LOG_WARN("connect %s fail, SO_ERROR = [%d][%s]", server_addr_.get_addr().c_str(),
+            err, clia::util::process::strerror(err));
+        this->retry(sockfd);
+    } else if (::is_self_connect(sockfd)) {
+        CLIA_LOG_WARN << "Connector::handle_write - self connect " << server_addr_.get_addr();
+        this->retry(sockfd);
+    } else {
+        this->set_state(State::kConnected);
+        retry_delay_ms_ = init_retry_delay_ms_;
+        if (connect_ && new_connection_callback_) {
+            new_connection_callback_(sockfd);
+        } else {
+            ::close(sockfd);
+        }
+    }
+}
+
+void clia::net::Connector::handle_error() {
+    if (State::kConnecting == state_) {
+        const int sockfd = this->remove_and_reset_channel();
+        const int err = ::get_socket_error(sockfd);
+        CLIA_FMT_LOG_WARN("connect %s error, SO_ERROR = [%d][%s]", server_addr_.get_addr().c_str(),
+            err, clia::util::process::strerror(err));
+        this->retry(sockfd);
+    }
+}
+
+void clia::net::Connector::retry(const int sockfd) {
+    ::close(sockfd);
+    this->set_state(State::kDisconnected);
+    if (!connect_) {
+        CLIA_LOG_DEBUG << "Connector::retry do not connect";
+        return;
+    }
+    const int delay_ms = this->next_retry_delay_ms();
+    CLIA_LOG_INFO << "Connector::retry connecting to " << server_addr_.get_addr() << " in " << delay_ms << " ms";
+    // 定时器只持有弱引用，Connector 析构后回调自动失效
+    std::weak_ptr<Connector> weak_self(this->shared_from_this());
+    retry_timer_ = loop_->run_after(delay_ms / 1000.0, [weak_self]() {
+        const auto self = weak_self.lock();
+        if (self) {
+            self->start_in_loop();
+        }
+    });
+}
+
+int clia::net::Connector::remove_and_reset_channel() {
+    channel_->disable_all();
+    channel_->remove();
+    const int sockfd = channel_->fd();
+    // 当前可能正处于 channel_ 的事件回调中，不能在这里直接释放
+    loop_->queue_in_loop(std::bind(&Connector::reset_channel, this->shared_from_this()));
+    return sockfd;
+}
+
+void clia::net::Connector::reset_channel() {
+    channel_.reset();
+}
+
+// 等抖动(equal jitter)：在 [上限/2, 上限] 内随机，既保证退避又把重连时间打散
+int clia::net::Connector::next_retry_delay_ms() {
+    const int ceiling = retry_delay_ms_;
+    std::uniform_int_distribution<int> dist(ceiling / 2, ceiling);
+    retry_delay_ms_ = (retry_delay_ms_ > max_retry_delay_ms_ / 2) ? max_retry_delay_ms_ : retry_delay_ms_ * 2;
+    return dist(rng_);
+}
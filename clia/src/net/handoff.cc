@@ -0,0 +1,307 @@
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+
+#include "clia/net/handoff.h"
+#include "clia/log.h"
+#include "clia/util/process.h"
+
+namespace {
+    constexpr std::uint32_t kMagic = 0x4f484c43;    // "CLHO"
+    constexpr std::uint16_t kVersion = 1;
+
+    enum MessageType : std::uint16_t {
+        kListener = 1,      // 携带一个监听 socket
+        kConnections = 2,   // 携带 count 个连接，其后跟 count 个 PeerEntry
+        kEnd = 3,
+        kReady = 4,         // 新进程 -> 旧进程
+    };
+
+    struct Header {
+        std::uint32_t magic;
+        std::uint16_t version;
+        std::uint16_t type;
+        std::uint32_t count;
+        std::uint32_t reserved;
+    };
+
+    struct PeerEntry {
+        std::uint32_t len;
+        std::uint32_t reserved;
+        ::sockaddr_storage addr;
+    };
+
+    Header make_header(const std::uint16_t type, const std::uint32_t count) noexcept {
+        Header header;
+        std::memset(&header, 0, sizeof(header));
+        header.magic = kMagic;
+        header.version = kVersion;
+        header.type = type;
+        header.count = count;
+        return header;
+    }
+
+    ::timeval to_timeval(const double sec) noexcept {
+        ::timeval tv;
+        tv.tv_sec = static_cast<::time_t>(sec);
+        tv.tv_usec = static_cast<::suseconds_t>((sec - tv.tv_sec) * 1000 * 1000);
+        return tv;
+    }
+
+    bool write_all(const int sock, const unsigned char *data, std::size_t len) noexcept {
+        while (len > 0) {
+            const ::ssize_t n = ::send(sock, data, len, MSG_NOSIGNAL);
+            if (n < 0) {
+                if (EINTR == errno) {
+                    continue;
+                }
+                return false;
+            }
+            data += n;
+            len -= static_cast<std::size_t>(n);
+        }
+        return true;
+    }
+
+    bool read_all(const int sock, unsigned char *data, std::size_t len) noexcept {
+        while (len > 0) {
+            const ::ssize_t n = ::recv(sock, data, len, 0);
+            if (n <= 0) {
+                if (n < 0 && EINTR == errno) {
+                    continue;
+                }
+                return false;
+            }
+            data += n;
+            len -= static_cast<std::size_t>(n);
+        }
+        return true;
+    }
+
+    // 读取消息头以及随之到达的文件描述符，fds 至少能容纳 kMaxFdsPerMessage 个
+    bool recv_header(const int sock, Header *header, int *fds, std::size_t *nfds) noexcept {
+        alignas(::cmsghdr) unsigned char control[CMSG_SPACE(sizeof(int) * clia::net::handoff::kMaxFdsPerMessage)];
+        ::iovec iov;
+        iov.iov_base = header;
+        iov.iov_len = sizeof(*header);
+        ::msghdr msg;
+        std::memset(&msg, 0, sizeof(msg));
+        msg.msg_iov = &iov;
+        msg.msg_iovlen = 1;
+        msg.msg_control = control;
+        msg.msg_controllen = sizeof(control);
+        ::ssize_t n = 0;
+        do {
+            n = ::recvmsg(sock, &msg, MSG_CMSG_CLOEXEC);
+        } while (n < 0 && EINTR == errno);
+        if (n <= 0) {
+            return false;
+        }
+        *nfds = 0;
+        for (::cmsghdr *cmsg = CMSG_FIRSTHDR(&msg); cmsg != nullptr; cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+            if (SOL_SOCKET == cmsg->cmsg_level && SCM_RIGHTS == cmsg->cmsg_type) {
+                const std::size_t count = (cmsg->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+                std::memcpy(fds + *nfds, CMSG_DATA(cmsg), sizeof(int) * count);
+                *nfds += count;
+            }
+        }
+        if (msg.msg_flags & MSG_CTRUNC) {
+            CLIA_LOG_ERROR << "handoff: control message truncated";
+            return false;
+        }
+        if (static_cast<std::size_t>(n) < sizeof(*header)
+            && !::read_all(sock, reinterpret_cast<unsigned char*>(header) + n, sizeof(*header) - n)) {
+            return false;
+        }
+        return kMagic == header->magic && kVersion == header->version;
+    }
+
+    void close_state(clia::net::HandoffState *state) noexcept {
+        if (state->listen_fd >= 0) {
+            ::close(state->listen_fd);
+        }
+        for (const auto &conn : state->connections) {
+            ::close(conn.first);
+        }
+        if (state->channel_fd >= 0) {
+            ::close(state->channel_fd);
+        }
+        *state = clia::net::HandoffState();
+    }
+}
+
+clia::net::handoff::Sender::Sender(const int listen_fd, const std::vector<std::pair<int, InetAddress>> &connections)
+    : index_(0)
+    , offset_(0)
+{
+    const auto add = [this](const Header &header, const int *fds, const std::size_t nfds, const void *payload, const std::size_t len) {
+        Message msg;
+        msg.data.resize(sizeof(header) + len);
+        std::memcpy(msg.data.data(), &header, sizeof(header));
+        if (len > 0) {
+            std::memcpy(msg.data.data() + sizeof(header), payload, len);
+        }
+        msg.fds.assign(fds, fds + nfds);
+        messages_.push_back(std::move(msg));
+    };
+    add(::make_header(kListener, 0), &listen_fd, 1, nullptr, 0);
+    std::vector<int> fds;
+    std::vector<PeerEntry> peers;
+    for (std::size_t i = 0; i < connections.size(); i += kMaxFdsPerMessage) {
+        const std::size_t count = std::min(kMaxFdsPerMessage, connections.size() - i);
+        fds.resize(count);
+        peers.resize(count);
+        for (std::size_t j = 0; j < count; ++j) {
+            const auto &conn = connections[i + j];
+            fds[j] = conn.first;
+            std::memset(&peers[j], 0, sizeof(PeerEntry));
+            peers[j].len = conn.second.socklen();
+            std::memcpy(&peers[j].addr, conn.second.get_sockaddr(), peers[j].len);
+        }
+        add(::make_header(kConnections, static_cast<std::uint32_t>(count)), fds.data(), count, peers.data(), sizeof(PeerEntry) * count);
+    }
+    add(::make_header(kEnd, 0), nullptr, 0, nullptr, 0);
+}
+
+int clia::net::handoff::Sender::write(const int sock) noexcept {
+    alignas(::cmsghdr) unsigned char control[CMSG_SPACE(sizeof(int) * kMaxFdsPerMessage)];
+    while (index_ < messages_.size()) {
+        const Message &message = messages_[index_];
+        ::iovec iov;
+        iov.iov_base = const_cast<unsigned char*>(message.data.data()) + offset_;
+        iov.iov_len = message.data.size() - offset_;
+        ::msghdr msg;
+        std::memset(&msg, 0, sizeof(msg));
+        msg.msg_iov = &iov;
+        msg.msg_iovlen = 1;
+        // 文件描述符附着在消息的第一个字节上，sendmsg 成功(哪怕只写出部分数据)即全部随之发出
+        if (0 == offset_ && !message.fds.empty()) {
+            const std::size_t nfds = message.fds.size();
+            std::memset(control, 0, sizeof(control));
+            msg.msg_control = control;
+            msg.msg_controllen = CMSG_SPACE(sizeof(int) * nfds);
+            ::cmsghdr *cmsg = CMSG_FIRSTHDR(&msg);
+            cmsg->cmsg_level = SOL_SOCKET;
+            cmsg->cmsg_type = SCM_RIGHTS;
+            cmsg->cmsg_len = CMSG_LEN(sizeof(int) * nfds);
+            std::memcpy(CMSG_DATA(cmsg), message.fds.data(), sizeof(int) * nfds);
+        }
+        const ::ssize_t n = ::sendmsg(sock, &msg, MSG_NOSIGNAL | MSG_DONTWAIT);
+        if (n < 0) {
+            if (EINTR == errno) {
+                continue;
+            }
+            if (EAGAIN == errno || EWOULDBLOCK == errno) {
+                return 0;
+            }
+            CLIA_FMT_LOG_ERROR("handoff send fail, errno = [%d][%s]", errno, clia::util::process::strerror(errno));
+            return -1;
+        }
+        offset_ += static_cast<std::size_t>(n);
+        if (offset_ == message.data.size()) {
+            ++index_;
+            offset_ = 0;
+        }
+    }
+    return 1;
+}
+
+int clia::net::handoff::read_ready(const int sock) noexcept {
+    Header header;
+    const ::ssize_t n = ::recv(sock, &header, sizeof(header), MSG_DONTWAIT);
+    if (n < 0 && (EAGAIN == errno || EWOULDBLOCK == errno || EINTR == errno)) {
+        return 0;
+    }
+    if (n != static_cast<::ssize_t>(sizeof(header)) || header.magic != kMagic || header.type != kReady) {
+        return -1;
+    }
+    return 1;
+}
+
+bool clia::net::handoff::receive(const InetAddress &addr, HandoffState *state, const double timeout_sec) noexcept {
+    *state = HandoffState();
+    state->channel_fd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (state->channel_fd < 0) {
+        CLIA_FMT_LOG_ERROR("handoff socket fail, errno = [%d][%s]", errno, clia::util::process::strerror(errno));
+        return false;
+    }
+    const ::timeval tv = ::to_timeval(timeout_sec);
+    ::setsockopt(state->channel_fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+    ::setsockopt(state->channel_fd, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+    if (::connect(state->channel_fd, addr.get_sockaddr(), addr.socklen()) < 0) {
+        // 没有旧进程在等待交接，属于正常的冷启动
+        CLIA_FMT_LOG_INFO("handoff connect %s fail, errno = [%d][%s]", addr.get_addr().c_str(), errno, clia::util::process::strerror(errno));
+        ::close_state(state);
+        return false;
+    }
+
+    int fds[kMaxFdsPerMessage];
+    std::vector<PeerEntry> peers;
+    while (true) {
+        Header header;
+        std::size_t nfds = 0;
+        if (!::recv_header(state->channel_fd, &header, fds, &nfds)) {
+            CLIA_FMT_LOG_ERROR("handoff receive fail, errno = [%d][%s]", errno, clia::util::process::strerror(errno));
+            for (std::size_t i = 0; i < nfds; ++i) {
+                ::close(fds[i]);
+            }
+            ::close_state(state);
+            return false;
+        }
+        bool ok = true;
+        if (kListener == header.type && 1 == nfds && state->listen_fd < 0) {
+            state->listen_fd = fds[0];
+        } else if (kConnections == header.type && header.count == nfds) {
+            peers.resize(nfds);
+            ok = ::read_all(state->channel_fd, reinterpret_cast<unsigned char*>(peers.data()), sizeof(PeerEntry) * nfds);
+            for (std::size_t i = 0; ok && i < nfds; ++i) {
+                const auto len = std::min<::socklen_t>(peers[i].len, sizeof(::sockaddr_storage));
+                state->connections.emplace_back(fds[i], InetAddress(reinterpret_cast<const ::sockaddr*>(&peers[i].addr), len));
+            }
+        } else if (kEnd == header.type && 0 == nfds) {
+            break;
+        } else {
+            ok = false;
+        }
+        if (!ok) {
+            CLIA_LOG_ERROR << "handoff: unexpected message type " << header.type << " with " << nfds << " fds";
+            for (std::size_t i = 0; i < nfds; ++i) {
+                if (fds[i] != state->listen_fd) {
+                    ::close(fds[i]);
+                }
+            }
+            ::close_state(state);
+            return false;
+        }
+    }
+    if (!state->valid()) {
+        ::close_state(state);
+        return false;
+    }
+    CLIA_LOG_INFO << "handoff received listener and " << state->connections.size() << " connections from " << addr.get_addr();
+    return true;
+}
+
+bool clia::net::handoff::notify_ready(HandoffState *state) noexcept {
+    if (state->channel_fd < 0) {
+        return false;
+    }
+    const Header header = ::make_header(kReady, 0);
+    const bool ok = ::write_all(state->channel_fd, reinterpret_cast<const unsigned char*>(&header), sizeof(header));
+    if (!ok) {
+        CLIA_FMT_LOG_ERROR("handoff notify fail, errno = [%d][%s]", errno, clia::util::process::strerror(errno));
+    } else {
+        // 旧进程删除交接 socket 文件后才关闭连接，读到 EOF(或超时)之后本进程才能在同一路径上 enable_handoff
+        unsigned char byte;
+        while (::recv(state->channel_fd, &byte, sizeof(byte), 0) < 0 && EINTR == errno) {
+        }
+    }
+    ::close(state->channel_fd);
+    state->channel_fd = -1;
+    return ok;
+}
@@ -1,4 +1,6 @@
+#include <algorithm>
 #include <cassert>
+#include <cstddef>
 #include <cstring>
 
 #include <endian.h>
@@ -9,11 +11,15 @@
 #include "clia/util/process.h"
 #include "clia/net/inet_address.h"
 
-clia::net::InetAddress::InetAddress() noexcept {
-    std::memset(&addr6_, 0, sizeof(addr6_));
+clia::net::InetAddress::InetAddress() noexcept
+    : un_len_(0)
+{
+    std::memset(&addr_un_, 0, sizeof(addr_un_));
 }
 
-clia::net::InetAddress::InetAddress(const char *ip, std::uint16_t port, const bool is_ipv6) noexcept {
+clia::net::InetAddress::InetAddress(const char *ip, std::uint16_t port, const bool is_ipv6) noexcept
+    : un_len_(0)
+{
     if (is_ipv6 || std::strchr(ip, ':')) {
         std::memset(&addr6_, 0, sizeof(addr6_));
         addr6_.sin6_family = AF_INET6;
@@ -35,14 +41,58 @@ clia::net::InetAddress::~InetAddress() noexcept {
 
 }
 
-clia::net::InetAddress::InetAddress(const ::sockaddr_in &addr) noexcept {
+clia::net::InetAddress::InetAddress(const ::sockaddr_in &addr) noexcept
+    : un_len_(0)
+{
     addr_ = addr;
 }
 
-clia::net::InetAddress::InetAddress(const ::sockaddr_in6 &addr) noexcept {
+clia::net::InetAddress::InetAddress(const ::sockaddr_in6 &addr) noexcept
+    : un_len_(0)
+{
     addr6_ = addr;
 }
 
+clia::net::InetAddress::InetAddress(const ::sockaddr *addr, const ::socklen_t len) noexcept
+    : un_len_(0)
+{
+    std::memset(&addr_un_, 0, sizeof(addr_un_));
+    switch (addr->sa_family) {
+    case AF_INET:
+        std::memcpy(&addr_, addr, std::min<std::size_t>(len, sizeof(addr_)));
+        break;
+    case AF_INET6:
+        std::memcpy(&addr6_, addr, std::min<std::size_t>(len, sizeof(addr6_)));
+        break;
+    case AF_UNIX:
+        un_len_ = static_cast<::socklen_t>(std::min<std::size_t>(len, sizeof(addr_un_)));
+        std::memcpy(&addr_un_, addr, un_len_);
+        break;
+    default:
+        addr_un_.sun_family = addr->sa_family;
+        break;
+    }
+}
+
+clia::net::InetAddress clia::net::InetAddress::unix_domain(const std::string &path, const bool abstract) noexcept {
+    InetAddress addr;
+    addr.addr_un_.sun_family = AF_UNIX;
+    // 普通路径需要保留结尾的 '\0'，抽象命名空间以 '\0' 开头且名字长度由地址长度决定
+    const std::size_t max_len = sizeof(addr.addr_un_.sun_path) - 1;
+    if (path.size() > max_len) {
+        CLIA_LOG_ERROR << "unix socket path too long: " << path;
+    }
+    const std::size_t len = std::min(path.size(), max_len);
+    if (abstract) {
+        std::memcpy(addr.addr_un_.sun_path + 1, path.data(), len);
+        addr.un_len_ = static_cast<::socklen_t>(offsetof(::sockaddr_un, sun_path) + 1 + len);
+    } else {
+        std::memcpy(addr.addr_un_.sun_path, path.data(), len);
+        addr.un_len_ = static_cast<::socklen_t>(offsetof(::sockaddr_un, sun_path) + len + 1);
+    }
+    return addr;
+}
+
 clia::net::InetAddress::InetAddress(const InetAddress &oth) noexcept = default;
 
 clia::net::InetAddress& clia::net::InetAddress::operator=(const InetAddress &oth) noexcept = default;
@@ -51,6 +101,10 @@ clia::net::InetAddress& clia::net::InetAddress::operator=(const InetAddress &oth
     return addr_.sin_family;
 }
 
+bool clia::net::InetAddress::is_unix() const noexcept {
+    return AF_UNIX == this->family();
+}
+
 int clia::net::InetAddress::get_ipaddr(char *buf, const std::size_t sz) const noexcept {
     const char *p = nullptr;
     switch (this->family()) {
@@ -71,11 +125,60 @@ const ::sockaddr* clia::net::InetAddress::get_sockaddr() const noexcept {
     return reinterpret_cast<const ::sockaddr*>(&addr6_);
 }
 
+::socklen_t clia::net::InetAddress::socklen() const noexcept {
+    switch (this->family()) {
+    case AF_INET6:
+        return static_cast<::socklen_t>(sizeof(::sockaddr_in6));
+    case AF_UNIX:
+        return un_len_;
+    default:
+        return static_cast<::socklen_t>(sizeof(::sockaddr_in));
+    }
+}
+
+std::uint16_t clia::net::InetAddress::port() const noexcept {
+    switch (this->family()) {
+    case AF_INET6:
+        return be16toh(addr6_.sin6_port);
+    case AF_INET:
+        return be16toh(addr_.sin_port);
+    default:
+        return 0;
+    }
+}
+
+bool clia::net::InetAddress::operator==(const InetAddress &oth) const noexcept {
+    if (this->family() != oth.family()) {
+        return false;
+    }
+    if (AF_UNIX == this->family()) {
+        return un_len_ == oth.un_len_ && 0 == std::memcmp(&addr_un_, &oth.addr_un_, un_len_);
+    }
+    if (AF_INET6 == this->family()) {
+        return addr6_.sin6_port == oth.addr6_.sin6_port && addr6_.sin6_scope_id == oth.addr6_.sin6_scope_id
+            && 0 == std::memcmp(&addr6_.sin6_addr, &oth.addr6_.sin6_addr, sizeof(addr6_.sin6_addr));
+    }
+    return addr_.sin_port == oth.addr_.sin_port && addr_.sin_addr.s_addr == oth.addr_.sin_addr.s_addr;
+}
+
+bool clia::net::InetAddress::operator!=(const InetAddress &oth) const noexcept {
+    return !(*this == oth);
+}
+
 std::string clia::net::InetAddress::get_addr() const noexcept {
     char buf[64] = {0};
     std::string address;
     address.reserve(64);
-    if (this->family() == AF_INET6) {
+    if (this->family() == AF_UNIX) {
+        const std::size_t path_len = un_len_ > offsetof(::sockaddr_un, sun_path) ? un_len_ - offsetof(::sockaddr_un, sun_path) : 0;
+        address += "unix:";
+        if (path_len > 0 && '\0' == addr_un_.sun_path[0]) {
+            address += '@';
+            address.append(addr_un_.sun_path + 1, path_len - 1);
+        } else if (path_len > 0) {
+            address += addr_un_.sun_path;
+        }
+    } else if (this->family() == AF_INET6) {
         ::inet_ntop(AF_INET6, &addr6_.sin6_addr, buf, static_cast<::socklen_t>(sizeof(buf)));
         address += '[';
         address += buf;
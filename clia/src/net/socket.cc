@@ -2,10 +2,12 @@
 #include <cassert>
 #include <cerrno>
 #include <cstdlib>
+#include <cstring>
 
 #include <unistd.h>
 #include <netinet/in.h>
 #include <netinet/tcp.h>
+#include <linux/filter.h>
 #include <sys/socket.h>
 
 #include "clia/log.h"
@@ -30,16 +32,23 @@ int clia::net::Socket::fd() const noexcept {
     return sockfd_;
 }
 
+int clia::net::Socket::create_nonblocking(const ::sa_family_t family) noexcept {
+    const int protocol = (AF_UNIX == family) ? 0 : IPPROTO_TCP;
+    const int sockfd = ::socket(family, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, protocol);
+    if (-1 == sockfd) {
+        CLIA_FMT_LOG_FATAL("socket fail, errno = [%d][%s]", errno, clia::util::process::strerror((errno)));
+        std::abort();
+    }
+    return sockfd;
+}
+
 void clia::net::Socket::bind_address(const InetAddress &local_addr) noexcept {
-    int ret = 0;
-    if (local_addr.family() == AF_INET) {
-        ret = ::bind(sockfd_,local_addr.get_sockaddr(), static_cast<::socklen_t>(sizeof(::sockaddr_in)));
-    } else if (local_addr.family() == AF_INET6) {
-        ret = ::bind(sockfd_,local_addr.get_sockaddr(), static_cast<::socklen_t>(sizeof(::sockaddr_in6)));
-    } else {
+    const auto family = local_addr.family();
+    if (family != AF_INET && family != AF_INET6 && family != AF_UNIX) {
         CLIA_LOG_FATAL << "bind family err";
         std::abort();
     }
+    const int ret = ::bind(sockfd_, local_addr.get_sockaddr(), local_addr.socklen());
 
     if (ret < 0) {
         CLIA_FMT_LOG_FATAL("bind fail, errno = [%d][%s]", errno, clia::util::process::strerror(errno));
@@ -55,7 +64,7 @@ void clia::net::Socket::listen() noexcept {
 }
 
 int clia::net::Socket::accept(InetAddress *peer_addr) noexcept {
-    ::sockaddr_in6 addr;
+    ::sockaddr_storage addr;
     std::memset(&addr, 0, sizeof(addr));
     ::socklen_t addrlen = sizeof(addr);
     const int connfd = ::accept4(sockfd_, reinterpret_cast<::sockaddr*>(&addr), &addrlen, SOCK_NONBLOCK | SOCK_CLOEXEC);
@@ -85,7 +94,7 @@ int clia::net::Socket::accept(InetAddress *peer_addr) noexcept {
         }
     } else {
         if (peer_addr) {
-            *peer_addr = InetAddress(addr);
+            *peer_addr = InetAddress(reinterpret_cast<const ::sockaddr*>(&addr), addrlen);
         }
     }
     return connfd;
@@ -115,6 +124,13 @@ void clia::net::Socket::set_tcp_nodelay(const bool on) noexcept {
     ::setsockopt(sockfd_, IPPROTO_TCP, TCP_NODELAY, &optval, static_cast<::socklen_t>(sizeof(optval)));
 }
 
+void clia::net::Socket::set_tcp_cork(const bool on) noexcept {
+    const int optval = on ? 1 : 0;
+    if (::setsockopt(sockfd_, IPPROTO_TCP, TCP_CORK, &optval, static_cast<::socklen_t>(sizeof(optval))) < 0) {
+        CLIA_FMT_LOG_ERROR("set TCP_CORK fail, errno = [%d][%s]", errno, clia::util::process::strerror(errno));
+    }
+}
+
 /*
 功能：
     启用或禁用地址复用（SO_REUSEADDR）。
@@ -160,4 +176,178 @@ void clia::net::Socket::set_reuse_port(const bool on) noexcept {
 void clia::net::Socket::set_keeyalive(const bool on) noexcept {
     const int optval = on ? 1 : 0;
     ::setsockopt(sockfd_, SOL_SOCKET, SO_KEEPALIVE, &optval, static_cast<::socklen_t>(sizeof(optval)));
-}
\ No newline at end of file
+}
+/*
+功能：
+    设置内核接收/发送缓冲区大小（SO_RCVBUF / SO_SNDBUF）。
+作用：
+    缓冲区需要不小于带宽时延积才能跑满链路；内核会把设置值翻倍用于记账，并关闭该 socket 的自动调节。
+场景：
+    高带宽、高时延链路上的大块传输
+    需要限制单连接内存占用的海量连接服务
+*/
+void clia::net::Socket::set_recv_buffer(const int bytes) noexcept {
+    if (::setsockopt(sockfd_, SOL_SOCKET, SO_RCVBUF, &bytes, static_cast<::socklen_t>(sizeof(bytes))) < 0) {
+        CLIA_FMT_LOG_ERROR("set SO_RCVBUF fail, errno = [%d][%s]", errno, clia::util::process::strerror(errno));
+    }
+}
+
+void clia::net::Socket::set_send_buffer(const int bytes) noexcept {
+    if (::setsockopt(sockfd_, SOL_SOCKET, SO_SNDBUF, &bytes, static_cast<::socklen_t>(sizeof(bytes))) < 0) {
+        CLIA_FMT_LOG_ERROR("set SO_SNDBUF fail, errno = [%d][%s]", errno, clia::util::process::strerror(errno));
+    }
+}
+
+/*
+功能：
+    限制发送队列中尚未发出的数据量（TCP_NOTSENT_LOWAT）。
+作用：
+    未发送数据低于该值时 socket 才可写，数据留在用户态，可以被更新或重排，而不是在内核中排队。
+场景：
+    HTTP/2 等多路复用协议的优先级调度
+    对排队延迟敏感的交互式服务
+*/
+void clia::net::Socket::set_tcp_notsent_lowat(const int bytes) noexcept {
+    if (::setsockopt(sockfd_, IPPROTO_TCP, TCP_NOTSENT_LOWAT, &bytes, static_cast<::socklen_t>(sizeof(bytes))) < 0) {
+        CLIA_FMT_LOG_ERROR("set TCP_NOTSENT_LOWAT fail, errno = [%d][%s]", errno, clia::util::process::strerror(errno));
+    }
+}
+
+/*
+功能：
+    进入快速 ACK 模式（TCP_QUICKACK）。
+作用：
+    关闭延迟 ACK，对端的 Nagle 不必等待 ACK。该选项不持久，内核可能随时退出快速 ACK 模式，需要每次读之后重新设置。
+场景：
+    请求-响应式协议，对端未关闭 Nagle
+*/
+void clia::net::Socket::set_tcp_quickack(const bool on) noexcept {
+    const int optval = on ? 1 : 0;
+    ::setsockopt(sockfd_, IPPROTO_TCP, TCP_QUICKACK, &optval, static_cast<::socklen_t>(sizeof(optval)));
+}
+
+/*
+功能：
+    设置已发送数据最长未被确认的时间（TCP_USER_TIMEOUT）。
+作用：
+    超时后内核直接断开连接，比默认的重传上限(约 15 分钟)更快发现对端失联。
+场景：
+    需要快速故障切换的上游连接、长连接网关
+*/
+void clia::net::Socket::set_tcp_user_timeout(const unsigned int timeout_ms) noexcept {
+    if (::setsockopt(sockfd_, IPPROTO_TCP, TCP_USER_TIMEOUT, &timeout_ms, static_cast<::socklen_t>(sizeof(timeout_ms))) < 0) {
+        CLIA_FMT_LOG_ERROR("set TCP_USER_TIMEOUT fail, errno = [%d][%s]", errno, clia::util::process::strerror(errno));
+    }
+}
+
+void clia::net::Socket::apply(const SocketProfile &profile, const bool is_tcp) noexcept {
+    this->set_keeyalive(profile.keepalive);
+    if (profile.recv_buffer > 0) {
+        this->set_recv_buffer(profile.recv_buffer);
+    }
+    if (profile.send_buffer > 0) {
+        this->set_send_buffer(profile.send_buffer);
+    }
+    if (!is_tcp) {
+        return;
+    }
+    this->set_tcp_nodelay(profile.tcp_nodelay);
+    if (profile.notsent_lowat > 0) {
+        this->set_tcp_notsent_lowat(profile.notsent_lowat);
+    }
+    if (profile.quickack) {
+        this->set_tcp_quickack(true);
+    }
+    if (profile.user_timeout_ms > 0) {
+        this->set_tcp_user_timeout(profile.user_timeout_ms);
+    }
+}
+
+bool clia::net::Socket::get_tcp_info(TcpInfo *info) const noexcept {
+    ::tcp_info raw;
+    ::socklen_t len = static_cast<::socklen_t>(sizeof(raw));
+    std::memset(&raw, 0, sizeof(raw));
+    if (::getsockopt(sockfd_, IPPROTO_TCP, TCP_INFO, &raw, &len) < 0) {
+        CLIA_FMT_LOG_ERROR("get TCP_INFO fail, errno = [%d][%s]", errno, clia::util::process::strerror(errno));
+        return false;
+    }
+    info->sampled_at = clia::util::Timestamp::now();
+    info->rtt_us = raw.tcpi_rtt;
+    info->rttvar_us = raw.tcpi_rttvar;
+    info->snd_cwnd = raw.tcpi_snd_cwnd;
+    info->snd_mss = raw.tcpi_snd_mss;
+    info->unacked = raw.tcpi_unacked;
+    info->lost = raw.tcpi_lost;
+    info->retransmits = raw.tcpi_retransmits;
+    info->total_retrans = raw.tcpi_total_retrans;
+    info->rto_us = raw.tcpi_rto;
+    info->snd_ssthresh = raw.tcpi_snd_ssthresh;
+    return true;
+}
+
+int clia::net::Socket::incoming_cpu() const noexcept {
+    int cpu = -1;
+    ::socklen_t len = static_cast<::socklen_t>(sizeof(cpu));
+    if (::getsockopt(sockfd_, SOL_SOCKET, SO_INCOMING_CPU, &cpu, &len) < 0) {
+        return -1;
+    }
+    return cpu;
+}
+
+/*
+功能：
+    给 SO_REUSEPORT 组挂载经典 BPF 选择程序（SO_ATTACH_REUSEPORT_CBPF）。
+作用：
+    程序返回值是组内监听 socket 的下标(按加入组的顺序)。程序按处理该 SYN 的 CPU 号查 cpu_to_index 表，
+    展开成一串 jeq：命中则返回表中的下标，都不命中则返回超出组大小的值，内核退回默认的哈希选择。
+    表由各 loop 实际绑定的 CPU 生成，连接会落到与网卡软中断同一个 CPU 上的 loop，减少跨核缓存流量。
+场景：
+    多队列网卡 + RSS/RPS，每个 loop 独占一个 CPU 的 shared-nothing 部署
+*/
+bool clia::net::Socket::attach_reuseport_cpu_steering(const std::vector<int> &cpu_to_index) {
+    std::vector<::sock_filter> code;
+    code.push_back({BPF_LD | BPF_W | BPF_ABS, 0, 0, static_cast<std::uint32_t>(SKF_AD_OFF + SKF_AD_CPU)});
+    for (std::size_t cpu = 0; cpu < cpu_to_index.size(); ++cpu) {
+        if (cpu_to_index[cpu] < 0) {
+            continue;
+        }
+        // 相等时执行下一条 ret，否则跳过它
+        code.push_back({BPF_JMP | BPF_JEQ | BPF_K, 0, 1, static_cast<std::uint32_t>(cpu)});
+        code.push_back({BPF_RET | BPF_K, 0, 0, static_cast<std::uint32_t>(cpu_to_index[cpu])});
+    }
+    code.push_back({BPF_RET | BPF_K, 0, 0, 0xffffffffu});
+    if (code.size() > BPF_MAXINSNS) {
+        CLIA_LOG_ERROR << "attach_reuseport_cpu_steering: too many cpus " << cpu_to_index.size();
+        return false;
+    }
+    ::sock_fprog prog;
+    prog.len = static_cast<unsigned short>(code.size());
+    prog.filter = code.data();
+    if (::setsockopt(sockfd_, SOL_SOCKET, SO_ATTACH_REUSEPORT_CBPF, &prog, static_cast<::socklen_t>(sizeof(prog))) < 0) {
+        CLIA_FMT_LOG_ERROR("set SO_ATTACH_REUSEPORT_CBPF fail, errno = [%d][%s]", errno, clia::util::process::strerror(errno));
+        return false;
+    }
+    return true;
+}
+
+clia::net::SocketProfile clia::net::SocketProfile::defaults() {
+    return SocketProfile();
+}
+
+clia::net::SocketProfile clia::net::SocketProfile::low_latency() {
+    SocketProfile profile;
+    profile.name = "low_latency";
+    profile.tcp_nodelay = true;
+    profile.quickack = true;
+    profile.notsent_lowat = 16 * 1024;
+    profile.user_timeout_ms = 30 * 1000;
+    return profile;
+}
+
+clia::net::SocketProfile clia::net::SocketProfile::bulk() {
+    SocketProfile profile;
+    profile.name = "bulk";
+    profile.recv_buffer = 4 * 1024 * 1024;
+    profile.send_buffer = 4 * 1024 * 1024;
+    return profile;
+}
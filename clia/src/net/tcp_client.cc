@@ -0,0 +1,147 @@
+#include <cassert>
+#include <cstring>
+
+#include <sys/socket.h>
+
+#include "clia/net/tcp_client.h"
+#include "clia/log.h"
+#include "clia/net/connector.h"
+#include "clia/net/tcp_connection.h"
+#include "clia/reactor/event_loop.h"
+#include "clia/util/process.h"
+
+namespace {
+    clia::net::InetAddress get_peer_addr(const int sockfd) noexcept {
+        ::sockaddr_storage addr;
+        std::memset(&addr, 0, sizeof(addr));
+        ::socklen_t addrlen = static_cast<::socklen_t>(sizeof(addr));
+        if (::getpeername(sockfd, reinterpret_cast<::sockaddr*>(&addr), &addrlen) < 0) {
+            CLIA_FMT_LOG_ERROR("getpeername fail, errno = [%d][%s]", errno, clia::util::process::strerror(errno));
+        }
+        return clia::net::InetAddress(reinterpret_cast<const ::sockaddr*>(&addr), addrlen);
+    }
+}
+
+clia::net::TcpClient::TcpClient(clia::reactor::EventLoop *loop, const InetAddress &server_addr)
+    : loop_(loop)
+    , connector_(std::make_shared<Connector>(loop, server_addr))
+    , retry_(false)
+    , connect_(false)
+{
+    assert(loop_ != nullptr);
+    connector_->set_new_connection_callback(std::bind(&TcpClient::new_connection, this, std::placeholders::_1));
+}
+
+clia::net::TcpClient::~TcpClient() {
+    TcpConnectionPtr conn;
+    bool unique = false;
+    {
+        std::lock_guard<std::mutex> lck(mutex_);
+        unique = connection_.unique();
+        conn = connection_;
+    }
+    if (conn) {
+        assert(loop_ == conn->get_loop());
+        // TcpClient 已经不在了，之后的关闭只需销毁连接
+        clia::reactor::EventLoop *loop = loop_;
+        const CloseCallback cb = [loop](const TcpConnectionPtr &c) {
+            loop->queue_in_loop(std::bind(&TcpConnection::connect_destoryed, c));
+        };
+        loop_->run_in_loop(std::bind(&TcpConnection::set_close_callback, conn, cb));
+        if (unique) {
+            conn->force_close();
+        }
+    } else {
+        connector_->stop();
+    }
+}
+
+void clia::net::TcpClient::connect() {
+    CLIA_LOG_INFO << "TcpClient::connect to " << connector_->server_addr().get_addr();
+    connect_ = true;
+    connector_->start();
+}
+
+void clia::net::TcpClient::disconnect() {
+    connect_ = false;
+    std::lock_guard<std::mutex> lck(mutex_);
+    if (connection_) {
+        connection_->shutdown();
+    }
+}
+
+void clia::net::TcpClient::stop() {
+    connect_ = false;
+    connector_->stop();
+}
+
+clia::net::TcpConnectionPtr clia::net::TcpClient::connection() const {
+    std::lock_guard<std::mutex> lck(mutex_);
+    return connection_;
+}
+
+clia::reactor::EventLoop* clia::net::TcpClient::get_loop() const noexcept {
+    return loop_;
+}
+
+bool clia::net::TcpClient::retry() const noexcept {
+    return retry_;
+}
+
+void clia::net::TcpClient::enable_retry() noexcept {
+    retry_ = true;
+}
+
+void clia::net::TcpClient::set_retry_delay(const int init_ms, const int max_ms) noexcept {
+    connector_->set_retry_delay(init_ms, max_ms);
+}
+
+void clia::net::TcpClient::set_connection_callback(const ConnectionCallback &cb) {
+    connection_callback_ = cb;
+}
+
+void clia::net::TcpClient::set_message_callback(const MessageCallback &cb) {
+    message_callback_ = cb;
+}
+
+void clia::net::TcpClient::set_write_complete_callback(const WriteCompleteCallback &cb) {
+    write_complete_callback_ = cb;
+}
+
+void clia::net::TcpClient::new_connection(int sockfd) {
+    assert(loop_->is_in_loop_thread());
+    const InetAddress peer_addr(::get_peer_addr(sockfd));
+    CLIA_LOG_DEBUG << "TcpClient::new_connection to " << peer_addr.get_addr();
+
+    TcpConnectionPtr conn(TcpConnection::create(loop_, sockfd, peer_addr));
+    if (connection_callback_) {
+        conn->set_connection_callback(connection_callback_);
+    }
+    if (message_callback_) {
+        conn->set_message_callback(message_callback_);
+    }
+    if (write_complete_callback_) {
+        conn->set_write_complete_callback(write_complete_callback_);
+    }
+    conn->set_close_callback(std::bind(&TcpClient::remove_connection, this, std::placeholders::_1));
+    {
+        std::lock_guard<std::mutex> lck(mutex_);
+        connection_ = conn;
+    }
+    conn->connect_established();
+}
+
+void clia::net::TcpClient::remove_connection(const TcpConnectionPtr &conn) {
+    assert(loop_->is_in_loop_thread());
+    assert(loop_ == conn->get_loop());
+    {
+        std::lock_guard<std::mutex> lck(mutex_);
+        assert(connection_ == conn);
+        connection_.reset();
+    }
+    loop_->queue_in_loop(std::bind(&TcpConnection::connect_destoryed, conn));
+    if (retry_ && connect_) {
+        CLIA_LOG_INFO << "TcpClient::remove_connection reconnecting to " << connector_->server_addr().get_addr();
+        connector_->restart();
+    }
+}
@@ -1,6 +1,14 @@
+#include <algorithm>
 #include <cassert>
+#include <cerrno>
+#include <climits>
+#include <cstring>
+#include <string>
+#include <vector>
 
+#include <fcntl.h>
 #include <unistd.h>
+#include <sys/socket.h>
 
 #include "clia/log.h"
 #include "clia/net/socket.h"
@@ -8,24 +16,49 @@
 #include "clia/reactor/event_loop.h"
 #include "clia/util/process.h"
 
+constexpr std::size_t clia::net::TcpConnection::kCorkHighWaterMark;
+constexpr int clia::net::TcpConnection::kMaxWriteIov;
+constexpr int clia::net::TcpConnection::kPipeSize;
+constexpr std::size_t clia::net::TcpConnection::kForwardHighWaterMark;
+
 clia::net::TcpConnection::TcpConnection(clia::reactor::EventLoop *loop, const int sockfd, const InetAddress &peer_addr) 
     : loop_(loop)
     , fd_(sockfd)
     , state_(State::kConnecting)
     , reading_(true)
+    , coalescing_(false)
+    , corked_(false)
+    , tcp_corked_(false)
+    , flush_pending_(false)
+    , quickack_(false)
+    , tcp_info_interval_sec_(0.0)
+    , forwarding_(false)
+    , pipe_fds_{-1, -1}
+    , pipe_bytes_(0)
+    , forward_eof_(false)
     , socket_(sockfd)
     , channel_(loop, sockfd)
     , peer_addr_(peer_addr)
 {
-    channel_.set_read_callback(std::bind(&TcpConnection::handle_read, this, std::placeholders::_1));
-    channel_.set_write_callback(std::bind(&TcpConnection::handle_write, this));
-    channel_.set_close_callback(std::bind(&TcpConnection::handle_close, this));
-    channel_.set_error_callback(std::bind(&TcpConnection::handle_error, this));
+    // 只捕获 this 的 lambda 能放进 std::function 的内部存储，std::bind 成员函数指针则需要额外的堆分配
+    channel_.set_read_callback([this](clia::util::Timestamp receive_time) { this->handle_read(receive_time); });
+    channel_.set_write_callback([this]() { this->handle_write(); });
+    channel_.set_close_callback([this]() { this->handle_close(); });
+    channel_.set_error_callback([this]() { this->handle_error(); });
     socket_.set_keeyalive(true);
 }
 
 clia::net::TcpConnection::~TcpConnection() {
     assert(State::kDisconnected == state_);
+    this->stop_splice();
+}
+
+clia::net::TcpConnectionPtr clia::net::TcpConnection::create(clia::reactor::EventLoop *loop, const int sockfd, const InetAddress &peer_addr) {
+    return std::allocate_shared<TcpConnection>(clia::util::PoolAllocator<TcpConnection, PoolTag>(), loop, sockfd, peer_addr);
+}
+
+clia::util::SlabPool::Stats clia::net::TcpConnection::pool_stats() {
+    return clia::util::SlabPool::aggregate(PoolTag::name());
 }
 
 clia::reactor::EventLoop* clia::net::TcpConnection::get_loop() const noexcept {
@@ -54,6 +87,44 @@ void clia::net::TcpConnection::send(const void *buf, const std::size_t len) {
     }
 }
 
+void clia::net::TcpConnection::send(Buffer *buf) {
+    if (State::kConnected == state_) {
+        if (loop_->is_in_loop_thread()) {
+            this->send_in_loop(buf->peek(), buf->readable_bytes());
+            buf->retrieve_all();
+        } else {
+            auto self = this->shared_from_this();
+            auto msg = std::make_shared<std::string>(buf->retrieve_all_as_string());
+            loop_->run_in_loop([self, msg]() {
+                self->send_in_loop(msg->data(), msg->size());
+            });
+        }
+    }
+}
+
+void clia::net::TcpConnection::send(const ::iovec *iov, const int iovcnt, const bool copy) {
+    if (State::kConnected == state_) {
+        if (loop_->is_in_loop_thread()) {
+            this->send_iov_in_loop(iov, iovcnt, copy);
+        } else if (copy) {
+            auto self = this->shared_from_this();
+            auto msg = std::make_shared<std::string>();
+            for (int i = 0; i < iovcnt; ++i) {
+                msg->append(static_cast<const char*>(iov[i].iov_base), iov[i].iov_len);
+            }
+            loop_->run_in_loop([self, msg]() {
+                self->send_in_loop(msg->data(), msg->size());
+            });
+        } else {
+            auto self = this->shared_from_this();
+            auto vec = std::make_shared<std::vector<::iovec>>(iov, iov + iovcnt);
+            loop_->run_in_loop([self, vec]() {
+                self->send_iov_in_loop(vec->data(), static_cast<int>(vec->size()), false);
+            });
+        }
+    }
+}
+
 void clia::net::TcpConnection::shutdown() {
     if (State::kConnected == state_) {
         this->set_state(State::kDisconnecting);
@@ -61,6 +132,33 @@ void clia::net::TcpConnection::shutdown() {
     }
 }
 
+void clia::net::TcpConnection::force_close() {
+    if (State::kConnected == state_ || State::kDisconnecting == state_) {
+        this->set_state(State::kDisconnecting);
+        loop_->queue_in_loop(std::bind(&TcpConnection::force_close_in_loop, this->shared_from_this()));
+    }
+}
+
+void clia::net::TcpConnection::set_write_coalescing(const bool on) noexcept {
+    coalescing_ = on;
+}
+
+void clia::net::TcpConnection::cork(const bool tcp_cork) {
+    if (loop_->is_in_loop_thread()) {
+        this->cork_in_loop(tcp_cork);
+    } else {
+        loop_->run_in_loop(std::bind(&TcpConnection::cork_in_loop, this->shared_from_this(), tcp_cork));
+    }
+}
+
+void clia::net::TcpConnection::uncork() {
+    if (loop_->is_in_loop_thread()) {
+        this->uncork_in_loop();
+    } else {
+        loop_->run_in_loop(std::bind(&TcpConnection::uncork_in_loop, this->shared_from_this()));
+    }
+}
+
 void clia::net::TcpConnection::set_connection_callback(const ConnectionCallback &cb) {
     connection_callback_ = cb;
 }
@@ -77,6 +175,57 @@ void clia::net::TcpConnection::set_close_callback(const CloseCallback &cb) {
     close_callback_ = cb;
 }
 
+void clia::net::TcpConnection::apply_socket_profile(const SocketProfile &profile) {
+    const bool is_tcp = !peer_addr_.is_unix();
+    socket_.apply(profile, is_tcp);
+    quickack_ = is_tcp && profile.quickack;
+    tcp_info_interval_sec_ = is_tcp ? profile.tcp_info_interval_sec : 0.0;
+}
+
+clia::net::TcpInfo clia::net::TcpConnection::tcp_info() const {
+    std::lock_guard<std::mutex> lock(tcp_info_mutex_);
+    return tcp_info_;
+}
+
+bool clia::net::TcpConnection::sample_tcp_info() {
+    TcpInfo info;
+    if (peer_addr_.is_unix() || !socket_.get_tcp_info(&info)) {
+        return false;
+    }
+    std::lock_guard<std::mutex> lock(tcp_info_mutex_);
+    tcp_info_ = info;
+    return true;
+}
+
+int clia::net::TcpConnection::incoming_cpu() const noexcept {
+    return socket_.incoming_cpu();
+}
+
+bool clia::net::TcpConnection::suspend_if_idle() {
+    assert(loop_->is_in_loop_thread());
+    if (State::kConnected != state_ || input_buffer_.readable_bytes() > 0 || this->has_pending_output()
+        || forwarding_ || !forward_source_.expired() || corked_ || flush_pending_) {
+        return false;
+    }
+    channel_.disable_all();
+    return true;
+}
+
+void clia::net::TcpConnection::resume_reading() {
+    assert(loop_->is_in_loop_thread());
+    if (State::kConnected == state_ && !channel_.is_reading()) {
+        channel_.enable_reading();
+    }
+}
+
+void clia::net::TcpConnection::set_context(const std::shared_ptr<void> &context) {
+    context_ = context;
+}
+
+const std::shared_ptr<void>& clia::net::TcpConnection::context() const noexcept {
+    return context_;
+}
+
 // 连接建立
 void clia::net::TcpConnection::connect_established() {
     assert(loop_->is_in_loop_thread());
@@ -84,6 +233,15 @@ void clia::net::TcpConnection::connect_established() {
     this->set_state(State::kConnected);
     channel_.tie(this->shared_from_this());
     channel_.enable_reading();
+    if (tcp_info_interval_sec_ > 0.0) {
+        std::weak_ptr<TcpConnection> weak(this->shared_from_this());
+        tcp_info_timer_ = loop_->run_every(tcp_info_interval_sec_, [weak]() {
+            const TcpConnectionPtr conn = weak.lock();
+            if (conn) {
+                conn->sample_tcp_info();
+            }
+        });
+    }
     if (connection_callback_) {
         connection_callback_(this->shared_from_this());
     }
@@ -93,13 +251,17 @@ void clia::net::TcpConnection::connect_established() {
 void clia::net::TcpConnection::connect_destoryed() {
     CLIA_LOG_DEBUG << "TcpConnection::connect_destoryed [" << this->peer_addr().get_addr();
     assert(loop_->is_in_loop_thread());
-    if (State::kConnected == state_) {
+    if (State::kConnected == state_ || State::kDisconnecting == state_) {
         this->set_state(State::kDisconnected);
         channel_.disable_all();
         if (connection_callback_) {
             connection_callback_(this->shared_from_this());
         }
     }
+    if (tcp_info_timer_.valid()) {
+        loop_->cancel(tcp_info_timer_);
+        tcp_info_timer_ = clia::reactor::TimerId();
+    }
     CLIA_LOG_DEBUG << "TcpConnection::connect_destoryed [" << this->peer_addr().get_addr();
     channel_.remove();
     CLIA_LOG_DEBUG << "TcpConnection::connect_destoryed [" << this->peer_addr().get_addr();
@@ -111,35 +273,81 @@ void clia::net::TcpConnection::set_state(const State state) {
 
 void clia::net::TcpConnection::handle_read(clia::util::Timestamp recvive_time) {
     assert(loop_->is_in_loop_thread());
-    const auto n = input_buffer_.read_fd(channel_.fd());
-    if (n > 0) {
+    if (forwarding_) {
+        this->handle_forward_read();
+        return;
+    }
+    const clia::reactor::FairnessOptions &fairness = loop_->fairness();
+    const std::int64_t start_us = fairness.time_budget_us > 0 ? clia::util::Timestamp::now().micro_sec_since_epoch() : 0;
+    std::size_t total = 0;
+    for (;;) {
+        const std::size_t capacity = input_buffer_.writable_bytes() + Buffer::kExtraReadSize;
+        const auto n = input_buffer_.read_fd(channel_.fd());
+        if (0 == n) {
+            this->handle_close();
+            return;
+        }
+        if (n < 0) {
+            // 从就绪队列重新分发时数据可能已被读完；错误已由 read_fd 限流记录
+            if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                this->handle_error();
+            }
+            return;
+        }
+        if (quickack_) {
+            socket_.set_tcp_quickack(true);
+        }
         if (message_callback_) {
             message_callback_(this->shared_from_this(), &input_buffer_, recvive_time);
         }
-    } else if (0 == n) {
-        this->handle_close();
-    } else {
-        CLIA_FMT_LOG_ERROR("read err, errno = [%d][%s]", errno, clia::util::process::strerror(errno));
-        this->handle_error();
+        // 未开启预算时保持每个事件只读一次；读不满说明 socket 已读空
+        if (!fairness.enabled() || State::kConnected != state_ || static_cast<std::size_t>(n) < capacity) {
+            return;
+        }
+        total += static_cast<std::size_t>(n);
+        const bool over_bytes = fairness.read_budget_bytes > 0 && total >= fairness.read_budget_bytes;
+        bool over_time = false;
+        if (fairness.time_budget_us > 0) {
+            const std::int64_t elapsed = clia::util::Timestamp::now().micro_sec_since_epoch() - start_us;
+            over_time = elapsed >= fairness.time_budget_us;
+            if (over_time && total == static_cast<std::size_t>(n)) {
+                loop_->record_time_overrun();
+            }
+        }
+        if (over_bytes || over_time) {
+            loop_->defer_channel(&channel_);
+            return;
+        }
     }
 }
 
 void clia::net::TcpConnection::handle_write() {
     assert(loop_->is_in_loop_thread());
     if (channel_.is_writing()) {
-        const auto n = output_buffer_.write_fd(channel_.fd());
-        if (n > 0) {
-            if (output_buffer_.readable_bytes() == 0) {
-                channel_.disable_writing();
-                if (write_complete_callback_) {
-                    loop_->queue_in_loop(std::bind(write_complete_callback_, this->shared_from_this()));
-                }
-                if (State::kDisconnecting == state_) {
-                    this->shutdown_in_loop();
-                }
+        // 只为转发源的管道打开写事件时发送缓冲区为空
+        if (this->has_pending_output()) {
+            const auto n = this->write_output();
+            if (n < 0 && errno != EWOULDBLOCK) {
+                this->handle_write_error();
+                return;
             }
-        } else {
-            CLIA_FMT_LOG_ERROR("TcpConnection::handleWrite, errno = [%d][%s]", errno, clia::util::process::strerror(errno));
+            if (n <= 0) {
+                return;
+            }
+            if (this->has_pending_output()) {
+                return;
+            }
+        }
+        channel_.disable_writing();
+        if (write_complete_callback_) {
+            loop_->queue_in_loop(std::bind(write_complete_callback_, this->shared_from_this()));
+        }
+        const TcpConnectionPtr source = forward_source_.lock();
+        if (source) {
+            source->pump_forward(this->shared_from_this());
+        }
+        if (State::kDisconnecting == state_ && !channel_.is_writing()) {
+            this->shutdown_in_loop();
         }
     }
 }
@@ -150,6 +358,11 @@ void clia::net::TcpConnection::handle_close() {
     this->set_state(State::kDisconnected);
     channel_.disable_all();
     TcpConnectionPtr guard(this->shared_from_this());
+    // 已读到 EOF 的转发源不再读取，不会再发现本连接已关闭，由这里通知它
+    const TcpConnectionPtr source = forward_source_.lock();
+    if (source && source->forward_eof_) {
+        source->force_close();
+    }
     if (connection_callback_) {
         connection_callback_(guard);
     }
@@ -167,7 +380,17 @@ void clia::net::TcpConnection::handle_error() {
     } else {
         err = optval;
     }
-    CLIA_LOG_ERROR << "TcpConnection::handleError - SO_ERROR = " << err << " " << clia::util::process::strerror(err);
+    CLIA_FMT_LOG_RATE_LIMIT(clia::log::Level::kError, 10, 100, "TcpConnection::handleError - SO_ERROR = [%d][%s]", err, clia::util::process::strerror(err));
+}
+
+void clia::net::TcpConnection::handle_write_error() {
+    // 错误已由调用方记录
+    if (EPIPE == errno || ECONNRESET == errno) {
+        // 对端已不可写，未发送的数据没有机会再发出
+        output_buffer_.retrieve_all();
+        output_slices_.clear();
+        this->handle_close();
+    }
 }
 
 void clia::net::TcpConnection::send_in_loop(const void *data, const std::size_t len) {
@@ -177,11 +400,30 @@ void clia::net::TcpConnection::send_in_loop(const void *data, const std::size_t
         return;
     }
 
+    if (corked_ || coalescing_) {
+        this->append_output(data, len);
+        if (!corked_) {
+            this->schedule_flush();
+        } else if (!channel_.is_writing() && output_slices_.empty() && output_buffer_.readable_bytes() >= kCorkHighWaterMark) {
+            // MSG_MORE 告诉内核后面还有数据，不要把不满 MSS 的尾部单独发出去
+            const int flags = peer_addr_.is_unix() ? MSG_NOSIGNAL : (MSG_NOSIGNAL | MSG_MORE);
+            const auto n = ::send(channel_.fd(), output_buffer_.peek(), output_buffer_.readable_bytes(), flags);
+            if (n > 0) {
+                output_buffer_.retrieve(n);
+            } else if (n < 0 && errno != EWOULDBLOCK) {
+                const int err = errno;
+                CLIA_FMT_LOG_RATE_LIMIT(clia::log::Level::kError, 10, 100, "TcpConnection::send_in_loop MSG_MORE, errno = [%d][%s]", err, clia::util::process::strerror(err));
+                errno = err;
+                this->handle_write_error();
+            }
+        }
+        return;
+    }
+
     ::ssize_t nwrote = 0;
     ::ssize_t remaining = len;
 
-    bool fault_error = false;
-    if (!channel_.is_writing() && output_buffer_.readable_bytes() == 0) {
+    if (!channel_.is_writing() && !this->has_pending_output()) {
         nwrote = ::write(channel_.fd(), static_cast<const unsigned char*>(data) + nwrote, remaining);
         if (nwrote >= 0) {
             remaining -= nwrote;
@@ -191,16 +433,19 @@ void clia::net::TcpConnection::send_in_loop(const void *data, const std::size_t
         } else {
             nwrote = 0;
             if (errno != EWOULDBLOCK) {
-                CLIA_FMT_LOG_ERROR("TcpConnection::sendInLoop, errno = [%d][%s]", errno, clia::util::process::strerror(errno));
-                if (EPIPE == errno || ECONNRESET) {
-                    fault_error = true;
+                const int err = errno;
+                CLIA_FMT_LOG_RATE_LIMIT(clia::log::Level::kError, 10, 100, "TcpConnection::send_in_loop, errno = [%d][%s]", err, clia::util::process::strerror(err));
+                errno = err;
+                this->handle_write_error();
+                if (State::kDisconnected == state_) {
+                    return;
                 }
             }
         }
     }
     assert(remaining <= len);
-    if (!fault_error && remaining > 0) {
-        output_buffer_.append(static_cast<const unsigned char*>(data) + nwrote, remaining);
+    if (remaining > 0) {
+        this->append_output(static_cast<const unsigned char*>(data) + nwrote, remaining);
         if (!channel_.is_writing()) {
             channel_.enable_writing();
         }
@@ -210,6 +455,335 @@ void clia::net::TcpConnection::send_in_loop(const void *data, const std::size_t
 void clia::net::TcpConnection::shutdown_in_loop() {
     assert(loop_->is_in_loop_thread());
     if (!channel_.is_writing()) {
+        if (this->has_pending_output()) {
+            // 还有 cork 或合并中的数据，先写出，写完后由 flush_in_loop/handle_write 再次关闭
+            corked_ = false;
+            this->flush_in_loop();
+            return;
+        }
         socket_.shutdown_write();
+        this->close_if_forward_done();
     }
-}
\ No newline at end of file
+}
+
+void clia::net::TcpConnection::force_close_in_loop() {
+    assert(loop_->is_in_loop_thread());
+    if (State::kConnected == state_ || State::kDisconnecting == state_) {
+        this->handle_close();
+    }
+}
+void clia::net::TcpConnection::cork_in_loop(const bool tcp_cork) {
+    assert(loop_->is_in_loop_thread());
+    corked_ = true;
+    if (tcp_cork && !tcp_corked_ && !peer_addr_.is_unix()) {
+        socket_.set_tcp_cork(true);
+        tcp_corked_ = true;
+    }
+}
+
+void clia::net::TcpConnection::uncork_in_loop() {
+    assert(loop_->is_in_loop_thread());
+    if (!corked_) {
+        return;
+    }
+    corked_ = false;
+    this->flush_in_loop();
+    if (tcp_corked_) {
+        // 取消 TCP_CORK 会立即推出内核中攒着的尾部数据
+        socket_.set_tcp_cork(false);
+        tcp_corked_ = false;
+    }
+}
+
+void clia::net::TcpConnection::schedule_flush() {
+    if (!flush_pending_ && !channel_.is_writing()) {
+        flush_pending_ = true;
+        // 排在本轮就绪事件处理之后执行，本轮的所有 send 合并为一次写
+        loop_->queue_in_loop(std::bind(&TcpConnection::flush_in_loop, this->shared_from_this()));
+    }
+}
+
+void clia::net::TcpConnection::flush_in_loop() {
+    assert(loop_->is_in_loop_thread());
+    flush_pending_ = false;
+    if (corked_ || State::kDisconnected == state_ || channel_.is_writing() || !this->has_pending_output()) {
+        return;
+    }
+    const auto n = this->write_output();
+    if (n < 0 && errno != EWOULDBLOCK) {
+        this->handle_write_error();
+        if (State::kDisconnected == state_) {
+            return;
+        }
+    }
+    if (this->has_pending_output()) {
+        channel_.enable_writing();
+        return;
+    }
+    if (write_complete_callback_) {
+        loop_->queue_in_loop(std::bind(write_complete_callback_, this->shared_from_this()));
+    }
+    if (State::kDisconnecting == state_) {
+        this->shutdown_in_loop();
+    }
+}
+
+void clia::net::TcpConnection::send_iov_in_loop(const ::iovec *iov, const int iovcnt, const bool copy) {
+    assert(loop_->is_in_loop_thread());
+    if (State::kDisconnected == state_) {
+        CLIA_LOG_WARN << "disconnected, give up writing";
+        return;
+    }
+
+    std::size_t total = 0;
+    for (int i = 0; i < iovcnt; ++i) {
+        total += iov[i].iov_len;
+    }
+    std::size_t nwrote = 0;
+    if (!corked_ && !coalescing_ && !channel_.is_writing() && !this->has_pending_output()) {
+        const auto n = ::writev(channel_.fd(), iov, std::min(iovcnt, IOV_MAX));
+        if (n >= 0) {
+            nwrote = static_cast<std::size_t>(n);
+            if (nwrote == total) {
+                if (write_complete_callback_) {
+                    loop_->queue_in_loop(std::bind(write_complete_callback_, this->shared_from_this()));
+                }
+                return;
+            }
+        } else if (errno != EWOULDBLOCK) {
+            const int err = errno;
+            CLIA_FMT_LOG_RATE_LIMIT(clia::log::Level::kError, 10, 100, "TcpConnection::send_iov_in_loop, errno = [%d][%s]", err, clia::util::process::strerror(err));
+            errno = err;
+            this->handle_write_error();
+            if (State::kDisconnected == state_) {
+                return;
+            }
+        }
+    }
+
+    // 跳过已写出的部分，剩余片段拷贝或引用到发送队列
+    for (int i = 0; i < iovcnt; ++i) {
+        const unsigned char *data = static_cast<const unsigned char*>(iov[i].iov_base);
+        std::size_t len = iov[i].iov_len;
+        if (nwrote >= len) {
+            nwrote -= len;
+            continue;
+        }
+        data += nwrote;
+        len -= nwrote;
+        nwrote = 0;
+        if (copy) {
+            this->append_output(data, len);
+        } else {
+            OutputSlice slice;
+            slice.data = data;
+            slice.len = len;
+            output_slices_.push_back(std::move(slice));
+        }
+    }
+    if (corked_) {
+        return;
+    }
+    if (coalescing_) {
+        this->schedule_flush();
+    } else if (!channel_.is_writing()) {
+        channel_.enable_writing();
+    }
+}
+
+void clia::net::TcpConnection::append_output(const void *data, const std::size_t len) {
+    if (output_slices_.empty()) {
+        output_buffer_.append(data, len);
+        return;
+    }
+    OutputSlice slice;
+    slice.owned.reset(new unsigned char[len]);
+    std::memcpy(slice.owned.get(), data, len);
+    slice.data = slice.owned.get();
+    slice.len = len;
+    output_slices_.push_back(std::move(slice));
+}
+
+bool clia::net::TcpConnection::has_pending_output() const noexcept {
+    return output_buffer_.readable_bytes() > 0 || !output_slices_.empty();
+}
+
+::ssize_t clia::net::TcpConnection::write_output() {
+    ::iovec vec[kMaxWriteIov];
+    int count = 0;
+    if (output_buffer_.readable_bytes() > 0) {
+        vec[count].iov_base = output_buffer_.peek();
+        vec[count].iov_len = output_buffer_.readable_bytes();
+        ++count;
+    }
+    for (auto it = output_slices_.begin(); it != output_slices_.end() && count < kMaxWriteIov; ++it) {
+        vec[count].iov_base = const_cast<unsigned char*>(it->data);
+        vec[count].iov_len = it->len;
+        ++count;
+    }
+    const auto n = ::writev(channel_.fd(), vec, count);
+    if (n < 0) {
+        const int err = errno;
+        if (err != EWOULDBLOCK) {
+            CLIA_FMT_LOG_RATE_LIMIT(clia::log::Level::kError, 10, 100, "writev fail, errno = [%d][%s]", err, clia::util::process::strerror(err));
+        }
+        // 调用方根据 errno 决定是否关闭连接
+        errno = err;
+        return n;
+    }
+    std::size_t left = static_cast<std::size_t>(n);
+    const std::size_t from_buffer = std::min(left, output_buffer_.readable_bytes());
+    output_buffer_.retrieve(from_buffer);
+    left -= from_buffer;
+    while (left > 0) {
+        OutputSlice &front = output_slices_.front();
+        if (left < front.len) {
+            front.data += left;
+            front.len -= left;
+            break;
+        }
+        left -= front.len;
+        output_slices_.pop_front();
+    }
+    return n;
+}
+
+bool clia::net::TcpConnection::forward_to(const TcpConnectionPtr &peer) {
+    assert(loop_->is_in_loop_thread());
+    assert(peer->get_loop() == loop_);
+    forwarding_ = true;
+    forward_peer_ = peer;
+    peer->forward_source_ = this->shared_from_this();
+    if (input_buffer_.readable_bytes() > 0) {
+        peer->send(&input_buffer_);
+    }
+    if (::pipe2(pipe_fds_, O_NONBLOCK | O_CLOEXEC) < 0) {
+        CLIA_FMT_LOG_WARN("pipe2 fail, fallback to buffered forward, errno = [%d][%s]", errno, clia::util::process::strerror(errno));
+        pipe_fds_[0] = pipe_fds_[1] = -1;
+        return false;
+    }
+    // 管道容量决定一次 splice 能搬运的上限，失败时沿用默认的 64K
+    ::fcntl(pipe_fds_[1], F_SETPIPE_SZ, kPipeSize);
+    return true;
+}
+
+void clia::net::TcpConnection::handle_forward_read() {
+    if (forward_eof_) {
+        // 停止读取前已进入本轮就绪列表
+        return;
+    }
+    const TcpConnectionPtr peer = forward_peer_.lock();
+    if (!peer || !peer->connected()) {
+        this->handle_close();
+        return;
+    }
+    if (pipe_fds_[0] >= 0) {
+        const auto n = ::splice(fd_, nullptr, pipe_fds_[1], nullptr, kPipeSize, SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+        if (n > 0) {
+            pipe_bytes_ += static_cast<std::size_t>(n);
+            this->pump_forward(peer);
+            return;
+        }
+        if (n < 0 && (EAGAIN == errno || EWOULDBLOCK == errno)) {
+            return;
+        }
+        if (n < 0 && EINVAL == errno && 0 == pipe_bytes_) {
+            // socket 不支持 splice(如被替换成 TLS 等)，退回缓冲拷贝
+            CLIA_LOG_WARN << "TcpConnection::handle_forward_read splice unsupported, fallback to buffered forward";
+            this->stop_splice();
+        } else if (0 == n) {
+            // 对端关闭写方向：把管道中剩余的数据拷进 peer 的发送缓冲区，再关闭 peer 的写方向
+            unsigned char buf[4096];
+            while (pipe_bytes_ > 0) {
+                const auto r = ::read(pipe_fds_[0], buf, sizeof(buf));
+                if (r <= 0) {
+                    break;
+                }
+                peer->send(buf, static_cast<std::size_t>(r));
+                pipe_bytes_ -= static_cast<std::size_t>(r);
+            }
+            this->handle_forward_eof(peer);
+            return;
+        } else {
+            CLIA_FMT_LOG_ERROR("splice fail, errno = [%d][%s]", errno, clia::util::process::strerror(errno));
+            this->handle_error();
+            this->handle_close();
+            peer->force_close();
+            return;
+        }
+    }
+
+    const auto n = input_buffer_.read_fd(fd_);
+    if (n > 0) {
+        peer->send(&input_buffer_);
+        this->pump_forward(peer);
+    } else if (0 == n) {
+        this->handle_forward_eof(peer);
+    } else if (errno != EAGAIN && errno != EWOULDBLOCK) {
+        this->handle_error();
+        this->handle_close();
+        peer->force_close();
+    }
+}
+
+void clia::net::TcpConnection::handle_forward_eof(const TcpConnectionPtr &peer) {
+    // 只把半关闭传给 peer，peer 到本连接的方向继续转发
+    forward_eof_ = true;
+    channel_.disable_reading();
+    peer->shutdown();
+    this->close_if_forward_done();
+}
+
+void clia::net::TcpConnection::close_if_forward_done() {
+    if (forward_eof_ && State::kDisconnecting == state_ && !channel_.is_writing() && !this->has_pending_output()) {
+        this->handle_close();
+    }
+}
+
+void clia::net::TcpConnection::pump_forward(const TcpConnectionPtr &peer) {
+    if (State::kDisconnected == state_) {
+        return;
+    }
+    // peer 还有普通发送数据时不能插队，等它写空后再由 peer 的 handle_write 回调这里
+    bool blocked = peer->has_pending_output();
+    if (pipe_fds_[0] >= 0) {
+        while (!blocked && pipe_bytes_ > 0) {
+            const auto n = ::splice(pipe_fds_[0], nullptr, peer->fd_, nullptr, pipe_bytes_, SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+            if (n > 0) {
+                pipe_bytes_ -= static_cast<std::size_t>(n);
+            } else if (n < 0 && (EAGAIN == errno || EWOULDBLOCK == errno)) {
+                blocked = true;
+            } else {
+                CLIA_FMT_LOG_ERROR("splice to peer fail, errno = [%d][%s]", errno, clia::util::process::strerror(errno));
+                this->handle_close();
+                peer->force_close();
+                return;
+            }
+        }
+        blocked = blocked || pipe_bytes_ > 0;
+    } else {
+        blocked = peer->output_buffer_.readable_bytes() >= kForwardHighWaterMark;
+    }
+
+    // 背压：peer 写不动时停止读取本连接，由 peer 的写事件恢复
+    if (blocked) {
+        if (!peer->channel_.is_writing()) {
+            peer->channel_.enable_writing();
+        }
+        if (channel_.is_reading()) {
+            channel_.disable_reading();
+        }
+    } else if (!channel_.is_reading() && !forward_eof_) {
+        channel_.enable_reading();
+    }
+}
+
+void clia::net::TcpConnection::stop_splice() {
+    for (int &fd : pipe_fds_) {
+        if (fd >= 0) {
+            ::close(fd);
+            fd = -1;
+        }
+    }
+    pipe_bytes_ = 0;
+}
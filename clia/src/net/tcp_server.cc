@@ -1,30 +1,141 @@
+#include <algorithm>
 #include <cassert>
+#include <map>
+#include <thread>
+#include <vector>
+
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/un.h>
 
 #include "clia/reactor/event_loop.h"
 #include "clia/net/acceptor.h"
 #include "clia/net/tcp_server.h"
 #include "clia/net/tcp_connection.h"
 #include "clia/log.h"
+#include "clia/reactor/channel.h"
+#include "clia/util/countdown_latch.h"
+#include "clia/util/process.h"
+
+namespace {
+    constexpr double kDrainCheckInterval = 0.05;
+
+    // 在 loop 线程中调用，把当前线程绑定到 cpu
+    void pin_current_thread(const int cpu) {
+        ::cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(cpu, &set);
+        const int ec = ::pthread_setaffinity_np(::pthread_self(), sizeof(set), &set);
+        if (ec != 0) {
+            CLIA_FMT_LOG_WARN("pthread_setaffinity_np fail, cpu = [%d], errno = [%d][%s]", cpu, ec, clia::util::process::strerror(ec));
+        }
+    }
+
+    // 本进程允许运行的 CPU 编号，按升序排列；取不到时退回 0 .. hardware_concurrency - 1
+    std::vector<int> allowed_cpus() {
+        std::vector<int> cpus;
+        ::cpu_set_t set;
+        CPU_ZERO(&set);
+        if (0 == ::sched_getaffinity(0, sizeof(set), &set)) {
+            for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+                if (CPU_ISSET(cpu, &set)) {
+                    cpus.push_back(cpu);
+                }
+            }
+        }
+        if (cpus.empty()) {
+            const int ncpu = std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+            for (int cpu = 0; cpu < ncpu; ++cpu) {
+                cpus.push_back(cpu);
+            }
+        }
+        return cpus;
+    }
+
+    // 在 loop 中执行并等待完成
+    void run_in_loop_and_wait(clia::reactor::EventLoop *loop, const clia::reactor::Functor &cb) {
+        clia::util::CountDownLatch latch(1);
+        loop->run_in_loop([&cb, &latch]() {
+            cb();
+            latch.count_down();
+        });
+        latch.wait();
+    }
+}
 
 clia::net::TcpServer::TcpServer(clia::reactor::EventLoop *loop, const InetAddress &listen_addr, const bool reuse_port) 
     : loop_(loop)
+    , listen_addr_(listen_addr)
+    , reuse_port_(reuse_port)
     , acceptor_(new Acceptor(loop, listen_addr, reuse_port))
     , threadpool_(new clia::reactor::EventLoopThreadPool(loop))
     , next_conn_id_(1)
     , started_(0)
+    , shared_nothing_(false)
+    , live_connections_(0)
+    , draining_(false)
+    , drain_initial_(0)
+    , drain_deadline_us_(0)
+{
+    assert(loop_ != nullptr);
+    acceptor_->set_new_connection_callback(
+        std::bind(&TcpServer::new_connection, this, std::placeholders::_1, std::placeholders::_2));
+}
+
+clia::net::TcpServer::TcpServer(clia::reactor::EventLoop *loop, const InetAddress &listen_addr, HandoffState *state)
+    : loop_(loop)
+    , listen_addr_(listen_addr)
+    , reuse_port_(false)
+    , acceptor_(new Acceptor(loop, state->listen_fd))
+    , threadpool_(new clia::reactor::EventLoopThreadPool(loop))
+    , next_conn_id_(1)
+    , started_(0)
+    , shared_nothing_(false)
+    , live_connections_(0)
+    , inherited_(*state)
+    , draining_(false)
+    , drain_initial_(0)
+    , drain_deadline_us_(0)
 {
     assert(loop_ != nullptr);
+    assert(state->valid());
+    *state = HandoffState();
     acceptor_->set_new_connection_callback(
         std::bind(&TcpServer::new_connection, this, std::placeholders::_1, std::placeholders::_2));
 }
 
 clia::net::TcpServer::~TcpServer() {
     assert(loop_->is_in_loop_thread());
+    if (drain_timer_.valid()) {
+        loop_->cancel(drain_timer_);
+    }
+    if (handoff_ && handoff_->socket) {
+        this->finish_handoff(false);
+    }
+    handoff_.reset();
+    for (const auto &conn : inherited_.connections) {
+        ::close(conn.first);
+    }
+    if (inherited_.channel_fd >= 0) {
+        ::close(inherited_.channel_fd);
+    }
     for (auto &it : connections_) {
         TcpConnectionPtr conn(it.second);
         it.second.reset();
         conn->get_loop()->run_in_loop(std::bind(&TcpConnection::connect_destoryed, conn));
     }
+    for (auto &shard : shards_) {
+        Shard *sd = shard.get();
+        ::run_in_loop_and_wait(sd->loop, [sd]() {
+            for (auto &it : sd->connections) {
+                it.second->connect_destoryed();
+            }
+            sd->connections.clear();
+            sd->acceptor.reset();
+        });
+    }
 }
 
 void clia::net::TcpServer::set_thread_init_callback(clia::reactor::EventLoopThread::ThreadInitCallBack &cb) {
@@ -47,12 +158,105 @@ void clia::net::TcpServer::set_thread_num(const int num) {
     threadpool_->set_thread_num(num);
 }
 
+void clia::net::TcpServer::set_fairness(const clia::reactor::FairnessOptions &options) {
+    fairness_ = options;
+}
+
+void clia::net::TcpServer::set_socket_profile(const SocketProfile &profile) {
+    socket_profile_ = profile;
+}
+
+bool clia::net::TcpServer::set_shared_nothing(const bool on) {
+    if (on && (!reuse_port_ || listen_addr_.is_unix() || inherited_.valid())) {
+        CLIA_LOG_ERROR << "TcpServer::set_shared_nothing requires reuse_port and a TCP address";
+        return false;
+    }
+    shared_nothing_ = on;
+    return true;
+}
+
+clia::net::TcpServer::SharedNothingStats clia::net::TcpServer::shared_nothing_stats() const {
+    SharedNothingStats stats;
+    for (const auto &shard : shards_) {
+        stats.accepted += shard->accepted.load(std::memory_order_relaxed);
+        stats.cpu_mismatches += shard->cpu_mismatches.load(std::memory_order_relaxed);
+    }
+    return stats;
+}
+
 void clia::net::TcpServer::start() {
     if (started_++ == 0) {
         threadpool_->start(thread_init_callback_);
+        if (shared_nothing_) {
+            this->start_shards();
+        }
+        if (fairness_.enabled()) {
+            const clia::reactor::FairnessOptions options = fairness_;
+            for (clia::reactor::EventLoop *io_loop : threadpool_->get_all_loops()) {
+                io_loop->run_in_loop([io_loop, options]() { io_loop->set_fairness(options); });
+            }
+        }
+        if (shared_nothing_) {
+            return;
+        }
         assert(!acceptor_->listening());
-        loop_->run_in_loop(std::bind(&Acceptor::listen, acceptor_.get()));
+        loop_->run_in_loop([this]() {
+            // 先接管交接过来的连接，再开始接受，最后通知旧进程停止接受
+            for (const auto &conn : inherited_.connections) {
+                this->new_connection(conn.first, conn.second);
+            }
+            inherited_.connections.clear();
+            acceptor_->listen();
+            if (inherited_.channel_fd >= 0) {
+                handoff::notify_ready(&inherited_);
+            }
+        });
+    }
+}
+
+std::size_t clia::net::TcpServer::connection_count() const noexcept {
+    return live_connections_.load(std::memory_order_relaxed);
+}
+
+void clia::net::TcpServer::stop_accepting() {
+    loop_->run_in_loop([this]() { acceptor_->stop_listening(); });
+    for (auto &shard : shards_) {
+        Shard *sd = shard.get();
+        sd->loop->run_in_loop([sd]() { sd->acceptor->stop_listening(); });
+    }
+}
+
+void clia::net::TcpServer::drain(const double timeout_sec, const DrainCallback &cb) {
+    loop_->run_in_loop([this, timeout_sec, cb]() { this->drain_in_loop(timeout_sec, cb, 0); });
+}
+
+bool clia::net::TcpServer::enable_handoff(const InetAddress &addr, const bool include_idle, const double drain_timeout_sec, const DrainCallback &cb) {
+    if (shared_nothing_ || !addr.is_unix()) {
+        CLIA_LOG_ERROR << "TcpServer::enable_handoff requires a unix domain address and is not supported in shared-nothing mode";
+        return false;
     }
+    loop_->run_in_loop([this, addr, include_idle, drain_timeout_sec, cb]() {
+        if (handoff_) {
+            CLIA_LOG_WARN << "TcpServer::enable_handoff already enabled";
+            return;
+        }
+        handoff_.reset(new Handoff);
+        handoff_->include_idle = include_idle;
+        handoff_->drain_timeout_sec = drain_timeout_sec;
+        handoff_->callback = cb;
+        handoff_->acceptor.reset(new Acceptor(loop_, addr, false));
+        handoff_->acceptor->set_new_connection_callback(
+            std::bind(&TcpServer::handle_handoff_connection, this, std::placeholders::_1, std::placeholders::_2));
+        handoff_->acceptor->listen();
+        const auto *un = reinterpret_cast<const ::sockaddr_un*>(addr.get_sockaddr());
+        struct stat st;
+        handoff_->path_ino = 0;
+        if (un->sun_path[0] != '\0' && 0 == ::lstat(un->sun_path, &st)) {
+            handoff_->path = un->sun_path;
+            handoff_->path_ino = st.st_ino;
+        }
+    });
+    return true;
 }
 void clia::net::TcpServer::new_connection(int sockfd, const InetAddress &peer_addr) {
     assert(loop_->is_in_loop_thread());
@@ -61,21 +265,23 @@ void clia::net::TcpServer::new_connection(int sockfd, const InetAddress &peer_ad
 
     clia::reactor::EventLoop *io_loop = threadpool_->get_next_loop();
     ++next_conn_id_;
+    live_connections_.fetch_add(1, std::memory_order_relaxed);
 
-    TcpConnectionPtr conn(new TcpConnection(io_loop, sockfd, peer_addr));
-    assert(connections_.find(sockfd) == connections_.end());
-    connections_[sockfd] = conn;
-    if (connection_callback_) {
-        conn->set_connection_callback(connection_callback_);
-    }
-    if (message_callback_) {
-        conn->set_message_callback(message_callback_);
-    }
-    if (write_complete_callback_) {
-        conn->set_write_complete_callback(write_complete_callback_);
-    }
-    conn->set_close_callback(std::bind(&TcpServer::remove_connection, this, std::placeholders::_1));
-    io_loop->run_in_loop(std::bind(&TcpConnection::connect_established, conn));
+    // 在 io loop 中创建，连接对象与缓冲区从使用它们的线程的 slab 池分配，销毁时也不走远端归还
+    io_loop->run_in_loop([this, io_loop, sockfd, peer_addr]() {
+        TcpConnectionPtr conn(TcpConnection::create(io_loop, sockfd, peer_addr));
+        this->setup_connection(conn);
+        conn->set_close_callback(std::bind(&TcpServer::remove_connection, this, std::placeholders::_1));
+        // 先于连接关闭时的 remove_connection_in_loop 进入 base loop 的队列
+        loop_->run_in_loop(std::bind(&TcpServer::add_connection_in_loop, this, conn));
+        conn->connect_established();
+    });
+}
+
+void clia::net::TcpServer::add_connection_in_loop(const TcpConnectionPtr &conn) {
+    assert(loop_->is_in_loop_thread());
+    assert(connections_.find(conn->fd()) == connections_.end());
+    connections_[conn->fd()] = conn;
 }
 
 void clia::net::TcpServer::remove_connection(const TcpConnectionPtr &conn) {
@@ -89,6 +295,253 @@ void clia::net::TcpServer::remove_connection_in_loop(const TcpConnectionPtr &con
     assert(connections_.find(conn->fd()) != connections_.end() && connections_[conn->fd()].get() == conn.get());
     const auto n = connections_.erase(conn->fd());
     assert(1 == n);
+    live_connections_.fetch_sub(1, std::memory_order_relaxed);
     clia::reactor::EventLoop *io_loop = conn->get_loop();
     io_loop->queue_in_loop(std::bind(&TcpConnection::connect_destoryed, conn));
-}
\ No newline at end of file
+}
+void clia::net::TcpServer::setup_connection(const TcpConnectionPtr &conn) {
+    conn->apply_socket_profile(socket_profile_);
+    if (connection_callback_) {
+        conn->set_connection_callback(connection_callback_);
+    }
+    if (message_callback_) {
+        conn->set_message_callback(message_callback_);
+    }
+    if (write_complete_callback_) {
+        conn->set_write_complete_callback(write_complete_callback_);
+    }
+}
+
+// 基础监听 socket 不 listen，不会加入 reuseport 组；各 loop 依次 listen，组内下标即 shard 下标。
+// CPU 到组内下标的映射按各 shard 实际绑定的 CPU 生成
+void clia::net::TcpServer::start_shards() {
+    const auto loops = threadpool_->get_all_loops();
+    const std::vector<int> cpus = ::allowed_cpus();
+    for (std::size_t i = 0; i < loops.size(); ++i) {
+        std::unique_ptr<Shard> shard(new Shard);
+        shard->loop = loops[i];
+        shard->cpu = cpus[i % cpus.size()];
+        shard->accepted = 0;
+        shard->cpu_mismatches = 0;
+        shard->acceptor.reset(new Acceptor(shard->loop, listen_addr_, true));
+        Shard *sd = shard.get();
+        sd->acceptor->set_new_connection_callback(
+            std::bind(&TcpServer::new_connection_in_shard, this, sd, std::placeholders::_1, std::placeholders::_2));
+        const bool pin = loops[i] != loop_;
+        ::run_in_loop_and_wait(sd->loop, [sd, pin]() {
+            if (pin) {
+                ::pin_current_thread(sd->cpu);
+            }
+            sd->acceptor->listen();
+        });
+        shards_.push_back(std::move(shard));
+    }
+    if (shards_.size() > 1) {
+        if (shards_.size() != cpus.size()) {
+            // 多出的 loop 与同一 CPU 上的第一个 loop 共用，收不到新连接；CPU 多于 loop 时其余 CPU 退回内核哈希
+            CLIA_LOG_WARN << "TcpServer: shared-nothing works best with one loop per CPU, loops = " << shards_.size()
+                << ", cpus = " << cpus.size();
+        }
+        std::vector<int> cpu_to_index(static_cast<std::size_t>(cpus.back()) + 1, -1);
+        for (std::size_t i = 0; i < shards_.size(); ++i) {
+            int &index = cpu_to_index[static_cast<std::size_t>(shards_[i]->cpu)];
+            if (index < 0) {
+                index = static_cast<int>(i);
+            }
+        }
+        shards_.front()->acceptor->attach_reuseport_cpu_steering(cpu_to_index);
+    }
+}
+
+void clia::net::TcpServer::new_connection_in_shard(Shard *shard, int sockfd, const InetAddress &peer_addr) {
+    assert(shard->loop->is_in_loop_thread());
+    TcpConnectionPtr conn(TcpConnection::create(shard->loop, sockfd, peer_addr));
+    shard->accepted.fetch_add(1, std::memory_order_relaxed);
+    const int incoming = conn->incoming_cpu();
+    const int current = ::sched_getcpu();
+    if (incoming >= 0 && incoming != current) {
+        shard->cpu_mismatches.fetch_add(1, std::memory_order_relaxed);
+        CLIA_LOG_DEBUG << "TcpServer::new_connection_in_shard " << peer_addr.get_addr()
+            << " incoming cpu " << incoming << " != loop cpu " << current;
+    }
+    this->setup_connection(conn);
+    shard->connections[sockfd] = conn;
+    live_connections_.fetch_add(1, std::memory_order_relaxed);
+    conn->set_close_callback(std::bind(&TcpServer::remove_connection_in_shard, this, shard, std::placeholders::_1));
+    conn->connect_established();
+}
+
+void clia::net::TcpServer::remove_connection_in_shard(Shard *shard, const TcpConnectionPtr &conn) {
+    assert(shard->loop->is_in_loop_thread());
+    const auto n = shard->connections.erase(conn->fd());
+    assert(1 == n);
+    (void)n;
+    live_connections_.fetch_sub(1, std::memory_order_relaxed);
+    shard->loop->queue_in_loop(std::bind(&TcpConnection::connect_destoryed, conn));
+}
+
+void clia::net::TcpServer::drain_in_loop(const double timeout_sec, const DrainCallback &cb, const std::size_t handed_off) {
+    assert(loop_->is_in_loop_thread());
+    if (draining_) {
+        CLIA_LOG_WARN << "TcpServer::drain already in progress";
+        return;
+    }
+    this->stop_accepting();
+    draining_ = true;
+    drain_stats_ = DrainStats();
+    drain_stats_.handed_off = handed_off;
+    drain_initial_ = this->connection_count();
+    drain_deadline_us_ = clia::util::Timestamp::now().micro_sec_since_epoch()
+        + static_cast<std::int64_t>(timeout_sec * clia::util::Timestamp::kMicroSecPerSec);
+    drain_callback_ = cb;
+    CLIA_LOG_INFO << "TcpServer::drain " << drain_initial_ << " connections, timeout " << timeout_sec << "s";
+    drain_timer_ = loop_->run_every(kDrainCheckInterval, std::bind(&TcpServer::check_drain, this));
+    this->check_drain();
+}
+
+void clia::net::TcpServer::check_drain() {
+    assert(loop_->is_in_loop_thread());
+    if (!draining_) {
+        return;
+    }
+    const std::size_t live = this->connection_count();
+    const bool expired = clia::util::Timestamp::now().micro_sec_since_epoch() >= drain_deadline_us_;
+    if (live > 0 && !expired) {
+        return;
+    }
+    if (live > 0) {
+        drain_stats_.forced = live;
+        for (const auto &it : connections_) {
+            it.second->force_close();
+        }
+        for (auto &shard : shards_) {
+            Shard *sd = shard.get();
+            sd->loop->run_in_loop([sd]() {
+                for (const auto &it : sd->connections) {
+                    it.second->force_close();
+                }
+            });
+        }
+    }
+    // 交出的连接在 drain 开始时可能尚未从连接表中移除，不计入自行关闭的数量
+    const std::size_t settled = drain_stats_.handed_off + drain_stats_.forced;
+    drain_stats_.closed = drain_initial_ > settled ? drain_initial_ - settled : 0;
+    draining_ = false;
+    loop_->cancel(drain_timer_);
+    drain_timer_ = clia::reactor::TimerId();
+    CLIA_LOG_INFO << "TcpServer::drain done, handed off " << drain_stats_.handed_off
+        << ", closed " << drain_stats_.closed << ", forced " << drain_stats_.forced;
+    DrainCallback cb;
+    cb.swap(drain_callback_);
+    if (cb) {
+        cb(drain_stats_);
+    }
+}
+
+// 新进程连上后先暂停空闲连接，再把监听 socket 与这些连接一起发出，等待 READY
+void clia::net::TcpServer::handle_handoff_connection(int sockfd, const InetAddress&) {
+    assert(loop_->is_in_loop_thread());
+    if (handoff_->socket || draining_) {
+        CLIA_LOG_WARN << "TcpServer: handoff already in progress, reject";
+        ::close(sockfd);
+        return;
+    }
+    handoff_->socket.reset(new Socket(sockfd));
+    if (handoff_->include_idle) {
+        std::map<clia::reactor::EventLoop*, std::vector<TcpConnectionPtr>> by_loop;
+        for (const auto &it : connections_) {
+            by_loop[it.second->get_loop()].push_back(it.second);
+        }
+        for (auto &it : by_loop) {
+            std::vector<TcpConnectionPtr> *conns = &it.second;
+            std::vector<TcpConnectionPtr> *suspended = &handoff_->suspended;
+            ::run_in_loop_and_wait(it.first, [conns, suspended]() {
+                for (const auto &conn : *conns) {
+                    if (conn->suspend_if_idle()) {
+                        suspended->push_back(conn);
+                    }
+                }
+            });
+        }
+    }
+    std::vector<std::pair<int, InetAddress>> fds;
+    fds.reserve(handoff_->suspended.size());
+    for (const auto &conn : handoff_->suspended) {
+        fds.emplace_back(conn->fd(), conn->peer_addr());
+    }
+    // 在可写事件中发送，新进程读得慢时不阻塞 base loop 的接受
+    handoff_->sender.reset(new handoff::Sender(acceptor_->fd(), fds));
+    handoff_->channel.reset(new clia::reactor::Channel(loop_, sockfd));
+    handoff_->channel->set_read_callback(std::bind(&TcpServer::handle_handoff_read, this));
+    handoff_->channel->set_write_callback(std::bind(&TcpServer::handle_handoff_write, this));
+    handoff_->channel->enable_reading();
+    this->handle_handoff_write();
+}
+
+void clia::net::TcpServer::handle_handoff_write() {
+    assert(loop_->is_in_loop_thread());
+    if (!handoff_->sender) {
+        return;
+    }
+    const int ret = handoff_->sender->write(handoff_->socket->fd());
+    if (ret < 0) {
+        this->finish_handoff(false);
+    } else if (0 == ret) {
+        if (!handoff_->channel->is_writing()) {
+            handoff_->channel->enable_writing();
+        }
+    } else {
+        handoff_->sender.reset();
+        if (handoff_->channel->is_writing()) {
+            handoff_->channel->disable_writing();
+        }
+        CLIA_LOG_INFO << "TcpServer: handed listener and " << handoff_->suspended.size() << " idle connections, waiting for ready";
+    }
+}
+
+void clia::net::TcpServer::handle_handoff_read() {
+    assert(loop_->is_in_loop_thread());
+    if (!handoff_->socket) {
+        return; // 本轮中已经结束
+    }
+    const int ret = handoff::read_ready(handoff_->socket->fd());
+    if (ret != 0) {
+        this->finish_handoff(ret > 0);
+    }
+}
+
+// ready 为 true 时关闭本进程持有的已交出连接(不会发送 FIN，新进程仍持有 socket)并开始 drain；否则恢复暂停的连接
+void clia::net::TcpServer::finish_handoff(const bool ready) {
+    assert(loop_->is_in_loop_thread());
+    std::vector<TcpConnectionPtr> suspended;
+    suspended.swap(handoff_->suspended);
+    handoff_->sender.reset();
+    // 可能正处于该 channel 的事件回调中，推迟到本轮事件处理之后再移除
+    std::shared_ptr<clia::reactor::Channel> channel(std::move(handoff_->channel));
+    std::shared_ptr<Socket> socket(std::move(handoff_->socket));
+    if (channel) {
+        channel->disable_all();
+    }
+    loop_->queue_in_loop([channel, socket]() {
+        if (channel) {
+            channel->remove();
+        }
+    });
+    if (!ready) {
+        CLIA_LOG_WARN << "TcpServer: handoff aborted, resume " << suspended.size() << " connections";
+        for (const auto &conn : suspended) {
+            conn->get_loop()->run_in_loop(std::bind(&TcpConnection::resume_reading, conn));
+        }
+        return;
+    }
+    for (const auto &conn : suspended) {
+        conn->force_close();
+    }
+    // 新进程会在同一路径上 enable_handoff 等待下一次重启，关闭监听并删除 socket 文件让它能够 bind
+    handoff_->acceptor->stop_listening();
+    struct stat st;
+    if (!handoff_->path.empty() && 0 == ::lstat(handoff_->path.c_str(), &st) && st.st_ino == handoff_->path_ino) {
+        ::unlink(handoff_->path.c_str());
+    }
+    this->drain_in_loop(handoff_->drain_timeout_sec, handoff_->callback, suspended.size());
+}
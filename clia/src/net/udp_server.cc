@@ -0,0 +1,123 @@
+#include <cassert>
+#include <cstring>
+
+#include "clia/net/udp_server.h"
+#include "clia/log.h"
+#include "clia/reactor/channel.h"
+#include "clia/reactor/event_loop.h"
+#include "clia/util/process.h"
+
+constexpr std::size_t clia::net::UdpServer::kMaxReadRounds;
+
+clia::net::UdpServer::UdpServer(clia::reactor::EventLoop *loop, const InetAddress &listen_addr, const bool reuse_port,
+    const std::size_t batch)
+    : loop_(loop)
+    , socket_(listen_addr.family(), batch)
+    , channel_(new clia::reactor::Channel(loop, socket_.fd()))
+    , batch_(batch)
+    , flush_queued_(false)
+    , tx_dropped_(0)
+{
+    assert(loop_ != nullptr);
+    socket_.set_reuse_addr(true);
+    socket_.set_reuse_port(reuse_port);
+    socket_.bind_address(listen_addr);
+    channel_->set_read_callback(std::bind(&UdpServer::handle_read, this, std::placeholders::_1));
+    send_msgs_.reserve(batch_);
+    pending_.reserve(batch_);
+}
+
+clia::net::UdpServer::~UdpServer() {
+    channel_->disable_all();
+    channel_->remove();
+}
+
+void clia::net::UdpServer::set_message_callback(const MessageCallback &cb) {
+    message_callback_ = cb;
+}
+
+bool clia::net::UdpServer::enable_gro() {
+    return socket_.set_gro(true);
+}
+
+bool clia::net::UdpServer::enable_gso() {
+    return socket_.set_gso(true);
+}
+
+void clia::net::UdpServer::start() {
+    loop_->run_in_loop(std::bind(&UdpServer::start_in_loop, this));
+}
+
+void clia::net::UdpServer::start_in_loop() {
+    assert(loop_->is_in_loop_thread());
+    channel_->enable_reading();
+}
+
+void clia::net::UdpServer::send(const InetAddress &peer, const void *data, const std::size_t len) {
+    assert(loop_->is_in_loop_thread());
+    if (pending_.size() >= batch_) {
+        this->flush();
+    }
+    const std::size_t offset = send_storage_.size();
+    const unsigned char *p = static_cast<const unsigned char*>(data);
+    send_storage_.insert(send_storage_.end(), p, p + len);
+    pending_.push_back(PendingSend{offset, len, peer});
+    if (!flush_queued_) {
+        // 等本轮事件处理完再发，同一轮产生的报文合并成一次 sendmmsg
+        flush_queued_ = true;
+        loop_->queue_in_loop(std::bind(&UdpServer::flush, this));
+    }
+}
+
+void clia::net::UdpServer::flush() {
+    assert(loop_->is_in_loop_thread());
+    flush_queued_ = false;
+    if (pending_.empty()) {
+        return;
+    }
+    send_msgs_.clear();
+    for (const PendingSend &pending : pending_) {
+        send_msgs_.push_back(UdpMessage{send_storage_.data() + pending.offset, pending.len, pending.peer});
+    }
+    const std::size_t sent = socket_.send_batch(send_msgs_.data(), send_msgs_.size());
+    if (sent < send_msgs_.size()) {
+        // UDP 不保证送达，发送缓冲区满时直接丢弃，不再等待可写
+        tx_dropped_ += send_msgs_.size() - sent;
+    }
+    pending_.clear();
+    send_storage_.clear();
+}
+
+clia::reactor::EventLoop* clia::net::UdpServer::get_loop() const noexcept {
+    return loop_;
+}
+
+int clia::net::UdpServer::fd() const noexcept {
+    return socket_.fd();
+}
+
+clia::net::UdpStats clia::net::UdpServer::stats() const noexcept {
+    UdpStats stats = socket_.stats();
+    stats.tx_dropped = tx_dropped_;
+    return stats;
+}
+
+void clia::net::UdpServer::handle_read(clia::util::Timestamp receive_time) {
+    assert(loop_->is_in_loop_thread());
+    for (std::size_t round = 0; round < kMaxReadRounds; ++round) {
+        const int n = socket_.recv_batch();
+        if (n < 0) {
+            if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+                CLIA_FMT_LOG_ERROR("recvmmsg fail, errno = [%d][%s]", errno, clia::util::process::strerror(errno));
+            }
+            break;
+        }
+        if (n > 0 && message_callback_) {
+            message_callback_(this, socket_.messages(), static_cast<std::size_t>(n), receive_time);
+        }
+        // 没读满一批说明内核队列已经空了
+        if (static_cast<std::size_t>(n) < batch_) {
+            break;
+        }
+    }
+}
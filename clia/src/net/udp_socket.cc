@@ -0,0 +1,276 @@
+#include <algorithm>
+#include <cassert>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+
+#include <unistd.h>
+#include <netinet/in.h>
+#include <netinet/udp.h>
+
+#include "clia/net/udp_socket.h"
+#include "clia/log.h"
+#include "clia/util/process.h"
+
+#ifndef SOL_UDP
+#define SOL_UDP 17
+#endif
+#ifndef UDP_SEGMENT
+#define UDP_SEGMENT 103
+#endif
+#ifndef UDP_GRO
+#define UDP_GRO 104
+#endif
+
+namespace {
+    constexpr std::size_t kRxControlLen = CMSG_SPACE(sizeof(int));
+    constexpr std::size_t kTxControlLen = CMSG_SPACE(sizeof(std::uint16_t));
+
+    int create_udp_socket(const ::sa_family_t family) noexcept {
+        const int sockfd = ::socket(family, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, IPPROTO_UDP);
+        if (-1 == sockfd) {
+            CLIA_FMT_LOG_FATAL("socket fail, errno = [%d][%s]", errno, clia::util::process::strerror(errno));
+            std::abort();
+        }
+        return sockfd;
+    }
+
+    // GRO 合并后的 segment 大小，没有控制消息时说明未合并
+    std::size_t gro_segment_size(const ::msghdr &hdr, const std::size_t len) noexcept {
+        for (::cmsghdr *cmsg = CMSG_FIRSTHDR(&hdr); cmsg != nullptr; cmsg = CMSG_NXTHDR(const_cast<::msghdr*>(&hdr), cmsg)) {
+            if (SOL_UDP == cmsg->cmsg_level && UDP_GRO == cmsg->cmsg_type) {
+                int segment = 0;
+                std::memcpy(&segment, CMSG_DATA(cmsg), sizeof(segment));
+                return segment > 0 ? static_cast<std::size_t>(segment) : len;
+            }
+        }
+        return len;
+    }
+}
+
+constexpr std::size_t clia::net::UdpSocket::kDefaultBatch;
+constexpr std::size_t clia::net::UdpSocket::kDefaultSlotSize;
+constexpr std::size_t clia::net::UdpSocket::kGroSlotSize;
+constexpr std::size_t clia::net::UdpSocket::kMaxGsoSegments;
+constexpr std::size_t clia::net::UdpSocket::kMaxGsoBytes;
+
+clia::net::UdpSocket::UdpSocket(const ::sa_family_t family, const std::size_t batch, const std::size_t slot_size)
+    : sockfd_(::create_udp_socket(family))
+    , batch_(std::max<std::size_t>(batch, 1))
+    , slot_size_(slot_size)
+    , gro_(false)
+    , gso_(false)
+{
+    this->alloc_slots();
+    tx_iovs_.resize(batch_);
+    tx_hdrs_.resize(batch_);
+    tx_controls_.resize(batch_ * ::kTxControlLen);
+}
+
+clia::net::UdpSocket::~UdpSocket() noexcept {
+    ::close(sockfd_);
+}
+
+int clia::net::UdpSocket::fd() const noexcept {
+    return sockfd_;
+}
+
+void clia::net::UdpSocket::bind_address(const InetAddress &local_addr) noexcept {
+    if (::bind(sockfd_, local_addr.get_sockaddr(), local_addr.socklen()) < 0) {
+        CLIA_FMT_LOG_FATAL("bind fail, errno = [%d][%s]", errno, clia::util::process::strerror(errno));
+        std::abort();
+    }
+}
+
+void clia::net::UdpSocket::set_reuse_addr(const bool on) noexcept {
+    const int optval = on ? 1 : 0;
+    if (::setsockopt(sockfd_, SOL_SOCKET, SO_REUSEADDR, &optval, static_cast<::socklen_t>(sizeof(optval))) < 0) {
+        CLIA_FMT_LOG_ERROR("set SO_REUSEADDR fail, errno = [%d][%s]", errno, clia::util::process::strerror(errno));
+    }
+}
+
+void clia::net::UdpSocket::set_reuse_port(const bool on) noexcept {
+    const int optval = on ? 1 : 0;
+    if (::setsockopt(sockfd_, SOL_SOCKET, SO_REUSEPORT, &optval, static_cast<::socklen_t>(sizeof(optval))) < 0) {
+        CLIA_FMT_LOG_ERROR("set SO_REUSEPORT fail, errno = [%d][%s]", errno, clia::util::process::strerror(errno));
+    }
+}
+
+bool clia::net::UdpSocket::set_gro(const bool on) {
+    const int optval = on ? 1 : 0;
+    if (::setsockopt(sockfd_, SOL_UDP, UDP_GRO, &optval, static_cast<::socklen_t>(sizeof(optval))) < 0) {
+        CLIA_FMT_LOG_WARN("set UDP_GRO fail, errno = [%d][%s]", errno, clia::util::process::strerror(errno));
+        return false;
+    }
+    gro_ = on;
+    // 合并后的报文最大可到 64K，接收槽必须放得下
+    if (gro_ && slot_size_ < kGroSlotSize) {
+        slot_size_ = kGroSlotSize;
+        this->alloc_slots();
+    }
+    return true;
+}
+
+bool clia::net::UdpSocket::set_gso(const bool on) noexcept {
+    if (on) {
+        // segment 为 0 表示不切分，仅用于探测内核是否支持
+        const int optval = 0;
+        if (::setsockopt(sockfd_, SOL_UDP, UDP_SEGMENT, &optval, static_cast<::socklen_t>(sizeof(optval))) < 0) {
+            CLIA_FMT_LOG_WARN("set UDP_SEGMENT fail, errno = [%d][%s]", errno, clia::util::process::strerror(errno));
+            return false;
+        }
+    }
+    gso_ = on;
+    return true;
+}
+
+bool clia::net::UdpSocket::gro() const noexcept {
+    return gro_;
+}
+
+bool clia::net::UdpSocket::gso() const noexcept {
+    return gso_;
+}
+
+void clia::net::UdpSocket::alloc_slots() {
+    slots_.assign(batch_ * slot_size_, 0);
+    names_.resize(batch_);
+    iovs_.resize(batch_);
+    hdrs_.resize(batch_);
+    controls_.assign(batch_ * ::kRxControlLen, 0);
+    messages_.reserve(batch_);
+    for (std::size_t i = 0; i < batch_; ++i) {
+        iovs_[i].iov_base = slots_.data() + i * slot_size_;
+        iovs_[i].iov_len = slot_size_;
+        std::memset(&hdrs_[i], 0, sizeof(hdrs_[i]));
+        hdrs_[i].msg_hdr.msg_name = &names_[i];
+        hdrs_[i].msg_hdr.msg_iov = &iovs_[i];
+        hdrs_[i].msg_hdr.msg_iovlen = 1;
+    }
+}
+
+int clia::net::UdpSocket::recv_batch() noexcept {
+    messages_.clear();
+    for (std::size_t i = 0; i < batch_; ++i) {
+        ::msghdr &hdr = hdrs_[i].msg_hdr;
+        hdr.msg_namelen = static_cast<::socklen_t>(sizeof(::sockaddr_in6));
+        hdr.msg_flags = 0;
+        if (gro_) {
+            hdr.msg_control = controls_.data() + i * ::kRxControlLen;
+            hdr.msg_controllen = ::kRxControlLen;
+        } else {
+            hdr.msg_control = nullptr;
+            hdr.msg_controllen = 0;
+        }
+    }
+    const int n = ::recvmmsg(sockfd_, hdrs_.data(), static_cast<unsigned int>(batch_), 0, nullptr);
+    if (n < 0) {
+        return -1;
+    }
+    ++stats_.rx_syscalls;
+    for (int i = 0; i < n; ++i) {
+        const ::msghdr &hdr = hdrs_[i].msg_hdr;
+        const std::size_t len = hdrs_[i].msg_len;
+        if (hdr.msg_flags & MSG_TRUNC) {
+            ++stats_.rx_truncated;
+        }
+        const unsigned char *slot = static_cast<const unsigned char*>(iovs_[i].iov_base);
+        const InetAddress peer(names_[i]);
+        const std::size_t segment = gro_ ? ::gro_segment_size(hdr, len) : len;
+        if (0 == len || 0 == segment) {
+            messages_.push_back(UdpMessage{slot, 0, peer});
+            continue;
+        }
+        for (std::size_t off = 0; off < len; off += segment) {
+            messages_.push_back(UdpMessage{slot + off, std::min(segment, len - off), peer});
+        }
+    }
+    stats_.rx_packets += messages_.size();
+    return static_cast<int>(messages_.size());
+}
+
+const clia::net::UdpMessage* clia::net::UdpSocket::messages() const noexcept {
+    return messages_.data();
+}
+
+std::size_t clia::net::UdpSocket::send_batch(const UdpMessage *msgs, const std::size_t count) noexcept {
+    std::size_t sent = 0;
+    while (sent < count) {
+        // 组装一批 mmsghdr，每个 mmsghdr 在 GSO 下可以携带多个同目标、同长度的报文
+        std::size_t nhdr = 0;
+        std::size_t next = sent;
+        while (next < count && next - sent < batch_) {
+            const UdpMessage &first = msgs[next];
+            ::mmsghdr &mhdr = tx_hdrs_[nhdr];
+            std::memset(&mhdr, 0, sizeof(mhdr));
+            ::iovec *iov = &tx_iovs_[next - sent];
+            iov[0].iov_base = const_cast<unsigned char*>(first.data);
+            iov[0].iov_len = first.len;
+            std::size_t nseg = 1;
+            std::size_t total = first.len;
+            if (gso_ && first.len > 0) {
+                while (next + nseg < count && nseg < kMaxGsoSegments && (next + nseg - sent) < batch_) {
+                    const UdpMessage &msg = msgs[next + nseg];
+                    if (msg.len > first.len || 0 == msg.len || total + msg.len > kMaxGsoBytes || msg.peer != first.peer) {
+                        break;
+                    }
+                    iov[nseg].iov_base = const_cast<unsigned char*>(msg.data);
+                    iov[nseg].iov_len = msg.len;
+                    total += msg.len;
+                    ++nseg;
+                    // 只有最后一个报文可以比 segment 短
+                    if (msg.len < first.len) {
+                        break;
+                    }
+                }
+            }
+            mhdr.msg_hdr.msg_name = const_cast<::sockaddr*>(first.peer.get_sockaddr());
+            mhdr.msg_hdr.msg_namelen = first.peer.socklen();
+            mhdr.msg_hdr.msg_iov = iov;
+            mhdr.msg_hdr.msg_iovlen = nseg;
+            if (nseg > 1) {
+                char *control = tx_controls_.data() + nhdr * ::kTxControlLen;
+                std::memset(control, 0, ::kTxControlLen);
+                mhdr.msg_hdr.msg_control = control;
+                mhdr.msg_hdr.msg_controllen = ::kTxControlLen;
+                ::cmsghdr *cmsg = CMSG_FIRSTHDR(&mhdr.msg_hdr);
+                cmsg->cmsg_level = SOL_UDP;
+                cmsg->cmsg_type = UDP_SEGMENT;
+                cmsg->cmsg_len = CMSG_LEN(sizeof(std::uint16_t));
+                const std::uint16_t segment = static_cast<std::uint16_t>(first.len);
+                std::memcpy(CMSG_DATA(cmsg), &segment, sizeof(segment));
+            }
+            next += nseg;
+            ++nhdr;
+        }
+
+        const int n = ::sendmmsg(sockfd_, tx_hdrs_.data(), static_cast<unsigned int>(nhdr), 0);
+        if (n < 0) {
+            if (EIO == errno && gso_) {
+                // 出口设备不支持校验和卸载时 GSO 会失败，退回逐个报文发送
+                CLIA_LOG_WARN << "UdpSocket::send_batch UDP_SEGMENT unsupported on route, disable gso";
+                gso_ = false;
+                continue;
+            }
+            if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                CLIA_FMT_LOG_ERROR("sendmmsg fail, errno = [%d][%s]", errno, clia::util::process::strerror(errno));
+            }
+            break;
+        }
+        ++stats_.tx_syscalls;
+        std::size_t done = 0;
+        for (int i = 0; i < n; ++i) {
+            done += tx_hdrs_[i].msg_hdr.msg_iovlen;
+        }
+        sent += done;
+        stats_.tx_packets += done;
+        if (static_cast<std::size_t>(n) < nhdr) {
+            break;
+        }
+    }
+    return sent;
+}
+
+const clia::net::UdpStats& clia::net::UdpSocket::stats() const noexcept {
+    return stats_;
+}
@@ -0,0 +1,376 @@
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+
+#include <unistd.h>
+
+#include "clia/net/upstream_pool.h"
+#include "clia/log.h"
+#include "clia/net/buffer.h"
+#include "clia/net/connector.h"
+#include "clia/net/tcp_connection.h"
+#include "clia/reactor/event_loop.h"
+
+namespace {
+    constexpr int kConnectRetryInitMs = 100;
+    constexpr int kConnectRetryMaxMs = 1000;
+
+    inline std::int64_t elapsed_us(const clia::util::Timestamp from, const clia::util::Timestamp to) noexcept {
+        return to.micro_sec_since_epoch() - from.micro_sec_since_epoch();
+    }
+}
+
+std::size_t clia::net::UpstreamPool::AddressHash::operator()(const InetAddress &addr) const noexcept {
+    std::uint64_t h = 14695981039346656037ULL;
+    const auto mix = [&h](const void *data, const std::size_t len) {
+        const unsigned char *p = static_cast<const unsigned char*>(data);
+        for (std::size_t i = 0; i < len; ++i) {
+            h = (h ^ p[i]) * 1099511628211ULL;
+        }
+    };
+    if (addr.is_unix()) {
+        mix(addr.get_sockaddr(), addr.socklen());
+    } else if (AF_INET6 == addr.family()) {
+        const auto *sa = reinterpret_cast<const ::sockaddr_in6*>(addr.get_sockaddr());
+        mix(&sa->sin6_addr, sizeof(sa->sin6_addr));
+        mix(&sa->sin6_port, sizeof(sa->sin6_port));
+    } else {
+        const auto *sa = reinterpret_cast<const ::sockaddr_in*>(addr.get_sockaddr());
+        mix(&sa->sin_addr, sizeof(sa->sin_addr));
+        mix(&sa->sin_port, sizeof(sa->sin_port));
+    }
+    return static_cast<std::size_t>(h);
+}
+
+clia::net::UpstreamPool::UpstreamPool(clia::reactor::EventLoop *loop)
+    : UpstreamPool(loop, Options())
+{
+    ;
+}
+
+clia::net::UpstreamPool::UpstreamPool(clia::reactor::EventLoop *loop, const Options &options)
+    : loop_(loop)
+    , options_(options)
+    , next_id_(0)
+{
+    assert(loop_ != nullptr);
+    assert(options_.max_outstanding > 0 && options_.max_connections > 0);
+    if (options_.health_check_interval_sec > 0.0) {
+        health_timer_ = loop_->run_every(options_.health_check_interval_sec, std::bind(&UpstreamPool::health_check, this));
+    }
+}
+
+clia::net::UpstreamPool::~UpstreamPool() {
+    assert(loop_->is_in_loop_thread());
+    if (health_timer_.valid()) {
+        loop_->cancel(health_timer_);
+    }
+    for (auto &it : upstreams_) {
+        Upstream *upstream = it.second.get();
+        for (const Waiter &waiter : upstream->waiters) {
+            loop_->cancel(waiter.timer);
+        }
+        for (auto &pending : upstream->connecting) {
+            loop_->cancel(pending.second.timer);
+            pending.second.connector->stop();
+        }
+    }
+    for (auto &it : conns_) {
+        TcpConnectionPtr conn(it.second.conn);
+        it.second.conn.reset();
+        loop_->run_in_loop(std::bind(&TcpConnection::connect_destoryed, conn));
+    }
+}
+
+void clia::net::UpstreamPool::acquire(const InetAddress &addr, const AcquireCallback &cb, const MessageCallback &on_message, const double timeout_sec) {
+    assert(loop_->is_in_loop_thread());
+    assert(on_message);
+    ++stats_.acquires;
+    Upstream *upstream = this->get_upstream(addr);
+    if (upstream->waiters.empty()) {
+        PooledConn *pooled = this->pick(upstream);
+        if (pooled != nullptr) {
+            ++stats_.hits;
+            this->lease(pooled, cb, on_message);
+            return;
+        }
+    }
+
+    ++stats_.misses;
+    const double timeout = timeout_sec > 0.0 ? timeout_sec : options_.wait_timeout_sec;
+    Waiter waiter;
+    waiter.id = ++next_id_;
+    waiter.callback = cb;
+    waiter.on_message = on_message;
+    waiter.enqueue_time = clia::util::Timestamp::now();
+    waiter.timer = loop_->run_after(timeout, std::bind(&UpstreamPool::on_wait_timeout, this, upstream, waiter.id));
+    upstream->waiters.push_back(std::move(waiter));
+    this->maybe_connect(upstream);
+    this->fail_waiters_if_unreachable(upstream);
+}
+
+void clia::net::UpstreamPool::release(const TcpConnectionPtr &conn, const bool reusable) {
+    assert(loop_->is_in_loop_thread());
+    const auto it = conns_.find(conn.get());
+    if (it == conns_.end()) {
+        return;     // 连接已关闭并移出连接池
+    }
+    PooledConn *pooled = &it->second;
+    Upstream *upstream = pooled->upstream;
+    assert(!pooled->leases.empty());
+    if (pooled->leases.empty()) {
+        return;
+    }
+    pooled->leases.pop_front();
+    if (!reusable || !conn->connected()) {
+        conn->force_close();
+        return;
+    }
+    if (pooled->leases.empty()) {
+        pooled->last_used = clia::util::Timestamp::now();
+    }
+    this->serve_waiters(upstream);
+
+    const auto again = conns_.find(conn.get());
+    if (again != conns_.end() && again->second.leases.empty() && this->idle_count(upstream) > options_.max_idle) {
+        this->evict(&again->second);
+    }
+}
+
+clia::net::UpstreamPool::Stats clia::net::UpstreamPool::stats() const {
+    assert(loop_->is_in_loop_thread());
+    Stats stats = stats_;
+    for (const auto &it : upstreams_) {
+        stats.connections += it.second->conns.size();
+        stats.idle += this->idle_count(it.second.get());
+        stats.waiting += it.second->waiters.size();
+    }
+    return stats;
+}
+
+clia::reactor::EventLoop* clia::net::UpstreamPool::get_loop() const noexcept {
+    return loop_;
+}
+
+clia::net::UpstreamPool::Upstream* clia::net::UpstreamPool::get_upstream(const InetAddress &addr) {
+    auto it = upstreams_.find(addr);
+    if (it == upstreams_.end()) {
+        it = upstreams_.emplace(addr, std::unique_ptr<Upstream>(new Upstream(addr))).first;
+    }
+    return it->second.get();
+}
+
+// 选未完成请求最少的连接；并列时选最近用过的，让多余连接自然空闲超时
+clia::net::UpstreamPool::PooledConn* clia::net::UpstreamPool::pick(Upstream *upstream) {
+    PooledConn *best = nullptr;
+    for (TcpConnection *conn : upstream->conns) {
+        PooledConn *pooled = &conns_.find(conn)->second;
+        if (!conn->connected() || pooled->leases.size() >= options_.max_outstanding) {
+            continue;
+        }
+        if (nullptr == best || pooled->leases.size() < best->leases.size()
+            || (pooled->leases.size() == best->leases.size() && pooled->last_used > best->last_used)) {
+            best = pooled;
+        }
+    }
+    return best;
+}
+
+void clia::net::UpstreamPool::lease(PooledConn *pooled, const AcquireCallback &cb, const MessageCallback &on_message) {
+    pooled->leases.push_back(Lease{++next_id_, on_message});
+    pooled->last_used = clia::util::Timestamp::now();
+    // 回调中可能 release 导致 pooled 失效，先持有连接
+    const TcpConnectionPtr conn = pooled->conn;
+    cb(conn);
+}
+
+void clia::net::UpstreamPool::serve_waiters(Upstream *upstream) {
+    while (!upstream->waiters.empty()) {
+        PooledConn *pooled = this->pick(upstream);
+        if (nullptr == pooled) {
+            break;
+        }
+        Waiter waiter = std::move(upstream->waiters.front());
+        upstream->waiters.pop_front();
+        loop_->cancel(waiter.timer);
+
+        const auto wait_us = static_cast<std::uint64_t>(std::max<std::int64_t>(0,
+            ::elapsed_us(waiter.enqueue_time, clia::util::Timestamp::now())));
+        ++stats_.wait_count;
+        stats_.wait_total_us += wait_us;
+        stats_.wait_max_us = std::max(stats_.wait_max_us, wait_us);
+        this->lease(pooled, waiter.callback, waiter.on_message);
+    }
+}
+
+void clia::net::UpstreamPool::maybe_connect(Upstream *upstream) {
+    const std::size_t wanted = (upstream->waiters.size() + options_.max_outstanding - 1) / options_.max_outstanding;
+    while (upstream->connecting.size() < wanted
+        && upstream->conns.size() + upstream->connecting.size() < options_.max_connections) {
+        this->open_connection(upstream);
+    }
+}
+
+void clia::net::UpstreamPool::open_connection(Upstream *upstream) {
+    const std::uint64_t connect_id = ++next_id_;
+    Pending pending;
+    pending.connector = std::make_shared<Connector>(loop_, upstream->addr);
+    pending.connector->set_retry_delay(kConnectRetryInitMs, kConnectRetryMaxMs);
+    pending.connector->set_new_connection_callback(
+        std::bind(&UpstreamPool::on_connected, this, upstream, connect_id, std::placeholders::_1));
+    pending.timer = loop_->run_after(options_.connect_timeout_sec,
+        std::bind(&UpstreamPool::on_connect_timeout, this, upstream, connect_id));
+    const auto connector = pending.connector;
+    upstream->connecting.emplace(connect_id, std::move(pending));
+    ++stats_.connects;
+    connector->start();
+}
+
+void clia::net::UpstreamPool::on_connected(Upstream *upstream, const std::uint64_t connect_id, const int sockfd) {
+    assert(loop_->is_in_loop_thread());
+    const auto it = upstream->connecting.find(connect_id);
+    if (it == upstream->connecting.end()) {
+        ::close(sockfd);
+        return;
+    }
+    loop_->cancel(it->second.timer);
+    // Connector 在回调返回前仍被 loop 中排队的任务持有，这里移除是安全的
+    upstream->connecting.erase(it);
+
+    TcpConnectionPtr conn(TcpConnection::create(loop_, sockfd, upstream->addr));
+    conn->set_message_callback(std::bind(&UpstreamPool::on_message, this,
+        std::placeholders::_1, std::placeholders::_2, std::placeholders::_3));
+    conn->set_close_callback(std::bind(&UpstreamPool::on_close, this, std::placeholders::_1));
+    PooledConn pooled;
+    pooled.upstream = upstream;
+    pooled.conn = conn;
+    pooled.last_used = clia::util::Timestamp::now();
+    conns_.emplace(conn.get(), std::move(pooled));
+    upstream->conns.push_back(conn.get());
+    conn->connect_established();
+
+    CLIA_LOG_DEBUG << "UpstreamPool::on_connected " << upstream->addr.get_addr() << " connections = " << upstream->conns.size();
+    this->serve_waiters(upstream);
+}
+
+void clia::net::UpstreamPool::on_connect_timeout(Upstream *upstream, const std::uint64_t connect_id) {
+    const auto it = upstream->connecting.find(connect_id);
+    if (it == upstream->connecting.end()) {
+        return;
+    }
+    CLIA_LOG_WARN << "UpstreamPool connect " << upstream->addr.get_addr() << " timeout";
+    it->second.connector->stop();
+    upstream->connecting.erase(it);
+    ++stats_.connect_failures;
+    this->fail_waiters_if_unreachable(upstream);
+}
+
+void clia::net::UpstreamPool::on_wait_timeout(Upstream *upstream, const std::uint64_t waiter_id) {
+    auto &waiters = upstream->waiters;
+    const auto it = std::find_if(waiters.begin(), waiters.end(), [waiter_id](const Waiter &w) {
+        return w.id == waiter_id;
+    });
+    if (it == waiters.end()) {
+        return;
+    }
+    const AcquireCallback cb = std::move(it->callback);
+    waiters.erase(it);
+    ++stats_.wait_timeouts;
+    cb(TcpConnectionPtr());
+}
+
+void clia::net::UpstreamPool::on_close(const TcpConnectionPtr &conn) {
+    assert(loop_->is_in_loop_thread());
+    const auto it = conns_.find(conn.get());
+    if (it != conns_.end()) {
+        Upstream *upstream = it->second.upstream;
+        upstream->conns.erase(std::remove(upstream->conns.begin(), upstream->conns.end(), conn.get()), upstream->conns.end());
+        conns_.erase(it);
+        // 还有请求在排队时补一个连接
+        this->maybe_connect(upstream);
+        this->fail_waiters_if_unreachable(upstream);
+    }
+    loop_->queue_in_loop(std::bind(&TcpConnection::connect_destoryed, conn));
+}
+
+// 数据交给最早的未完成请求，它 release 后剩余的数据继续交给下一个请求。
+// 空闲连接不应收到数据；收到即说明对端状态异常，直接淘汰
+void clia::net::UpstreamPool::on_message(const TcpConnectionPtr &conn, Buffer *buf, clia::util::Timestamp receive_time) {
+    while (buf->readable_bytes() > 0) {
+        const auto it = conns_.find(conn.get());
+        if (it == conns_.end()) {
+            buf->retrieve_all();
+            return;
+        }
+        PooledConn *pooled = &it->second;
+        if (pooled->leases.empty()) {
+            CLIA_LOG_WARN << "UpstreamPool unexpected " << buf->readable_bytes() << " bytes on idle connection " << conn->peer_addr().get_addr();
+            buf->retrieve_all();
+            this->evict(pooled);
+            return;
+        }
+        // 回调中可能 release，先复制
+        const std::uint64_t id = pooled->leases.front().id;
+        const MessageCallback cb = pooled->leases.front().on_message;
+        const std::size_t before = buf->readable_bytes();
+        if (cb) {
+            cb(conn, buf, receive_time);
+        }
+        const auto again = conns_.find(conn.get());
+        const bool same = again != conns_.end() && !again->second.leases.empty() && again->second.leases.front().id == id;
+        if (same && buf->readable_bytes() == before) {
+            return; // 响应还不完整
+        }
+    }
+}
+
+void clia::net::UpstreamPool::fail_waiters_if_unreachable(Upstream *upstream) {
+    if (upstream->waiters.empty() || !upstream->conns.empty() || !upstream->connecting.empty()) {
+        return;
+    }
+    std::deque<Waiter> waiters;
+    waiters.swap(upstream->waiters);
+    for (Waiter &waiter : waiters) {
+        loop_->cancel(waiter.timer);
+        waiter.callback(TcpConnectionPtr());
+    }
+}
+
+void clia::net::UpstreamPool::evict(PooledConn *pooled) {
+    ++stats_.evictions;
+    pooled->conn->force_close();
+}
+
+void clia::net::UpstreamPool::health_check() {
+    const auto now = clia::util::Timestamp::now();
+    const auto idle_timeout_us = static_cast<std::int64_t>(options_.idle_timeout_sec * clia::util::Timestamp::kMicroSecPerSec);
+    for (auto &it : upstreams_) {
+        Upstream *upstream = it.second.get();
+        std::size_t idle = this->idle_count(upstream);
+        // force_close 是异步的，遍历期间 conns 不会变化
+        for (TcpConnection *conn : upstream->conns) {
+            PooledConn *pooled = &conns_.find(conn)->second;
+            if (!pooled->leases.empty() || !conn->connected()) {
+                continue;
+            }
+            if (idle > options_.min_idle && ::elapsed_us(pooled->last_used, now) > idle_timeout_us) {
+                this->evict(pooled);
+                --idle;
+            }
+        }
+        while (idle + upstream->connecting.size() < options_.min_idle
+            && upstream->conns.size() + upstream->connecting.size() < options_.max_connections) {
+            this->open_connection(upstream);
+        }
+    }
+}
+
+std::size_t clia::net::UpstreamPool::idle_count(const Upstream *upstream) const {
+    std::size_t idle = 0;
+    for (TcpConnection *conn : upstream->conns) {
+        if (conn->connected() && conns_.find(conn)->second.leases.empty()) {
+            ++idle;
+        }
+    }
+    return idle;
+}
@@ -20,6 +20,7 @@ clia::reactor::Channel::Channel(EventLoop *loop, const int fd) noexcept
     , event_handling_(false)
     , added_to_loop_(false)
     , tied_(false)
+    , deferred_(false)
 {
     assert(fd != -1);
     assert(loop_ != nullptr);
@@ -121,6 +122,14 @@ void clia::reactor::Channel::set_index(int index) noexcept {
     index_ = index;
 }
 
+bool clia::reactor::Channel::is_deferred() const noexcept {
+    return deferred_;
+}
+
+void clia::reactor::Channel::set_deferred(const bool on) noexcept {
+    deferred_ = on;
+}
+
 clia::reactor::EventLoop* clia::reactor::Channel::owner_loop() noexcept {
     return loop_;
 }
@@ -1,4 +1,7 @@
+#include <algorithm>
+
 #include <unistd.h>
+#include <sys/epoll.h>
 #include <sys/eventfd.h>
 
 #include "clia/reactor/event_loop.h"
@@ -25,6 +28,7 @@ clia::reactor::EventLoop::EventLoop()
     , tid_(clia::util::process::get_tid())
     , wakeup_fd_(::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC)) 
     , current_active_channel_(nullptr)
+    , ready_count_(0)
 {
     assert(wakeup_fd_ != -1 && nullptr == kLoopInThisThread);
 #ifdef NDEBUG
@@ -40,6 +44,7 @@ clia::reactor::EventLoop::EventLoop()
 #endif
     kLoopInThisThread = this;
     poller_.reset(new Epoller(this));
+    timer_queue_.reset(new TimerQueue(this));
     wakeup_channel_.reset(new Channel(this, wakeup_fd_));
     wakeup_channel_->set_read_callback(std::bind(&EventLoop::handle_read, this));
     wakeup_channel_->enable_reading();
@@ -60,12 +65,20 @@ void clia::reactor::EventLoop::loop() {
 
     while (!quit_) {
         active_channels_.clear();
-        poll_return_time_ = poller_->poll(kPollTimeMs, &active_channels_);
+        // 就绪队列非空时不阻塞，只收集新事件
+        poll_return_time_ = poller_->poll(ready_channels_.empty() ? kPollTimeMs : 0, &active_channels_);
+        // 在处理活跃 channel 之前计数，本轮处理中新放入就绪队列的留到下一轮
+        ready_count_ = ready_channels_.size();
         event_handing_ = true;
         for (Channel *channel : active_channels_) {
+            // 已在就绪队列中的 channel 本轮由 run_ready_channels 处理，水平触发下其余事件下一轮仍会报告
+            if (channel->is_deferred()) {
+                continue;
+            }
             current_active_channel_ = channel;
             current_active_channel_->handle_event(poll_return_time_);
         }
+        this->run_ready_channels();
         current_active_channel_ = nullptr;
         event_handing_ = false;
         this->do_pending_functors();
@@ -105,6 +118,26 @@ void clia::reactor::EventLoop::queue_in_loop(Functor cb) {
     }
 }
 
+clia::reactor::TimerId clia::reactor::EventLoop::run_at(const clia::util::Timestamp time, Functor cb) {
+    return timer_queue_->add_timer(std::move(cb), time, 0.0);
+}
+
+clia::reactor::TimerId clia::reactor::EventLoop::run_after(const double delay_sec, Functor cb) {
+    const auto delta = static_cast<std::int64_t>(delay_sec * clia::util::Timestamp::kMicroSecPerSec);
+    const clia::util::Timestamp time(clia::util::Timestamp::now().micro_sec_since_epoch() + delta);
+    return this->run_at(time, std::move(cb));
+}
+
+clia::reactor::TimerId clia::reactor::EventLoop::run_every(const double interval_sec, Functor cb) {
+    const auto delta = static_cast<std::int64_t>(interval_sec * clia::util::Timestamp::kMicroSecPerSec);
+    const clia::util::Timestamp time(clia::util::Timestamp::now().micro_sec_since_epoch() + delta);
+    return timer_queue_->add_timer(std::move(cb), time, interval_sec);
+}
+
+void clia::reactor::EventLoop::cancel(const TimerId timer_id) {
+    timer_queue_->cancel(timer_id);
+}
+
 void clia::reactor::EventLoop::update_channel(Channel *channel) {
     assert(channel->owner_loop() == this && this->is_in_loop_thread());
     poller_->update_channel(channel);
@@ -116,6 +149,15 @@ void clia::reactor::EventLoop::remove_channel(Channel *channel) {
         assert(current_active_channel_ == channel || 
             std::find(active_channels_.begin(), active_channels_.end(), channel) == active_channels_.end());
     }
+    if (channel->is_deferred()) {
+        channel->set_deferred(false);
+        const auto it = std::find_if(ready_channels_.begin(), ready_channels_.end(),
+            [channel](const std::pair<Channel*, clia::util::Timestamp> &entry) { return entry.first == channel; });
+        if (static_cast<std::size_t>(it - ready_channels_.begin()) < ready_count_) {
+            --ready_count_;
+        }
+        ready_channels_.erase(it);
+    }
     poller_->remove_channel(channel);
 }
 
@@ -125,6 +167,58 @@ bool clia::reactor::EventLoop::has_channel(Channel *channel) const {
     return poller_->has_channel(channel);
 }
 
+void clia::reactor::EventLoop::set_fairness(const FairnessOptions &options) noexcept {
+    fairness_ = options;
+}
+
+const clia::reactor::FairnessOptions& clia::reactor::EventLoop::fairness() const noexcept {
+    return fairness_;
+}
+
+const clia::reactor::FairnessStats& clia::reactor::EventLoop::fairness_stats() const noexcept {
+    return fairness_stats_;
+}
+
+void clia::reactor::EventLoop::defer_channel(Channel *channel) {
+    assert(channel->owner_loop() == this && this->is_in_loop_thread());
+    if (channel->is_deferred()) {
+        return;
+    }
+    channel->set_deferred(true);
+    ready_channels_.emplace_back(channel, clia::util::Timestamp::now());
+    ++fairness_stats_.deferrals;
+    fairness_stats_.max_ready_size = std::max(fairness_stats_.max_ready_size, ready_channels_.size());
+}
+
+void clia::reactor::EventLoop::record_time_overrun() noexcept {
+    ++fairness_stats_.time_overruns;
+}
+
+// 只处理之前各轮留下的 channel，每个本轮只处理一次，处理中再次超预算的排到队尾，留到下一轮
+void clia::reactor::EventLoop::run_ready_channels() {
+    while (ready_count_ > 0 && !ready_channels_.empty()) {
+        --ready_count_;
+        Channel *channel = ready_channels_.front().first;
+        const clia::util::Timestamp since = ready_channels_.front().second;
+        ready_channels_.pop_front();
+        channel->set_deferred(false);
+
+        const clia::util::Timestamp now = clia::util::Timestamp::now();
+        const std::int64_t wait_us = now.micro_sec_since_epoch() - since.micro_sec_since_epoch();
+        fairness_stats_.max_ready_wait_us = std::max(fairness_stats_.max_ready_wait_us, wait_us);
+        if (wait_us > fairness_.starvation_threshold_us) {
+            ++fairness_stats_.starvations;
+        }
+        if (!channel->is_reading()) {
+            continue;
+        }
+        ++fairness_stats_.ready_runs;
+        current_active_channel_ = channel;
+        channel->set_revents(EPOLLIN);
+        channel->handle_event(now);
+    }
+}
+
 // 通过eventfd唤醒loop所在线程
 void clia::reactor::EventLoop::wakeup() {
     std::uint64_t one = 1;
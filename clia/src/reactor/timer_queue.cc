@@ -0,0 +1,205 @@
+#include <cassert>
+#include <cstring>
+#include <iterator>
+
+#include <unistd.h>
+#include <sys/timerfd.h>
+
+#include "clia/reactor/timer_queue.h"
+#include "clia/reactor/channel.h"
+#include "clia/reactor/event_loop.h"
+#include "clia/util/process.h"
+#include "clia/log.h"
+
+namespace {
+    constexpr std::int64_t kMinTimerMicroSec = 100;
+
+    clia::util::Timestamp add_time(const clia::util::Timestamp timestamp, const double seconds) noexcept {
+        const auto delta = static_cast<std::int64_t>(seconds * clia::util::Timestamp::kMicroSecPerSec);
+        return clia::util::Timestamp(timestamp.micro_sec_since_epoch() + delta);
+    }
+
+    int create_timerfd() noexcept {
+        const int timerfd = ::timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+        if (timerfd < 0) {
+            CLIA_FMT_LOG_FATAL("timerfd_create fail, errno = [%d][%s]", errno, clia::util::process::strerror(errno));
+            std::abort();
+        }
+        return timerfd;
+    }
+
+    void read_timerfd(const int timerfd) noexcept {
+        std::uint64_t howmany = 0;
+        const auto n = ::read(timerfd, &howmany, sizeof(howmany));
+        if (n != sizeof(howmany)) {
+            CLIA_LOG_ERROR << "TimerQueue::handle_read() reads " << n << " bytes instead of 8";
+        }
+    }
+
+    void reset_timerfd(const int timerfd, const clia::util::Timestamp expiration) noexcept {
+        std::int64_t micro_sec = expiration.micro_sec_since_epoch() - clia::util::Timestamp::now().micro_sec_since_epoch();
+        if (micro_sec < kMinTimerMicroSec) {
+            micro_sec = kMinTimerMicroSec;
+        }
+        ::itimerspec new_value;
+        std::memset(&new_value, 0, sizeof(new_value));
+        new_value.it_value.tv_sec = static_cast<std::time_t>(micro_sec / clia::util::Timestamp::kMicroSecPerSec);
+        new_value.it_value.tv_nsec = static_cast<long>((micro_sec % clia::util::Timestamp::kMicroSecPerSec) * 1000);
+        if (::timerfd_settime(timerfd, 0, &new_value, nullptr) < 0) {
+            CLIA_FMT_LOG_ERROR("timerfd_settime fail, errno = [%d][%s]", errno, clia::util::process::strerror(errno));
+        }
+    }
+}
+
+std::atomic<std::int64_t> clia::reactor::Timer::kNumCreated(0);
+
+clia::reactor::Timer::Timer(Functor cb, const clia::util::Timestamp when, const double interval_sec) noexcept
+    : callback_(std::move(cb))
+    , expiration_(when)
+    , interval_sec_(interval_sec)
+    , repeat_(interval_sec > 0.0)
+    , sequence_(++kNumCreated)
+{
+    ;
+}
+
+clia::reactor::Timer::~Timer() noexcept = default;
+
+void clia::reactor::Timer::run() const {
+    callback_();
+}
+
+clia::util::Timestamp clia::reactor::Timer::expiration() const noexcept {
+    return expiration_;
+}
+
+bool clia::reactor::Timer::repeat() const noexcept {
+    return repeat_;
+}
+
+std::int64_t clia::reactor::Timer::sequence() const noexcept {
+    return sequence_;
+}
+
+void clia::reactor::Timer::restart(const clia::util::Timestamp now) noexcept {
+    expiration_ = repeat_ ? ::add_time(now, interval_sec_) : clia::util::Timestamp();
+}
+
+clia::reactor::TimerQueue::TimerQueue(EventLoop *loop)
+    : loop_(loop)
+    , timerfd_(::create_timerfd())
+    , timerfd_channel_(new Channel(loop, timerfd_))
+    , calling_expired_timers_(false)
+{
+    timerfd_channel_->set_read_callback(std::bind(&TimerQueue::handle_read, this));
+    timerfd_channel_->enable_reading();
+}
+
+clia::reactor::TimerQueue::~TimerQueue() {
+    timerfd_channel_->disable_all();
+    timerfd_channel_->remove();
+    ::close(timerfd_);
+    for (const Entry &timer : timers_) {
+        delete timer.second;
+    }
+}
+
+clia::reactor::TimerId clia::reactor::TimerQueue::add_timer(Functor cb, const clia::util::Timestamp when, const double interval_sec) {
+    Timer *timer = new Timer(std::move(cb), when, interval_sec);
+    loop_->run_in_loop(std::bind(&TimerQueue::add_timer_in_loop, this, timer));
+    return TimerId(timer, timer->sequence());
+}
+
+void clia::reactor::TimerQueue::cancel(const TimerId timer_id) {
+    loop_->run_in_loop(std::bind(&TimerQueue::cancel_in_loop, this, timer_id));
+}
+
+void clia::reactor::TimerQueue::add_timer_in_loop(Timer *timer) {
+    assert(loop_->is_in_loop_thread());
+    const bool earliest_changed = this->insert(timer);
+    if (earliest_changed) {
+        ::reset_timerfd(timerfd_, timer->expiration());
+    }
+}
+
+void clia::reactor::TimerQueue::cancel_in_loop(const TimerId timer_id) {
+    assert(loop_->is_in_loop_thread());
+    assert(timers_.size() == active_timers_.size());
+    const ActiveTimer timer(timer_id.timer_, timer_id.sequence_);
+    const auto it = active_timers_.find(timer);
+    if (it != active_timers_.end()) {
+        const auto n = timers_.erase(Entry(it->first->expiration(), it->first));
+        assert(1 == n);
+        (void)n;
+        delete it->first;
+        active_timers_.erase(it);
+    } else if (calling_expired_timers_) {
+        // 正在执行回调的重复定时器，reset 时不再重新加入
+        canceling_timers_.insert(timer);
+    }
+    assert(timers_.size() == active_timers_.size());
+}
+
+void clia::reactor::TimerQueue::handle_read() {
+    assert(loop_->is_in_loop_thread());
+    const auto now = clia::util::Timestamp::now();
+    ::read_timerfd(timerfd_);
+
+    const std::vector<Entry> expired = this->get_expired(now);
+    calling_expired_timers_ = true;
+    canceling_timers_.clear();
+    for (const Entry &it : expired) {
+        it.second->run();
+    }
+    calling_expired_timers_ = false;
+    this->reset(expired, now);
+}
+
+std::vector<clia::reactor::TimerQueue::Entry> clia::reactor::TimerQueue::get_expired(const clia::util::Timestamp now) {
+    assert(timers_.size() == active_timers_.size());
+    std::vector<Entry> expired;
+    const Entry sentry(now, reinterpret_cast<Timer*>(UINTPTR_MAX));
+    const auto end = timers_.lower_bound(sentry);
+    assert(end == timers_.end() || now < end->first);
+    std::copy(timers_.begin(), end, std::back_inserter(expired));
+    timers_.erase(timers_.begin(), end);
+
+    for (const Entry &it : expired) {
+        const ActiveTimer timer(it.second, it.second->sequence());
+        const auto n = active_timers_.erase(timer);
+        assert(1 == n);
+        (void)n;
+    }
+    assert(timers_.size() == active_timers_.size());
+    return expired;
+}
+
+void clia::reactor::TimerQueue::reset(const std::vector<Entry> &expired, const clia::util::Timestamp now) {
+    for (const Entry &it : expired) {
+        const ActiveTimer timer(it.second, it.second->sequence());
+        if (it.second->repeat() && canceling_timers_.find(timer) == canceling_timers_.end()) {
+            it.second->restart(now);
+            this->insert(it.second);
+        } else {
+            delete it.second;
+        }
+    }
+    if (!timers_.empty()) {
+        ::reset_timerfd(timerfd_, timers_.begin()->second->expiration());
+    }
+}
+
+bool clia::reactor::TimerQueue::insert(Timer *timer) {
+    assert(loop_->is_in_loop_thread());
+    assert(timers_.size() == active_timers_.size());
+    bool earliest_changed = false;
+    const auto when = timer->expiration();
+    const auto it = timers_.begin();
+    if (it == timers_.end() || when < it->first) {
+        earliest_changed = true;
+    }
+    timers_.insert(Entry(when, timer));
+    active_timers_.insert(ActiveTimer(timer, timer->sequence()));
+    assert(timers_.size() == active_timers_.size());
+    return earliest_changed;
+}
@@ -0,0 +1,261 @@
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define CLIA_BYTE_SEARCH_X86 1
+#endif
+
+#include "clia/util/byte_search.h"
+
+namespace {
+    using FindByteFunc = const unsigned char* (*)(const unsigned char*, const unsigned char*, unsigned char);
+    using FindCrlfFunc = const unsigned char* (*)(const unsigned char*, const unsigned char*);
+    using FindAnyOfFunc = const unsigned char* (*)(const unsigned char*, const unsigned char*, const unsigned char*, std::size_t);
+
+    struct KernelTable {
+        clia::util::byte_search::Kernel kernel;
+        FindByteFunc find_byte;
+        FindCrlfFunc find_crlf;
+        FindAnyOfFunc find_any_of;
+    };
+
+    constexpr std::size_t kMaxVectorSet = 16;
+
+    // 单字节查找直接使用 memchr：glibc 已按 CPU 选择了向量化实现，自己再写一份没有收益
+    const unsigned char* find_byte_scalar(const unsigned char *begin, const unsigned char *end, const unsigned char c) {
+        return static_cast<const unsigned char*>(std::memchr(begin, c, end - begin));
+    }
+
+    // 借助 memchr 找 '\n' 再回看前一个字节，文本协议里两者几乎总是成对出现
+    const unsigned char* find_crlf_scalar(const unsigned char *begin, const unsigned char *end) {
+        const unsigned char *p = begin + 1;
+        while (p < end) {
+            p = static_cast<const unsigned char*>(std::memchr(p, '\n', end - p));
+            if (nullptr == p) {
+                return nullptr;
+            }
+            if ('\r' == p[-1]) {
+                return p - 1;
+            }
+            ++p;
+        }
+        return nullptr;
+    }
+
+    const unsigned char* find_any_of_scalar(const unsigned char *begin, const unsigned char *end, const unsigned char *set, const std::size_t set_len) {
+        bool table[256] = {false};
+        for (std::size_t i = 0; i < set_len; ++i) {
+            table[set[i]] = true;
+        }
+        for (const unsigned char *p = begin; p < end; ++p) {
+            if (table[*p]) {
+                return p;
+            }
+        }
+        return nullptr;
+    }
+
+#ifdef CLIA_BYTE_SEARCH_X86
+    __attribute__((target("sse2")))
+    const unsigned char* find_crlf_sse2(const unsigned char *begin, const unsigned char *end) {
+        const __m128i cr = _mm_set1_epi8('\r');
+        const __m128i lf = _mm_set1_epi8('\n');
+        const unsigned char *p = begin;
+        // 每轮 32 字节：先只看错位一字节后的 '\n'，没有命中直接跳过，命中后再与 '\r' 做精确匹配
+        // 同时比较 p 与 p + 1 两个错位的块，需要多留 1 字节
+        for (; end - p >= 33; p += 32) {
+            const __m128i lf0 = _mm_cmpeq_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 1)), lf);
+            const __m128i lf1 = _mm_cmpeq_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 17)), lf);
+            if (0 == _mm_movemask_epi8(_mm_or_si128(lf0, lf1))) {
+                continue;
+            }
+            const __m128i cr0 = _mm_cmpeq_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p)), cr);
+            const __m128i cr1 = _mm_cmpeq_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 16)), cr);
+            const unsigned mask = static_cast<unsigned>(_mm_movemask_epi8(_mm_and_si128(lf0, cr0)))
+                | (static_cast<unsigned>(_mm_movemask_epi8(_mm_and_si128(lf1, cr1))) << 16);
+            if (mask != 0) {
+                return p + __builtin_ctz(mask);
+            }
+        }
+        for (; p + 1 < end; ++p) {
+            if ('\r' == p[0] && '\n' == p[1]) {
+                return p;
+            }
+        }
+        return nullptr;
+    }
+
+    __attribute__((target("sse2")))
+    const unsigned char* find_any_of_sse2(const unsigned char *begin, const unsigned char *end, const unsigned char *set, const std::size_t set_len) {
+        if (set_len > kMaxVectorSet) {
+            return find_any_of_scalar(begin, end, set, set_len);
+        }
+        __m128i needles[kMaxVectorSet];
+        for (std::size_t i = 0; i < set_len; ++i) {
+            needles[i] = _mm_set1_epi8(static_cast<char>(set[i]));
+        }
+        const unsigned char *p = begin;
+        for (; end - p >= 16; p += 16) {
+            const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+            __m128i hit = _mm_setzero_si128();
+            for (std::size_t i = 0; i < set_len; ++i) {
+                hit = _mm_or_si128(hit, _mm_cmpeq_epi8(v, needles[i]));
+            }
+            const int mask = _mm_movemask_epi8(hit);
+            if (mask != 0) {
+                return p + __builtin_ctz(mask);
+            }
+        }
+        return find_any_of_scalar(p, end, set, set_len);
+    }
+
+    __attribute__((target("avx2")))
+    const unsigned char* find_crlf_avx2(const unsigned char *begin, const unsigned char *end) {
+        const __m256i cr = _mm256_set1_epi8('\r');
+        const __m256i lf = _mm256_set1_epi8('\n');
+        const unsigned char *p = begin;
+        for (; end - p >= 65; p += 64) {
+            const __m256i lf0 = _mm256_cmpeq_epi8(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + 1)), lf);
+            const __m256i lf1 = _mm256_cmpeq_epi8(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + 33)), lf);
+            const __m256i any = _mm256_or_si256(lf0, lf1);
+            if (_mm256_testz_si256(any, any)) {
+                continue;
+            }
+            const __m256i cr0 = _mm256_cmpeq_epi8(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(p)), cr);
+            const __m256i cr1 = _mm256_cmpeq_epi8(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + 32)), cr);
+            const std::uint64_t mask = static_cast<std::uint32_t>(_mm256_movemask_epi8(_mm256_and_si256(lf0, cr0)))
+                | (static_cast<std::uint64_t>(static_cast<std::uint32_t>(_mm256_movemask_epi8(_mm256_and_si256(lf1, cr1)))) << 32);
+            if (mask != 0) {
+                return p + __builtin_ctzll(mask);
+            }
+        }
+        return find_crlf_sse2(p, end);
+    }
+
+    __attribute__((target("avx2")))
+    const unsigned char* find_any_of_avx2(const unsigned char *begin, const unsigned char *end, const unsigned char *set, const std::size_t set_len) {
+        if (set_len > kMaxVectorSet) {
+            return find_any_of_scalar(begin, end, set, set_len);
+        }
+        __m256i needles[kMaxVectorSet];
+        for (std::size_t i = 0; i < set_len; ++i) {
+            needles[i] = _mm256_set1_epi8(static_cast<char>(set[i]));
+        }
+        const unsigned char *p = begin;
+        for (; end - p >= 32; p += 32) {
+            const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+            __m256i hit = _mm256_setzero_si256();
+            for (std::size_t i = 0; i < set_len; ++i) {
+                hit = _mm256_or_si256(hit, _mm256_cmpeq_epi8(v, needles[i]));
+            }
+            const unsigned mask = static_cast<unsigned>(_mm256_movemask_epi8(hit));
+            if (mask != 0) {
+                return p + __builtin_ctz(mask);
+            }
+        }
+        return find_any_of_sse2(p, end, set, set_len);
+    }
+#endif
+
+    const KernelTable kScalarTable = {
+        clia::util::byte_search::Kernel::kScalar, find_byte_scalar, find_crlf_scalar, find_any_of_scalar
+    };
+#ifdef CLIA_BYTE_SEARCH_X86
+    const KernelTable kSse2Table = {
+        clia::util::byte_search::Kernel::kSse2, find_byte_scalar, find_crlf_sse2, find_any_of_sse2
+    };
+    const KernelTable kAvx2Table = {
+        clia::util::byte_search::Kernel::kAvx2, find_byte_scalar, find_crlf_avx2, find_any_of_avx2
+    };
+#endif
+
+    std::atomic<const KernelTable*> kActiveTable(nullptr);
+
+    const KernelTable* table_of(const clia::util::byte_search::Kernel kernel) noexcept {
+#ifdef CLIA_BYTE_SEARCH_X86
+        __builtin_cpu_init();
+        switch (kernel) {
+        case clia::util::byte_search::Kernel::kAvx2:
+            return __builtin_cpu_supports("avx2") ? &kAvx2Table : nullptr;
+        case clia::util::byte_search::Kernel::kSse2:
+            return __builtin_cpu_supports("sse2") ? &kSse2Table : nullptr;
+        default:
+            return &kScalarTable;
+        }
+#else
+        return clia::util::byte_search::Kernel::kScalar == kernel ? &kScalarTable : nullptr;
+#endif
+    }
+
+    inline const KernelTable* active_table() noexcept {
+        const KernelTable *table = kActiveTable.load(std::memory_order_relaxed);
+        if (nullptr == table) {
+            table = table_of(clia::util::byte_search::Kernel::kAvx2);
+            if (nullptr == table) {
+                table = table_of(clia::util::byte_search::Kernel::kSse2);
+            }
+            if (nullptr == table) {
+                table = &kScalarTable;
+            }
+            kActiveTable.store(table, std::memory_order_relaxed);
+        }
+        return table;
+    }
+}
+
+clia::util::byte_search::Kernel clia::util::byte_search::active_kernel() noexcept {
+    return ::active_table()->kernel;
+}
+
+const char* clia::util::byte_search::kernel_name(const Kernel kernel) noexcept {
+    switch (kernel) {
+    case Kernel::kAvx2:
+        return "avx2";
+    case Kernel::kSse2:
+        return "sse2";
+    default:
+        return "scalar";
+    }
+}
+
+bool clia::util::byte_search::use_kernel(const Kernel kernel) noexcept {
+    const KernelTable *table = ::table_of(kernel);
+    if (nullptr == table) {
+        return false;
+    }
+    ::kActiveTable.store(table, std::memory_order_relaxed);
+    return true;
+}
+
+const unsigned char* clia::util::byte_search::find_byte(const unsigned char *begin, const unsigned char *end, const unsigned char c) noexcept {
+    return begin < end ? ::active_table()->find_byte(begin, end, c) : nullptr;
+}
+
+const unsigned char* clia::util::byte_search::find_crlf(const unsigned char *begin, const unsigned char *end) noexcept {
+    if (begin + 1 >= end) {
+        return nullptr;
+    }
+    // 典型文本协议中 '\n' 前面总是 '\r'，先用 memchr 定位第一个 '\n'；
+    // 一旦遇到孤立的 '\n'(二进制或非规范数据)，剩余部分交给向量化实现，避免逐个 '\n' 回退
+    const unsigned char *lf = static_cast<const unsigned char*>(std::memchr(begin + 1, '\n', end - begin - 1));
+    if (nullptr == lf) {
+        return nullptr;
+    }
+    if ('\r' == lf[-1]) {
+        return lf - 1;
+    }
+    return ::active_table()->find_crlf(lf, end);
+}
+
+const unsigned char* clia::util::byte_search::find_any_of(const unsigned char *begin, const unsigned char *end,
+    const unsigned char *set, const std::size_t set_len) noexcept {
+    if (begin >= end || 0 == set_len) {
+        return nullptr;
+    }
+    if (1 == set_len) {
+        return ::active_table()->find_byte(begin, end, set[0]);
+    }
+    return ::active_table()->find_any_of(begin, end, set, set_len);
+}
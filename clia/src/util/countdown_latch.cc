@@ -10,7 +10,7 @@ clia::util::CountDownLatch::CountDownLatch(int count) noexcept
 }
 
 void clia::util::CountDownLatch::wait() {
-    std::unique_lock<std::mutex> lck;
+    std::unique_lock<std::mutex> lck(lck_);
     while (count_ > 0) {
         condition_.wait(lck);
     }
@@ -0,0 +1,167 @@
+#include <cassert>
+#include <cstring>
+#include <mutex>
+
+#include "clia/util/memory_pool.h"
+#include "clia/util/process.h"
+
+namespace {
+    // 所有线程创建的池，只用于汇总统计。
+    // 池可能在静态对象析构期间才被最后一次归还销毁，这里故意不析构
+    std::mutex &registry_mutex() {
+        static std::mutex *mutex = new std::mutex;
+        return *mutex;
+    }
+
+    std::vector<clia::util::SlabPool*> &registry() {
+        static std::vector<clia::util::SlabPool*> *pools = new std::vector<clia::util::SlabPool*>;
+        return *pools;
+    }
+
+    std::size_t align_up(const std::size_t n) noexcept {
+        return (n + clia::util::SlabPool::kAlignment - 1) & ~(clia::util::SlabPool::kAlignment - 1);
+    }
+}
+
+constexpr std::size_t clia::util::SlabPool::kAlignment;
+
+clia::util::SlabPool::SlabPool(const char *name, const std::size_t block_size, const std::size_t blocks_per_slab)
+    : name_(name)
+    , block_size_(block_size)
+    , stride_(sizeof(Header) + ::align_up(block_size))
+    , blocks_per_slab_(blocks_per_slab > 0 ? blocks_per_slab : 1)
+    , owner_tid_(clia::util::process::get_tid())
+    , free_list_(nullptr)
+    , remote_free_(nullptr)
+    , refs_(1)
+    , hits_(0)
+    , misses_(0)
+    , remote_frees_(0)
+{
+    std::lock_guard<std::mutex> lock(::registry_mutex());
+    ::registry().push_back(this);
+}
+
+clia::util::SlabPool::~SlabPool() noexcept {
+    {
+        std::lock_guard<std::mutex> lock(::registry_mutex());
+        auto &pools = ::registry();
+        for (auto it = pools.begin(); it != pools.end(); ++it) {
+            if (*it == this) {
+                pools.erase(it);
+                break;
+            }
+        }
+    }
+    for (unsigned char *slab : slabs_) {
+        ::operator delete(slab);
+    }
+}
+
+void* clia::util::SlabPool::allocate() {
+    assert(clia::util::process::get_tid() == owner_tid_.load(std::memory_order_relaxed));
+    if (nullptr == free_list_) {
+        // 本地链表用空，先取回其他线程归还的块
+        free_list_ = remote_free_.exchange(nullptr, std::memory_order_acquire);
+        if (nullptr == free_list_) {
+            this->add_slab();
+            misses_.store(misses_.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        } else {
+            hits_.store(hits_.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        }
+    } else {
+        hits_.store(hits_.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    }
+    Header *header = free_list_;
+    free_list_ = header->next;
+    header->next = nullptr;
+    refs_.fetch_add(1, std::memory_order_relaxed);
+    return header + 1;
+}
+
+void clia::util::SlabPool::deallocate(void *ptr) noexcept {
+    if (nullptr == ptr) {
+        return;
+    }
+    Header *header = static_cast<Header*>(ptr) - 1;
+    SlabPool *owner = header->owner;
+    if (clia::util::process::get_tid() == owner->owner_tid_.load(std::memory_order_relaxed)) {
+        // 所属线程还持有一个引用，计数不会在这里归零
+        header->next = owner->free_list_;
+        owner->free_list_ = header;
+        owner->refs_.fetch_sub(1, std::memory_order_relaxed);
+    } else {
+        owner->push_remote(header);
+        owner->unref();
+    }
+}
+
+void clia::util::SlabPool::release() noexcept {
+    assert(clia::util::process::get_tid() == owner_tid_.load(std::memory_order_relaxed));
+    owner_tid_.store(0, std::memory_order_relaxed);
+    this->unref();
+}
+
+void clia::util::SlabPool::unref() noexcept {
+    if (1 == refs_.fetch_sub(1, std::memory_order_acq_rel)) {
+        delete this;
+    }
+}
+
+const char* clia::util::SlabPool::name() const noexcept {
+    return name_;
+}
+
+std::size_t clia::util::SlabPool::block_size() const noexcept {
+    return block_size_;
+}
+
+clia::util::SlabPool::Stats clia::util::SlabPool::stats() const noexcept {
+    Stats stats;
+    stats.hits = hits_.load(std::memory_order_relaxed);
+    stats.misses = misses_.load(std::memory_order_relaxed);
+    stats.remote_frees = remote_frees_.load(std::memory_order_relaxed);
+    // slab 只在 miss 时增加，每次 miss 恰好新增一个 slab
+    stats.slabs = stats.misses;
+    stats.bytes = stats.slabs * stride_ * blocks_per_slab_;
+    return stats;
+}
+
+clia::util::SlabPool::Stats clia::util::SlabPool::aggregate(const char *name) {
+    Stats total;
+    std::lock_guard<std::mutex> lock(::registry_mutex());
+    for (const SlabPool *pool : ::registry()) {
+        if (0 != std::strcmp(pool->name_, name)) {
+            continue;
+        }
+        const Stats stats = pool->stats();
+        total.hits += stats.hits;
+        total.misses += stats.misses;
+        total.remote_frees += stats.remote_frees;
+        total.slabs += stats.slabs;
+        total.bytes += stats.bytes;
+    }
+    return total;
+}
+
+void clia::util::SlabPool::add_slab() {
+    unsigned char *slab = static_cast<unsigned char*>(::operator new(stride_ * blocks_per_slab_));
+    slabs_.push_back(slab);
+    // 按地址顺序串起来，先分配低地址的块
+    Header *next = nullptr;
+    for (std::size_t i = blocks_per_slab_; i > 0; --i) {
+        Header *header = reinterpret_cast<Header*>(slab + (i - 1) * stride_);
+        header->owner = this;
+        header->next = next;
+        next = header;
+    }
+    free_list_ = next;
+}
+
+void clia::util::SlabPool::push_remote(Header *header) noexcept {
+    Header *head = remote_free_.load(std::memory_order_relaxed);
+    do {
+        header->next = head;
+    } while (!remote_free_.compare_exchange_weak(head, header, std::memory_order_release, std::memory_order_relaxed));
+    remote_frees_.fetch_add(1, std::memory_order_relaxed);
+}
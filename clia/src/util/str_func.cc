@@ -0,0 +1,318 @@
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+#include "clia/util/str_func.h"
+
+// 浮点数的最短往返表示采用 Grisu2 (Florian Loitsch, "Printing Floating-Point Numbers Quickly and Accurately
+// with Integers")：结果总能精确还原原值，绝大多数情况下也是最短的
+namespace {
+    // f * 2^e
+    struct DiyFp {
+        std::uint64_t f;
+        int e;
+    };
+
+    DiyFp multiply(const DiyFp &x, const DiyFp &y) noexcept {
+        constexpr std::uint64_t kMask32 = 0xffffffffu;
+        const std::uint64_t a = x.f >> 32;
+        const std::uint64_t b = x.f & kMask32;
+        const std::uint64_t c = y.f >> 32;
+        const std::uint64_t d = y.f & kMask32;
+        const std::uint64_t ac = a * c;
+        const std::uint64_t bc = b * c;
+        const std::uint64_t ad = a * d;
+        const std::uint64_t bd = b * d;
+        std::uint64_t tmp = (bd >> 32) + (ad & kMask32) + (bc & kMask32);
+        tmp += std::uint64_t(1) << 31;  // 四舍五入
+        return DiyFp{ac + (ad >> 32) + (bc >> 32) + (tmp >> 32), x.e + y.e + 64};
+    }
+
+    DiyFp normalize(const DiyFp &v) noexcept {
+        const int shift = __builtin_clzll(v.f);
+        return DiyFp{v.f << shift, v.e - shift};
+    }
+
+    // 把非零有限值拆成规格化的 v 以及与相邻可表示值之间的中点 minus、plus，minus 与 plus 指数相同
+    template <typename Bits, int kSignificandBits, int kExponentBias>
+    void decompose(const Bits bits, DiyFp *v, DiyFp *minus, DiyFp *plus) noexcept {
+        constexpr Bits kHiddenBit = Bits(1) << kSignificandBits;
+        const std::uint64_t significand = bits & (kHiddenBit - 1);
+        const int biased_e = static_cast<int>((bits >> kSignificandBits) & (2 * kExponentBias + 1));
+        DiyFp w;
+        if (biased_e != 0) {
+            w = DiyFp{significand + kHiddenBit, biased_e - kExponentBias - kSignificandBits};
+        } else {
+            w = DiyFp{significand, 1 - kExponentBias - kSignificandBits};
+        }
+        *plus = normalize(DiyFp{(w.f << 1) + 1, w.e - 1});
+        // 尾数为 0 时下方相邻值的间距只有上方的一半
+        DiyFp m = (0 == significand && biased_e > 1) ? DiyFp{(w.f << 2) - 1, w.e - 2} : DiyFp{(w.f << 1) - 1, w.e - 1};
+        m.f <<= m.e - plus->e;
+        m.e = plus->e;
+        *minus = m;
+        *v = normalize(w);
+    }
+
+    // 10^-348 到 10^340，步长为 8 的规格化 10 的幂
+    constexpr DiyFp kCachedPowers[] = {
+        {0xfa8fd5a0081c0288ull, -1220}, {0xbaaee17fa23ebf76ull, -1193}, {0x8b16fb203055ac76ull, -1166},
+        {0xcf42894a5dce35eaull, -1140}, {0x9a6bb0aa55653b2dull, -1113}, {0xe61acf033d1a45dfull, -1087},
+        {0xab70fe17c79ac6caull, -1060}, {0xff77b1fcbebcdc4full, -1034}, {0xbe5691ef416bd60cull, -1007},
+        {0x8dd01fad907ffc3cull, -980}, {0xd3515c2831559a83ull, -954}, {0x9d71ac8fada6c9b5ull, -927},
+        {0xea9c227723ee8bcbull, -901}, {0xaecc49914078536dull, -874}, {0x823c12795db6ce57ull, -847},
+        {0xc21094364dfb5637ull, -821}, {0x9096ea6f3848984full, -794}, {0xd77485cb25823ac7ull, -768},
+        {0xa086cfcd97bf97f4ull, -741}, {0xef340a98172aace5ull, -715}, {0xb23867fb2a35b28eull, -688},
+        {0x84c8d4dfd2c63f3bull, -661}, {0xc5dd44271ad3cdbaull, -635}, {0x936b9fcebb25c996ull, -608},
+        {0xdbac6c247d62a584ull, -582}, {0xa3ab66580d5fdaf6ull, -555}, {0xf3e2f893dec3f126ull, -529},
+        {0xb5b5ada8aaff80b8ull, -502}, {0x87625f056c7c4a8bull, -475}, {0xc9bcff6034c13053ull, -449},
+        {0x964e858c91ba2655ull, -422}, {0xdff9772470297ebdull, -396}, {0xa6dfbd9fb8e5b88full, -369},
+        {0xf8a95fcf88747d94ull, -343}, {0xb94470938fa89bcfull, -316}, {0x8a08f0f8bf0f156bull, -289},
+        {0xcdb02555653131b6ull, -263}, {0x993fe2c6d07b7facull, -236}, {0xe45c10c42a2b3b06ull, -210},
+        {0xaa242499697392d3ull, -183}, {0xfd87b5f28300ca0eull, -157}, {0xbce5086492111aebull, -130},
+        {0x8cbccc096f5088ccull, -103}, {0xd1b71758e219652cull, -77}, {0x9c40000000000000ull, -50},
+        {0xe8d4a51000000000ull, -24}, {0xad78ebc5ac620000ull, 3}, {0x813f3978f8940984ull, 30},
+        {0xc097ce7bc90715b3ull, 56}, {0x8f7e32ce7bea5c70ull, 83}, {0xd5d238a4abe98068ull, 109},
+        {0x9f4f2726179a2245ull, 136}, {0xed63a231d4c4fb27ull, 162}, {0xb0de65388cc8ada8ull, 189},
+        {0x83c7088e1aab65dbull, 216}, {0xc45d1df942711d9aull, 242}, {0x924d692ca61be758ull, 269},
+        {0xda01ee641a708deaull, 295}, {0xa26da3999aef774aull, 322}, {0xf209787bb47d6b85ull, 348},
+        {0xb454e4a179dd1877ull, 375}, {0x865b86925b9bc5c2ull, 402}, {0xc83553c5c8965d3dull, 428},
+        {0x952ab45cfa97a0b3ull, 455}, {0xde469fbd99a05fe3ull, 481}, {0xa59bc234db398c25ull, 508},
+        {0xf6c69a72a3989f5cull, 534}, {0xb7dcbf5354e9beceull, 561}, {0x88fcf317f22241e2ull, 588},
+        {0xcc20ce9bd35c78a5ull, 614}, {0x98165af37b2153dfull, 641}, {0xe2a0b5dc971f303aull, 667},
+        {0xa8d9d1535ce3b396ull, 694}, {0xfb9b7cd9a4a7443cull, 720}, {0xbb764c4ca7a44410ull, 747},
+        {0x8bab8eefb6409c1aull, 774}, {0xd01fef10a657842cull, 800}, {0x9b10a4e5e9913129ull, 827},
+        {0xe7109bfba19c0c9dull, 853}, {0xac2820d9623bf429ull, 880}, {0x80444b5e7aa7cf85ull, 907},
+        {0xbf21e44003acdd2dull, 933}, {0x8e679c2f5e44ff8full, 960}, {0xd433179d9c8cb841ull, 986},
+        {0x9e19db92b4e31ba9ull, 1013}, {0xeb96bf6ebadf77d9ull, 1039}, {0xaf87023b9bf0ee6bull, 1066},
+    };
+
+    // 取 c = 10^-k 使 e + c.e 落在 [-60, -32] 内
+    DiyFp cached_power(const int e, int *k) noexcept {
+        const double dk = (-61 - e) * 0.30102999566398114 + 347;
+        int ik = static_cast<int>(dk);
+        if (dk - ik > 0.0) {
+            ++ik;
+        }
+        const unsigned index = static_cast<unsigned>((ik >> 3) + 1);
+        *k = -(-348 + static_cast<int>(index << 3));
+        return kCachedPowers[index];
+    }
+
+    constexpr std::uint64_t kPow10[] = {
+        1ull, 10ull, 100ull, 1000ull, 10000ull, 100000ull, 1000000ull, 10000000ull, 100000000ull, 1000000000ull,
+        10000000000ull, 100000000000ull, 1000000000000ull, 10000000000000ull, 100000000000000ull,
+        1000000000000000ull, 10000000000000000ull, 100000000000000000ull, 1000000000000000000ull,
+        10000000000000000000ull,
+    };
+
+    int count_digits(const std::uint32_t n) noexcept {
+        int digits = 1;
+        while (digits < 10 && n >= kPow10[digits]) {
+            ++digits;
+        }
+        return digits;
+    }
+
+    // 在不越出 (minus, plus) 的前提下把最后一位向 w 靠拢
+    void round_weed(char *digits, const int len, const std::uint64_t delta, std::uint64_t rest,
+        const std::uint64_t ten_kappa, const std::uint64_t wp_w) noexcept {
+        while (rest < wp_w && delta - rest >= ten_kappa &&
+            (rest + ten_kappa < wp_w || wp_w - rest > rest + ten_kappa - wp_w)) {
+            --digits[len - 1];
+            rest += ten_kappa;
+        }
+    }
+
+    // 生成 plus 的十进制位直到落入区间，返回位数，*k 加上丢弃的位数
+    int generate_digits(const DiyFp &w, const DiyFp &plus, std::uint64_t delta, char *digits, int *k) noexcept {
+        const DiyFp one{std::uint64_t(1) << -plus.e, plus.e};
+        const std::uint64_t wp_w = plus.f - w.f;
+        std::uint32_t p1 = static_cast<std::uint32_t>(plus.f >> -one.e);
+        std::uint64_t p2 = plus.f & (one.f - 1);
+        int kappa = count_digits(p1);
+        int len = 0;
+        while (kappa > 0) {
+            std::uint32_t d = 0;
+            switch (kappa) {
+            case 10: d = p1 / 1000000000; p1 %= 1000000000; break;
+            case  9: d = p1 /  100000000; p1 %=  100000000; break;
+            case  8: d = p1 /   10000000; p1 %=   10000000; break;
+            case  7: d = p1 /    1000000; p1 %=    1000000; break;
+            case  6: d = p1 /     100000; p1 %=     100000; break;
+            case  5: d = p1 /      10000; p1 %=      10000; break;
+            case  4: d = p1 /       1000; p1 %=       1000; break;
+            case  3: d = p1 /        100; p1 %=        100; break;
+            case  2: d = p1 /         10; p1 %=         10; break;
+            case  1: d = p1;              p1 =           0; break;
+            default: break;
+            }
+            if (d != 0 || len != 0) {
+                digits[len++] = static_cast<char>('0' + d);
+            }
+            --kappa;
+            const std::uint64_t rest = (static_cast<std::uint64_t>(p1) << -one.e) + p2;
+            if (rest <= delta) {
+                *k += kappa;
+                ::round_weed(digits, len, delta, rest, kPow10[kappa] << -one.e, wp_w);
+                return len;
+            }
+        }
+        for (;;) {
+            p2 *= 10;
+            delta *= 10;
+            const char d = static_cast<char>(p2 >> -one.e);
+            if (d != 0 || len != 0) {
+                digits[len++] = static_cast<char>('0' + d);
+            }
+            p2 &= one.f - 1;
+            --kappa;
+            if (p2 < delta) {
+                *k += kappa;
+                const int index = -kappa;
+                ::round_weed(digits, len, delta, p2, one.f, wp_w * (index < 20 ? kPow10[index] : 0));
+                return len;
+            }
+        }
+    }
+
+    // digits * 10^k 写成定点或科学计数法，返回长度
+    std::size_t layout(char *out, const char *digits, const int len, const int k) noexcept {
+        const int point = len + k;     // 小数点相对第一位数字的位置
+        char *p = out;
+        if (k >= 0 && point <= 21) {
+            std::memcpy(p, digits, len);
+            p += len;
+            std::memset(p, '0', k);
+            p += k;
+        } else if (point > 0 && point <= 21) {
+            std::memcpy(p, digits, point);
+            p += point;
+            *p++ = '.';
+            std::memcpy(p, digits + point, len - point);
+            p += len - point;
+        } else if (point > -6 && point <= 0) {
+            *p++ = '0';
+            *p++ = '.';
+            std::memset(p, '0', -point);
+            p += -point;
+            std::memcpy(p, digits, len);
+            p += len;
+        } else {
+            *p++ = digits[0];
+            if (len > 1) {
+                *p++ = '.';
+                std::memcpy(p, digits + 1, len - 1);
+                p += len - 1;
+            }
+            int exp = point - 1;
+            *p++ = 'e';
+            *p++ = exp < 0 ? '-' : '+';
+            exp = exp < 0 ? -exp : exp;
+            if (exp >= 100) {
+                *p++ = static_cast<char>('0' + exp / 100);
+                exp %= 100;
+            }
+            clia::util::str_func::write_2digits(p, static_cast<unsigned>(exp));
+            p += 2;
+        }
+        return p - out;
+    }
+
+    template <typename Float, typename Bits, int kSignificandBits, int kExponentBias>
+    std::size_t convert_float(char *outbuf, const int size, const Float value) noexcept {
+        if (size < 32) {
+            return 0;
+        }
+        Bits bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+        char *p = outbuf;
+        if (std::isnan(value)) {
+            std::memcpy(p, "nan", 3);
+            p += 3;
+        } else {
+            if (std::signbit(value)) {
+                *p++ = '-';
+            }
+            if (std::isinf(value)) {
+                std::memcpy(p, "inf", 3);
+                p += 3;
+            } else if (0 == value) {
+                *p++ = '0';
+            } else {
+                DiyFp v, minus, plus;
+                ::decompose<Bits, kSignificandBits, kExponentBias>(bits, &v, &minus, &plus);
+                int k = 0;
+                const DiyFp c = ::cached_power(plus.e, &k);
+                const DiyFp w = ::multiply(v, c);
+                DiyFp wp = ::multiply(plus, c);
+                DiyFp wm = ::multiply(minus, c);
+                // 乘法有 1 ulp 误差，收窄区间保证结果一定落在原值的舍入范围内
+                ++wm.f;
+                --wp.f;
+                char digits[20];
+                const int len = ::generate_digits(w, wp, wp.f - wm.f, digits, &k);
+                p += ::layout(p, digits, len, k);
+            }
+        }
+        *p = '\0';
+        return p - outbuf;
+    }
+}
+
+std::size_t clia::util::str_func::convert(char *outbuf, const int size, const double value) noexcept {
+    return ::convert_float<double, std::uint64_t, 52, 1023>(outbuf, size, value);
+}
+
+std::size_t clia::util::str_func::convert(char *outbuf, const int size, const float value) noexcept {
+    return ::convert_float<float, std::uint32_t, 23, 127>(outbuf, size, value);
+}
+
+std::size_t clia::util::str_func::utf8_char_length(const char *str, const std::size_t len) noexcept {
+    const unsigned char *s = reinterpret_cast<const unsigned char*>(str);
+    if (0 == len) {
+        return 0;
+    }
+    if (s[0] < 0x80) {
+        return 1;
+    }
+    std::size_t n = 0;
+    if (s[0] < 0xc2) {
+        return 0;   // 后续字节，或 2 字节的过长编码
+    } else if (s[0] < 0xe0) {
+        n = 2;
+    } else if (s[0] < 0xf0) {
+        n = 3;
+    } else if (s[0] < 0xf5) {
+        n = 4;
+    } else {
+        return 0;
+    }
+    if (len < n || (s[1] & 0xc0) != 0x80) {
+        return 0;
+    }
+    // 第二个字节的范围排除 3、4 字节的过长编码、代理区(U+D800-U+DFFF)与 U+10FFFF 之后的码点
+    if ((0xe0 == s[0] && s[1] < 0xa0) || (0xed == s[0] && s[1] >= 0xa0)
+        || (0xf0 == s[0] && s[1] < 0x90) || (0xf4 == s[0] && s[1] >= 0x90)) {
+        return 0;
+    }
+    for (std::size_t i = 2; i < n; ++i) {
+        if ((s[i] & 0xc0) != 0x80) {
+            return 0;
+        }
+    }
+    return n;
+}
+
+std::size_t clia::util::str_func::utf8_truncate(const char *str, const std::size_t len) noexcept {
+    // 从末尾向前最多看 3 个字节，找到最后一个字符的首字节，它需要的字节数超出末尾则去掉
+    for (std::size_t back = 1; back <= 3 && back <= len; ++back) {
+        const unsigned char c = static_cast<unsigned char>(str[len - back]);
+        if ((c & 0xc0) == 0x80) {
+            continue;
+        }
+        const std::size_t need = c >= 0xf0 ? 4 : (c >= 0xe0 ? 3 : (c >= 0xc0 ? 2 : 1));
+        return need > back ? len - back : len;
+    }
+    return len;
+}
@@ -3,6 +3,32 @@
 #include <sys/time.h>
 
 #include "clia/util/timestamp.h"
+#include "clia/util/str_func.h"
+
+namespace {
+    // 写入 "YYYY-MM-DD hh:mm:ss"，日期之间的分隔符为 sep，sep 为 '\0' 时不加分隔符
+    void write_date_time(char *out, const int year, const ::tm &tm_time, const char sep) noexcept {
+        clia::util::str_func::write_2digits(out, static_cast<unsigned>(year / 100));
+        clia::util::str_func::write_2digits(out + 2, static_cast<unsigned>(year % 100));
+        char *p = out + 4;
+        if (sep != '\0') {
+            *p++ = sep;
+        }
+        clia::util::str_func::write_2digits(p, static_cast<unsigned>(tm_time.tm_mon + 1));
+        p += 2;
+        if (sep != '\0') {
+            *p++ = sep;
+        }
+        clia::util::str_func::write_2digits(p, static_cast<unsigned>(tm_time.tm_mday));
+        p += 2;
+        *p++ = ' ';
+        clia::util::str_func::write_2digits(p, static_cast<unsigned>(tm_time.tm_hour));
+        p[2] = ':';
+        clia::util::str_func::write_2digits(p + 3, static_cast<unsigned>(tm_time.tm_min));
+        p[5] = ':';
+        clia::util::str_func::write_2digits(p + 6, static_cast<unsigned>(tm_time.tm_sec));
+    }
+}
 
 clia::util::Timestamp::Timestamp() noexcept
     : micro_sec_since_epoch_(0)
@@ -46,16 +72,33 @@ int clia::util::Timestamp::to_format_str(char *outbuf, std::size_t sz, const boo
     const auto sec = sec_since_epoch();
     ::tm tm_time;
     ::localtime_r(&sec, &tm_time);
+    const int year = tm_time.tm_year + 1900;
     if (show_micro_sec) {
         const int microsec = static_cast<int>(micro_sec_since_epoch() % kMicroSecPerSec);
-        return std::snprintf(outbuf, sz, "%04d-%02d-%02d %02d:%02d:%02d.%06d", 
-                tm_time.tm_year + 1900, tm_time.tm_mon + 1, tm_time.tm_mday,
-                tm_time.tm_hour, tm_time.tm_min, tm_time.tm_sec,
-                microsec);
+        constexpr std::size_t kLen = sizeof("2006-01-02 15:04:05.000000") - 1;
+        if (sz <= kLen || year < 1000 || year > 9999 || microsec < 0) {
+            return std::snprintf(outbuf, sz, "%04d-%02d-%02d %02d:%02d:%02d.%06d", 
+                    year, tm_time.tm_mon + 1, tm_time.tm_mday,
+                    tm_time.tm_hour, tm_time.tm_min, tm_time.tm_sec,
+                    microsec);
+        }
+        ::write_date_time(outbuf, year, tm_time, '-');
+        outbuf[19] = '.';
+        clia::util::str_func::write_2digits(outbuf + 20, static_cast<unsigned>(microsec / 10000));
+        clia::util::str_func::write_2digits(outbuf + 22, static_cast<unsigned>(microsec / 100 % 100));
+        clia::util::str_func::write_2digits(outbuf + 24, static_cast<unsigned>(microsec % 100));
+        outbuf[kLen] = '\0';
+        return static_cast<int>(kLen);
     } else {
-        return std::snprintf(outbuf, sz, "%4d%02d%02d %02d:%02d:%02d",
-                tm_time.tm_year + 1900, tm_time.tm_mon + 1, tm_time.tm_mday,
-                tm_time.tm_hour, tm_time.tm_min, tm_time.tm_sec);
+        constexpr std::size_t kLen = sizeof("20060102 15:04:05") - 1;
+        if (sz <= kLen || year < 1000 || year > 9999) {
+            return std::snprintf(outbuf, sz, "%4d%02d%02d %02d:%02d:%02d",
+                    year, tm_time.tm_mon + 1, tm_time.tm_mday,
+                    tm_time.tm_hour, tm_time.tm_min, tm_time.tm_sec);
+        }
+        ::write_date_time(outbuf, year, tm_time, '\0');
+        outbuf[kLen] = '\0';
+        return static_cast<int>(kLen);
     }
 }
 
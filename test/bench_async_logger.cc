@@ -0,0 +1,110 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "clia/log/async_logger.h"
+#include "clia/log/trait.h"
+
+// AsyncLogger 前端的多线程开销：共用加锁缓冲区与每线程无锁环形缓冲区对比。
+// 直接调用 Logger::log 写入预先格式化好的日志行，不含 Event 的格式化开销；appender 只统计字节数
+namespace {
+    class CountingAppender final : public clia::log::trait::Appender {
+    public:
+        void append(const void *buf, const std::size_t size) noexcept override {
+            bytes += size;
+            lines += std::count(static_cast<const char*>(buf), static_cast<const char*>(buf) + size, '\n');
+        }
+        void flush() noexcept override {}
+    public:
+        std::uint64_t bytes = 0;
+        std::uint64_t lines = 0;
+    };
+
+    struct Result {
+        double ns_per_line = 0.0;   // 所有线程的墙上时间 / 总行数
+        double avg_ns = 0.0;        // 单次 log 调用
+        double p50_ns = 0.0;
+        double p99_ns = 0.0;
+        double max_ns = 0.0;
+        bool complete = false;      // appender 收到的行数与写入的一致
+    };
+
+    Result run(const std::size_t ring_bytes, const int threads, const int lines_per_thread) {
+        std::shared_ptr<CountingAppender> appender(new CountingAppender);
+        std::vector<std::vector<double>> samples(threads);
+        double wall = 0.0;
+        {
+            clia::log::AsyncLogger logger(clia::log::Level::kInfo, appender, 1, ring_bytes);
+            std::atomic<int> ready(0);
+            std::atomic<bool> go(false);
+            std::vector<std::thread> workers;
+            for (int t = 0; t < threads; ++t) {
+                workers.emplace_back([&, t]() {
+                    char line[128];
+                    const int len = std::snprintf(line, sizeof(line),
+                        "20260101 00:00:00.000000 1234 %d INFO [bench_async_logger.cc:run:42]:: connection established\n", t);
+                    std::vector<double> &sample = samples[t];
+                    sample.reserve(lines_per_thread);
+                    ++ready;
+                    while (!go.load(std::memory_order_acquire)) {
+                        std::this_thread::yield();
+                    }
+                    for (int i = 0; i < lines_per_thread; ++i) {
+                        const auto start = std::chrono::steady_clock::now();
+                        logger.log(clia::log::Level::kInfo, line, len);
+                        sample.push_back(std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count());
+                    }
+                });
+            }
+            while (ready.load() < threads) {
+                std::this_thread::yield();
+            }
+            const auto start = std::chrono::steady_clock::now();
+            go.store(true, std::memory_order_release);
+            for (auto &worker : workers) {
+                worker.join();
+            }
+            wall = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+        }
+        std::vector<double> all;
+        all.reserve(static_cast<std::size_t>(threads) * lines_per_thread);
+        for (const auto &sample : samples) {
+            all.insert(all.end(), sample.begin(), sample.end());
+        }
+        std::sort(all.begin(), all.end());
+        Result result;
+        double total = 0.0;
+        for (const double ns : all) {
+            total += ns;
+        }
+        result.ns_per_line = wall / all.size();
+        result.avg_ns = total / all.size();
+        result.p50_ns = all[all.size() / 2];
+        result.p99_ns = all[all.size() * 99 / 100];
+        result.max_ns = all.back();
+        result.complete = appender->lines == all.size();
+        return result;
+    }
+
+    void report(const char *name, const int threads, const Result &r) {
+        std::printf("  %-10s threads %2d  %8.1f ns/line  avg %8.1f ns  p50 %6.1f ns  p99 %8.1f ns  max %10.1f ns  %s\n",
+            name, threads, r.ns_per_line, r.avg_ns, r.p50_ns, r.p99_ns, r.max_ns, r.complete ? "" : "(lines lost)");
+    }
+}
+
+int main(int argc, char *argv[]) {
+    const int lines = argc > 1 ? std::atoi(argv[1]) : 200000;
+    const int max_threads = argc > 2 ? std::atoi(argv[2]) : 8;
+    std::printf("AsyncLogger front end, %d lines per thread, cpus = %u\n", lines, std::thread::hardware_concurrency());
+    for (int threads = 1; threads <= max_threads; threads *= 2) {
+        report("mutex", threads, run(0, threads, lines));
+        report("spsc-ring", threads, run(clia::log::AsyncLogger::kDefaultRingBytes, threads, lines));
+    }
+    return 0;
+}
@@ -0,0 +1,158 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <vector>
+
+#include "clia/net/buffer.h"
+#include "clia/util/byte_search.h"
+
+namespace {
+    volatile std::size_t kSink = 0;
+
+    double bench(const char *name, const std::size_t bytes, const int rounds, const std::function<std::size_t()> &fn) {
+        kSink += fn();
+        const auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < rounds; ++i) {
+            kSink += fn();
+        }
+        const auto end = std::chrono::steady_clock::now();
+        const double ns = std::chrono::duration<double, std::nano>(end - start).count();
+        const double gbps = static_cast<double>(bytes) * rounds / ns;
+        std::printf("  %-24s %8.2f GB/s %10.1f ns/op\n", name, gbps, ns / rounds);
+        return gbps;
+    }
+
+    void run(const std::size_t size, const int rounds, const bool bare_lf) {
+        // 只在末尾放置目标，保证整块都被扫描；bare_lf 时每 8 字节插入一个孤立的 '\n'
+        std::vector<unsigned char> data(size, 'a');
+        if (bare_lf) {
+            for (std::size_t i = 7; i + 2 < size; i += 8) {
+                data[i] = '\n';
+            }
+        }
+        data[size - 2] = '\r';
+        data[size - 1] = '\n';
+        clia::net::Buffer buf(size);
+        buf.append(data.data(), data.size());
+        const unsigned char *begin = buf.peek();
+        const unsigned char *end = begin + buf.readable_bytes();
+        static const char kCRLF[] = "\r\n";
+        static const char kSet[] = "\r\n\t ;";
+
+        std::printf("buffer size = %zu bytes%s\n", size, bare_lf ? ", bare '\\n' every 8 bytes" : "");
+        bench("memchr('\\r')", size, rounds, [&]() {
+            return static_cast<std::size_t>(static_cast<const unsigned char*>(std::memchr(begin, '\r', end - begin)) - begin);
+        });
+        bench("memchr('\\n')", size, rounds, [&]() {
+            return static_cast<std::size_t>(static_cast<const unsigned char*>(std::memchr(begin, '\n', end - begin)) - begin);
+        });
+        bench("std::search(\"\\r\\n\")", size, rounds, [&]() {
+            return static_cast<std::size_t>(std::search(begin, end, kCRLF, kCRLF + 2) - begin);
+        });
+        bench("memmem(\"\\r\\n\")", size, rounds, [&]() {
+            return static_cast<std::size_t>(static_cast<const unsigned char*>(::memmem(begin, end - begin, kCRLF, 2)) - begin);
+        });
+        if (!bare_lf) {
+            bench("std::find_first_of(5)", size, rounds, [&]() {
+                return static_cast<std::size_t>(std::find_first_of(begin, end, kSet, kSet + sizeof(kSet) - 1) - begin);
+            });
+        }
+
+        const clia::util::byte_search::Kernel kernels[] = {
+            clia::util::byte_search::Kernel::kScalar,
+            clia::util::byte_search::Kernel::kSse2,
+            clia::util::byte_search::Kernel::kAvx2,
+        };
+        char name[64];
+        for (const auto kernel : kernels) {
+            if (!clia::util::byte_search::use_kernel(kernel)) {
+                std::printf("  %s not supported\n", clia::util::byte_search::kernel_name(kernel));
+                continue;
+            }
+            const char *kname = clia::util::byte_search::kernel_name(kernel);
+            std::snprintf(name, sizeof(name), "%s find_crlf", kname);
+            bench(name, size, rounds, [&]() { return static_cast<std::size_t>(buf.find_crlf() - begin); });
+            if (bare_lf) {
+                continue;
+            }
+            std::snprintf(name, sizeof(name), "%s find_eol", kname);
+            bench(name, size, rounds, [&]() { return static_cast<std::size_t>(buf.find_eol() - begin); });
+            std::snprintf(name, sizeof(name), "%s find_any_of(5)", kname);
+            bench(name, size, rounds, [&]() { return static_cast<std::size_t>(buf.find_any_of(kSet, sizeof(kSet) - 1) - begin); });
+        }
+
+        // 模拟数据分多次到达：带 resume 的增量扫描 vs 每次从头扫描
+        clia::util::byte_search::use_kernel(clia::util::byte_search::Kernel::kAvx2) ||
+            clia::util::byte_search::use_kernel(clia::util::byte_search::Kernel::kSse2);
+        const std::size_t kPiece = 512;
+        bench("rescan per arrival", size, std::max(1, rounds / 16), [&]() {
+            clia::net::Buffer partial(size);
+            std::size_t hits = 0;
+            for (std::size_t off = 0; off < size; off += kPiece) {
+                partial.append(data.data() + off, std::min(kPiece, size - off));
+                hits += partial.find_crlf() != nullptr;
+            }
+            return hits;
+        });
+        bench("resume per arrival", size, std::max(1, rounds / 16), [&]() {
+            clia::net::Buffer partial(size);
+            std::size_t hits = 0;
+            std::size_t resume = 0;
+            for (std::size_t off = 0; off < size; off += kPiece) {
+                partial.append(data.data() + off, std::min(kPiece, size - off));
+                hits += partial.find_crlf(&resume) != nullptr;
+            }
+            return hits;
+        });
+    }
+
+    // 各实现与标量版本对拍，包括命中位置落在块边界附近的情况
+    bool verify() {
+        std::vector<unsigned char> data(300, 'x');
+        static const unsigned char kSet[] = {';', ' ', '\t'};
+        for (std::size_t pos = 0; pos + 1 < data.size(); ++pos) {
+            std::fill(data.begin(), data.end(), 'x');
+            data[pos] = '\r';
+            data[pos + 1] = '\n';
+            const unsigned char *b = data.data();
+            const unsigned char *e = b + data.size();
+            const clia::util::byte_search::Kernel kernels[] = {
+                clia::util::byte_search::Kernel::kScalar,
+                clia::util::byte_search::Kernel::kSse2,
+                clia::util::byte_search::Kernel::kAvx2,
+            };
+            for (const auto kernel : kernels) {
+                if (!clia::util::byte_search::use_kernel(kernel)) {
+                    continue;
+                }
+                for (std::size_t start = 0; start < 40; ++start) {
+                    const unsigned char *expect = (pos >= start) ? b + pos : nullptr;
+                    if (clia::util::byte_search::find_crlf(b + start, e) != expect
+                        || clia::util::byte_search::find_byte(b + start, e, '\r') != expect
+                        || clia::util::byte_search::find_any_of(b + start, e, kSet, sizeof(kSet)) != nullptr) {
+                        std::printf("mismatch: kernel = %s pos = %zu start = %zu\n",
+                            clia::util::byte_search::kernel_name(kernel), pos, start);
+                        return false;
+                    }
+                }
+            }
+        }
+        return true;
+    }
+}
+
+int main() {
+    std::printf("active kernel: %s\n", clia::util::byte_search::kernel_name(clia::util::byte_search::active_kernel()));
+    if (!verify()) {
+        return 1;
+    }
+    std::printf("verify ok\n");
+    run(64, 2000000, false);
+    run(1024, 500000, false);
+    run(64 * 1024, 10000, false);
+    run(1024, 500000, true);
+    run(64 * 1024, 10000, true);
+    return 0;
+}
@@ -0,0 +1,86 @@
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include <dirent.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include "clia/log/file_appender.h"
+
+// FileAppender 各写入模式的吞吐：按 AsyncLogger 的方式每次交给 appender 一整块 4MB 的日志，
+// 计时包含析构时的 fsync，单位 GB/s
+namespace {
+    void remove_files(const std::string &dir) {
+        ::DIR *d = ::opendir(dir.c_str());
+        if (nullptr == d) {
+            return;
+        }
+        ::dirent *entry;
+        while ((entry = ::readdir(d)) != nullptr) {
+            if (DT_REG == entry->d_type) {
+                ::unlink((dir + "/" + entry->d_name).c_str());
+            }
+        }
+        ::closedir(d);
+    }
+
+    double run(const std::string &dir, const clia::log::FileAppender::Options &options, const std::size_t total, const std::vector<char> &block) {
+        const auto start = std::chrono::steady_clock::now();
+        {
+            clia::log::FileAppender appender(dir.c_str(), "bench", total + block.size(), 1, 180, 1024, false, options);
+            for (std::size_t written = 0; written < total; written += block.size()) {
+                appender.append(block.data(), block.size());
+            }
+            appender.flush();
+        }
+        const double sec = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        remove_files(dir);
+        return static_cast<double>(total) / sec / (1024.0 * 1024.0 * 1024.0);
+    }
+}
+
+int main(int argc, char *argv[]) {
+    const std::size_t total_mb = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 2048;
+    const std::string dir = argc > 2 ? argv[2] : "./bench_file_appender.d";
+    const std::size_t total = total_mb * 1024 * 1024;
+
+    // 一块 4MB 的日志行
+    std::vector<char> block;
+    block.reserve(4 * 1024 * 1024);
+    const std::string line = "20260101 00:00:00.000000 1234 1235 INFO [bench_file_appender.cc:main:50]:: connection established\n";
+    while (block.size() + line.size() <= 4 * 1024 * 1024) {
+        block.insert(block.end(), line.begin(), line.end());
+    }
+    ::mkdir(dir.c_str(), 0755);
+
+    struct Mode {
+        const char *name;
+        bool direct_write;
+        bool o_direct;
+        bool preallocate;
+        std::size_t sync_every_bytes;
+    };
+    const Mode modes[] = {
+        {"stdio", false, false, false, 0},
+        {"stdio + fallocate", false, false, true, 0},
+        {"writev", true, false, false, 0},
+        {"writev + fallocate", true, false, true, 0},
+        {"writev + sync/64MB", true, false, true, 64 * 1024 * 1024},
+        {"O_DIRECT", true, true, false, 0},
+        {"O_DIRECT + fallocate", true, true, true, 0},
+    };
+    std::printf("FileAppender, %zu MB in %zu byte blocks\n", total_mb, block.size());
+    for (const Mode &mode : modes) {
+        clia::log::FileAppender::Options options;
+        options.direct_write = mode.direct_write;
+        options.o_direct = mode.o_direct;
+        options.preallocate_bytes = mode.preallocate ? total + block.size() : 0;
+        options.sync_every_bytes = mode.sync_every_bytes;
+        std::printf("  %-22s %6.2f GB/s\n", mode.name, run(dir, options, total, block));
+    }
+    ::rmdir(dir.c_str());
+    return 0;
+}
@@ -0,0 +1,130 @@
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <vector>
+
+#include "clia/util/str_func.h"
+#include "clia/util/timestamp.h"
+
+// 数值格式化：str_func 与 snprintf、std::to_chars 以及改动前逐位除法再反转的写法对比，单位为 ns/次
+// std::to_chars 需要 C++17，只有这个程序按 C++17 编译
+namespace {
+    // 改动前 str_func::convert 的逐位除法加反转，数字表两侧对称以便处理负数
+    std::size_t divide_reverse(char *outbuf, long long value) noexcept {
+        char *p = outbuf;
+        long long i = value;
+        do {
+            const int lsd = static_cast<int>(i % 10);
+            *p++ = "9876543210123456789"[9 + lsd];
+            i /= 10;
+        } while (i != 0);
+        if (value < 0) {
+            *p++ = '-';
+        }
+        std::reverse(outbuf, p);
+        return p - outbuf;
+    }
+
+    volatile std::size_t sink = 0;
+
+    template <typename T, typename Fn>
+    double measure(const std::vector<T> &values, const int rounds, Fn fn) {
+        char buf[64];
+        std::size_t total = 0;
+        const auto start = std::chrono::steady_clock::now();
+        for (int r = 0; r < rounds; ++r) {
+            for (const T &v : values) {
+                total += fn(buf, v);
+            }
+        }
+        const double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+        sink = total;
+        return ns / (static_cast<double>(values.size()) * rounds);
+    }
+
+    void report(const char *name, const double ns) {
+        std::printf("  %-26s %7.2f ns\n", name, ns);
+    }
+}
+
+int main(int argc, char *argv[]) {
+    const int rounds = argc > 1 ? std::atoi(argv[1]) : 20;
+    constexpr std::size_t kCount = 100000;
+    std::mt19937_64 rng(2024);
+    std::vector<long long> ints(kCount);
+    std::vector<double> doubles(kCount);
+    std::vector<std::uint64_t> hexes(kCount);
+    std::uniform_real_distribution<double> real(-1e6, 1e6);
+    for (std::size_t i = 0; i < kCount; ++i) {
+        // 位数均匀分布在 1 到 19 位之间
+        const int digits = static_cast<int>(rng() % 18) + 1;
+        long long v = static_cast<long long>(rng() % 1000000000000000000ull);
+        for (int d = 18; d > digits; --d) {
+            v /= 10;
+        }
+        ints[i] = (rng() & 1) ? v : -v;
+        doubles[i] = real(rng);
+        hexes[i] = rng() >> (rng() % 64);
+    }
+
+    std::printf("integer (%zu values x %d)\n", kCount, rounds);
+    report("str_func::convert", ::measure(ints, rounds, [](char *buf, long long v) {
+        return clia::util::str_func::convert(buf, 64, v);
+    }));
+    report("divide + reverse", ::measure(ints, rounds, [](char *buf, long long v) {
+        return ::divide_reverse(buf, v);
+    }));
+    report("snprintf %lld", ::measure(ints, rounds, [](char *buf, long long v) {
+        return static_cast<std::size_t>(std::snprintf(buf, 64, "%lld", v));
+    }));
+    report("std::to_chars", ::measure(ints, rounds, [](char *buf, long long v) {
+        return static_cast<std::size_t>(std::to_chars(buf, buf + 64, v).ptr - buf);
+    }));
+
+    std::printf("double, shortest round-trip\n");
+    report("str_func::convert", ::measure(doubles, rounds, [](char *buf, double v) {
+        return clia::util::str_func::convert(buf, 64, v);
+    }));
+    report("snprintf %.17g", ::measure(doubles, rounds, [](char *buf, double v) {
+        return static_cast<std::size_t>(std::snprintf(buf, 64, "%.17g", v));
+    }));
+    report("snprintf %.2f (previous)", ::measure(doubles, rounds, [](char *buf, double v) {
+        return static_cast<std::size_t>(std::snprintf(buf, 64, "%.2f", v));
+    }));
+    report("std::to_chars", ::measure(doubles, rounds, [](char *buf, double v) {
+        return static_cast<std::size_t>(std::to_chars(buf, buf + 64, v).ptr - buf);
+    }));
+
+    std::printf("hex / pointer\n");
+    report("str_func::convert_hex", ::measure(hexes, rounds, [](char *buf, std::uint64_t v) {
+        return clia::util::str_func::convert_hex(buf, 64, v);
+    }));
+    report("snprintf %llx", ::measure(hexes, rounds, [](char *buf, std::uint64_t v) {
+        return static_cast<std::size_t>(std::snprintf(buf, 64, "%llx", static_cast<unsigned long long>(v)));
+    }));
+    report("std::to_chars base 16", ::measure(hexes, rounds, [](char *buf, std::uint64_t v) {
+        return static_cast<std::size_t>(std::to_chars(buf, buf + 64, v, 16).ptr - buf);
+    }));
+    report("str_func::convert_pointer", ::measure(hexes, rounds, [](char *buf, std::uint64_t v) {
+        return clia::util::str_func::convert_pointer(buf, 64, reinterpret_cast<const void*>(v));
+    }));
+    report("snprintf %p", ::measure(hexes, rounds, [](char *buf, std::uint64_t v) {
+        return static_cast<std::size_t>(std::snprintf(buf, 64, "%p", reinterpret_cast<const void*>(v)));
+    }));
+
+    std::printf("Timestamp::to_format_str (includes localtime_r)\n");
+    std::vector<std::int64_t> stamps(kCount / 10);
+    const std::int64_t now = clia::util::Timestamp::now().micro_sec_since_epoch();
+    for (auto &stamp : stamps) {
+        stamp = now + static_cast<std::int64_t>(rng() % 1000000000ull);
+    }
+    report("to_format_str", ::measure(stamps, rounds, [](char *buf, std::int64_t v) {
+        return static_cast<std::size_t>(clia::util::Timestamp(v).to_format_str(buf, 64, true));
+    }));
+    return 0;
+}
@@ -0,0 +1,65 @@
+// 按 CLIA_LOG_LEVEL_DEBUG 编译：TRACE 在编译期被消除，DEBUG 在运行期被默认日志记录器(INFO)过滤
+#define CLIA_LOG_ACTIVE_LEVEL 1
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+
+#include "clia/log.h"
+#include "clia/log/sync_logger.h"
+
+// 关闭的日志语句的开销：编译期消除、运行期级别检查、按模块缓存的句柄，以及先复制 shared_ptr 再检查级别的写法
+namespace {
+    class NullAppender final : public clia::log::trait::Appender {
+    public:
+        void append(const void*, const std::size_t) noexcept override {}
+        void flush() noexcept override {}
+    };
+
+    // 防止循环被整体优化掉
+    inline void keep(const int value) noexcept {
+        asm volatile("" : : "r"(value) : "memory");
+    }
+
+    template <typename Body>
+    double measure(const int iterations, Body body) {
+        const auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < iterations; ++i) {
+            body(i);
+            ::keep(i);
+        }
+        return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / iterations;
+    }
+}
+
+int main(int argc, char *argv[]) {
+    const int iterations = argc > 1 ? std::atoi(argv[1]) : 100000000;
+    std::shared_ptr<clia::log::trait::Logger> logger(new clia::log::SyncLogger(clia::log::Level::kInfo, std::make_shared<NullAppender>()));
+    clia::log::LoggerManger::instance()->set_default(logger);
+
+    std::printf("disabled log statement, %d iterations\n", iterations);
+    const double empty = ::measure(iterations, [](const int) {});
+    const double compiled_out = ::measure(iterations, [](const int i) {
+        CLIA_LOG_TRACE << "fd = " << i << " events happened";
+    });
+    const double runtime = ::measure(iterations, [](const int i) {
+        CLIA_LOG_DEBUG << "fd = " << i << " events happened";
+    });
+    const double runtime_fmt = ::measure(iterations, [](const int i) {
+        CLIA_FMT_LOG_DEBUG("fd = %d events happened", i);
+    });
+    const double module = ::measure(iterations, [](const int i) {
+        CLIA_MODULE_LOG_DEBUG("reactor") << "fd = " << i << " events happened";
+    });
+    const double shared_ptr_first = ::measure(iterations, [](const int i) {
+        CLIA_LOG(clia::log::LoggerManger::instance()->default_logger(), clia::log::Level::kDebug) << "fd = " << i << " events happened";
+    });
+    std::printf("  %-28s %6.2f ns\n", "empty loop", empty);
+    std::printf("  %-28s %6.2f ns\n", "compile-time (TRACE)", compiled_out);
+    std::printf("  %-28s %6.2f ns\n", "runtime level (DEBUG)", runtime);
+    std::printf("  %-28s %6.2f ns\n", "runtime level (FMT DEBUG)", runtime_fmt);
+    std::printf("  %-28s %6.2f ns\n", "module handle (DEBUG)", module);
+    std::printf("  %-28s %6.2f ns\n", "shared_ptr copy + level", shared_ptr_first);
+    return 0;
+}
@@ -0,0 +1,155 @@
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+#include <poll.h>
+#include <unistd.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+
+#include "clia/log.h"
+#include "clia/log/stdout_appender.h"
+#include "clia/log/sync_logger.h"
+#include "clia/net/inet_address.h"
+#include "clia/net/udp_server.h"
+#include "clia/net/udp_socket.h"
+#include "clia/reactor/event_loop.h"
+
+// 回环上的 UDP 收包速率：逐包 sendto/recvfrom 对比 sendmmsg/recvmmsg，以及再叠加 GSO/GRO
+namespace {
+    constexpr std::uint16_t kPort = 19090;
+    constexpr int kSocketBuffer = 8 * 1024 * 1024;
+
+    struct Result {
+        std::uint64_t sent = 0;
+        std::uint64_t received = 0;
+        std::uint64_t rx_syscalls = 0;
+        std::uint64_t tx_syscalls = 0;
+        double seconds = 0.0;
+    };
+
+    void set_buffers(const int fd) {
+        ::setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &kSocketBuffer, sizeof(kSocketBuffer));
+        ::setsockopt(fd, SOL_SOCKET, SO_SNDBUF, &kSocketBuffer, sizeof(kSocketBuffer));
+    }
+
+    void wait_writable(const int fd) {
+        ::pollfd pfd;
+        pfd.fd = fd;
+        pfd.events = POLLOUT;
+        pfd.revents = 0;
+        ::poll(&pfd, 1, 1);
+    }
+
+    void report(const char *name, const std::size_t payload, const Result &r) {
+        const double pps = r.received / r.seconds;
+        std::printf("  %-22s %5zuB  rx %10.0f pps  %8.1f MB/s  tx/syscall %6.1f  rx/syscall %6.1f  loss %5.1f%%\n",
+            name, payload, pps, pps * payload / 1e6,
+            r.tx_syscalls ? static_cast<double>(r.sent) / r.tx_syscalls : 0.0,
+            r.rx_syscalls ? static_cast<double>(r.received) / r.rx_syscalls : 0.0,
+            r.sent ? 100.0 * (r.sent - std::min(r.sent, r.received)) / r.sent : 0.0);
+    }
+
+    Result run_plain(const std::size_t payload, const double seconds) {
+        Result result;
+        const clia::net::InetAddress addr("127.0.0.1", kPort);
+        const int rfd = ::socket(AF_INET, SOCK_DGRAM, 0);
+        set_buffers(rfd);
+        ::bind(rfd, addr.get_sockaddr(), addr.socklen());
+        ::timeval tv = {0, 100 * 1000};
+        ::setsockopt(rfd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+
+        std::atomic_bool stop(false);
+        std::thread sender([&]() {
+            const int sfd = ::socket(AF_INET, SOCK_DGRAM, 0);
+            set_buffers(sfd);
+            std::vector<unsigned char> data(payload, 'x');
+            while (!stop.load(std::memory_order_relaxed)) {
+                if (::sendto(sfd, data.data(), data.size(), 0, addr.get_sockaddr(), addr.socklen()) > 0) {
+                    ++result.sent;
+                    ++result.tx_syscalls;
+                }
+            }
+            ::close(sfd);
+        });
+
+        std::vector<unsigned char> buf(65536);
+        const auto start = std::chrono::steady_clock::now();
+        const auto deadline = start + std::chrono::duration<double>(seconds);
+        while (std::chrono::steady_clock::now() < deadline) {
+            if (::recvfrom(rfd, buf.data(), buf.size(), 0, nullptr, nullptr) >= 0) {
+                ++result.received;
+                ++result.rx_syscalls;
+            }
+        }
+        result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        stop = true;
+        sender.join();
+        ::close(rfd);
+        return result;
+    }
+
+    Result run_batched(const std::size_t payload, const double seconds, const bool offload) {
+        Result result;
+        const clia::net::InetAddress addr("127.0.0.1", kPort);
+        clia::reactor::EventLoop loop;
+        clia::net::UdpServer server(&loop, addr);
+        set_buffers(server.fd());
+        if (offload && !server.enable_gro()) {
+            std::printf("  (UDP_GRO unsupported)\n");
+        }
+        server.set_message_callback([&result](clia::net::UdpServer*, const clia::net::UdpMessage*, std::size_t count, clia::util::Timestamp) {
+            result.received += count;
+        });
+        server.start();
+
+        std::atomic_bool stop(false);
+        std::thread sender([&]() {
+            clia::net::UdpSocket socket(AF_INET);
+            set_buffers(socket.fd());
+            if (offload && !socket.set_gso(true)) {
+                std::printf("  (UDP_SEGMENT unsupported)\n");
+            }
+            std::vector<unsigned char> data(payload, 'x');
+            std::vector<clia::net::UdpMessage> msgs(clia::net::UdpSocket::kDefaultBatch,
+                clia::net::UdpMessage{data.data(), data.size(), addr});
+            while (!stop.load(std::memory_order_relaxed)) {
+                const std::size_t n = socket.send_batch(msgs.data(), msgs.size());
+                if (n < msgs.size()) {
+                    wait_writable(socket.fd());
+                }
+            }
+            result.sent = socket.stats().tx_packets;
+            result.tx_syscalls = socket.stats().tx_syscalls;
+        });
+
+        const auto start = std::chrono::steady_clock::now();
+        loop.run_after(seconds, [&loop]() { loop.quit(); });
+        loop.loop();
+        result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        stop = true;
+        sender.join();
+        result.rx_syscalls = server.stats().rx_syscalls;
+        return result;
+    }
+}
+
+int main(int argc, char *argv[]) {
+    std::shared_ptr<clia::log::trait::Appender> appender(new clia::log::StdoutAppender);
+    std::shared_ptr<clia::log::trait::Logger> logger(new clia::log::SyncLogger(clia::log::Level::kWarn, appender));
+    clia::log::LoggerManger::instance()->set_default(logger);
+
+    const double seconds = argc > 1 ? std::atof(argv[1]) : 2.0;
+    const std::size_t payloads[] = {64, 512, 1400};
+    std::printf("udp loopback, %.1fs per case, cpus = %u\n", seconds, std::thread::hardware_concurrency());
+    for (const std::size_t payload : payloads) {
+        report("sendto/recvfrom", payload, run_plain(payload, seconds));
+        report("sendmmsg/recvmmsg", payload, run_batched(payload, seconds, false));
+        report("mmsg + gso/gro", payload, run_batched(payload, seconds, true));
+    }
+    return 0;
+}
@@ -0,0 +1,149 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+#include <unistd.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+
+#include "clia/log.h"
+#include "clia/log/stdout_appender.h"
+#include "clia/log/sync_logger.h"
+#include "clia/net/buffer.h"
+#include "clia/net/inet_address.h"
+#include "clia/net/tcp_connection.h"
+#include "clia/net/tcp_server.h"
+#include "clia/reactor/event_loop.h"
+
+// 同一台机器上 loopback TCP 与 Unix 域 socket 的对比：小包往返延迟和大块回显吞吐
+namespace {
+    constexpr std::size_t kPingSize = 64;
+    constexpr std::size_t kChunkSize = 64 * 1024;
+
+    int connect_to(const clia::net::InetAddress &addr) {
+        const int fd = ::socket(addr.family(), SOCK_STREAM | SOCK_CLOEXEC, 0);
+        if (fd < 0 || ::connect(fd, addr.get_sockaddr(), addr.socklen()) < 0) {
+            std::perror("connect");
+            std::exit(1);
+        }
+        if (!addr.is_unix()) {
+            const int on = 1;
+            ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+        }
+        return fd;
+    }
+
+    bool write_all(const int fd, const unsigned char *data, std::size_t len) {
+        while (len > 0) {
+            const auto n = ::write(fd, data, len);
+            if (n <= 0) {
+                return false;
+            }
+            data += n;
+            len -= static_cast<std::size_t>(n);
+        }
+        return true;
+    }
+
+    bool read_all(const int fd, unsigned char *data, std::size_t len) {
+        while (len > 0) {
+            const auto n = ::read(fd, data, len);
+            if (n <= 0) {
+                return false;
+            }
+            data += n;
+            len -= static_cast<std::size_t>(n);
+        }
+        return true;
+    }
+
+    void bench_latency(const char *name, const clia::net::InetAddress &addr, const double seconds) {
+        const int fd = connect_to(addr);
+        std::vector<unsigned char> buf(kPingSize, 'p');
+        std::vector<double> samples;
+        samples.reserve(1 << 20);
+        const auto deadline = std::chrono::steady_clock::now() + std::chrono::duration<double>(seconds);
+        while (std::chrono::steady_clock::now() < deadline) {
+            const auto start = std::chrono::steady_clock::now();
+            if (!write_all(fd, buf.data(), buf.size()) || !read_all(fd, buf.data(), buf.size())) {
+                break;
+            }
+            samples.push_back(std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count());
+        }
+        ::close(fd);
+        std::sort(samples.begin(), samples.end());
+        double total = 0.0;
+        for (const double s : samples) {
+            total += s;
+        }
+        std::printf("  %-6s rtt %zuB    avg %7.2f us  p50 %7.2f us  p99 %7.2f us  (%zu round trips)\n", name, kPingSize,
+            total / samples.size(), samples[samples.size() / 2], samples[samples.size() * 99 / 100], samples.size());
+    }
+
+    void bench_throughput(const char *name, const clia::net::InetAddress &addr, const std::size_t total) {
+        const int fd = connect_to(addr);
+        const auto start = std::chrono::steady_clock::now();
+        std::thread writer([fd, total]() {
+            std::vector<unsigned char> chunk(kChunkSize, 'x');
+            for (std::size_t sent = 0; sent < total; sent += kChunkSize) {
+                if (!write_all(fd, chunk.data(), std::min(kChunkSize, total - sent))) {
+                    break;
+                }
+            }
+        });
+        std::vector<unsigned char> buf(kChunkSize);
+        std::size_t received = 0;
+        while (received < total) {
+            const auto n = ::read(fd, buf.data(), buf.size());
+            if (n <= 0) {
+                break;
+            }
+            received += static_cast<std::size_t>(n);
+        }
+        writer.join();
+        const double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        ::close(fd);
+        std::printf("  %-6s echo %4zuMB  %8.1f MB/s\n", name, total >> 20, received / secs / (1 << 20));
+    }
+
+    void on_message(const clia::net::TcpConnectionPtr &conn, clia::net::Buffer *buf, clia::util::Timestamp) {
+        conn->send(buf);
+    }
+}
+
+int main(int argc, char *argv[]) {
+    std::shared_ptr<clia::log::trait::Appender> appender(new clia::log::StdoutAppender);
+    std::shared_ptr<clia::log::trait::Logger> logger(new clia::log::SyncLogger(clia::log::Level::kWarn, appender));
+    clia::log::LoggerManger::instance()->set_default(logger);
+
+    const double seconds = argc > 1 ? std::atof(argv[1]) : 2.0;
+    const std::size_t total = (argc > 2 ? std::atoi(argv[2]) : 256) * std::size_t(1 << 20);
+
+    const clia::net::InetAddress tcp_addr("127.0.0.1", 19092);
+    const clia::net::InetAddress uds_addr = clia::net::InetAddress::unix_domain("clia-bench-uds", true);
+
+    clia::reactor::EventLoop loop;
+    clia::net::TcpServer tcp_server(&loop, tcp_addr);
+    clia::net::TcpServer uds_server(&loop, uds_addr);
+    tcp_server.set_message_callback(&on_message);
+    uds_server.set_message_callback(&on_message);
+    tcp_server.start();
+    uds_server.start();
+
+    std::thread client([&]() {
+        std::printf("tcp %s vs uds %s, cpus = %u\n", tcp_addr.get_addr().c_str(), uds_addr.get_addr().c_str(),
+            std::thread::hardware_concurrency());
+        bench_latency("tcp", tcp_addr, seconds);
+        bench_latency("uds", uds_addr, seconds);
+        bench_throughput("tcp", tcp_addr, total);
+        bench_throughput("uds", uds_addr, total);
+        loop.quit();
+    });
+    loop.loop();
+    client.join();
+    return 0;
+}
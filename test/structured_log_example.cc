@@ -0,0 +1,94 @@
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "clia/log.h"
+#include "clia/log/sync_logger.h"
+#include "clia/util/str_func.h"
+
+// 把日志行收集起来逐条检查
+class CaptureAppender : public clia::log::trait::Appender {
+public:
+    void append(const void *buf, const std::size_t size) noexcept override {
+        lines.emplace_back(static_cast<const char*>(buf), size);
+    }
+    void flush() noexcept override {}
+public:
+    std::vector<std::string> lines;
+};
+
+static int failures = 0;
+
+static void check(const bool ok, const std::string &what, const std::string &line) {
+    std::cout << (ok ? "[ OK ] " : "[FAIL] ") << what << "\n       " << line;
+    if (!ok) {
+        ++failures;
+    }
+}
+
+static bool contains(const std::string &line, const std::string &part) {
+    return line.find(part) != std::string::npos;
+}
+
+// 整行都是合法 UTF-8
+static bool valid_utf8(const std::string &line) {
+    for (std::size_t i = 0; i < line.size();) {
+        const std::size_t n = clia::util::str_func::utf8_char_length(line.data() + i, line.size() - i);
+        if (0 == n) {
+            return false;
+        }
+        i += n;
+    }
+    return true;
+}
+
+int main() {
+    std::shared_ptr<CaptureAppender> appender(new CaptureAppender);
+    std::shared_ptr<clia::log::trait::Logger> logger(new clia::log::SyncLogger(clia::log::Level::kTrace, appender));
+    const std::string special = "say \"hi\"\\\n\t\x01\x7f";
+    const std::string utf8 = "\xe4\xbd\xa0\xe5\xa5\xbd";       // 你好
+    const std::string invalid = "a\xff" "b\xe4\xbd";           // 非法字节与不完整的字符
+    std::string long_utf8;
+    for (int i = 0; i < 400; ++i) {
+        long_utf8 += "\xe4\xb8\xad";                            // 中
+    }
+
+    // logfmt
+    clia::log::StructuredEvent::set_format(clia::log::StructuredEvent::Format::kLogfmt);
+    CLIA_SLOG(logger, clia::log::Level::kInfo, "logfmt_plain").kv("fd", 12).kv("ok", true).kv("name", "abc");
+    check(contains(appender->lines.back(), "event=logfmt_plain fd=12 ok=true name=abc\n"), "logfmt plain values", appender->lines.back());
+    CLIA_SLOG(logger, clia::log::Level::kInfo, "logfmt_escape").kv("msg", special).kv("empty", "");
+    check(contains(appender->lines.back(), "msg=\"say \\\"hi\\\"\\\\\\n\\t\\u0001\\u007f\" empty=\"\""), "logfmt escaping", appender->lines.back());
+    CLIA_SLOG(logger, clia::log::Level::kInfo, "logfmt_utf8").kv("text", utf8).kv("bad", invalid);
+    check(contains(appender->lines.back(), "text=" + utf8 + " bad=a\xef\xbf\xbd" "b\xef\xbf\xbd\xef\xbf\xbd") && valid_utf8(appender->lines.back()),
+        "logfmt utf-8 and invalid bytes", appender->lines.back());
+    CLIA_SLOG(logger, clia::log::Level::kInfo, "logfmt_truncate").kv("text", long_utf8).kv("after", 1);
+    check(contains(appender->lines.back(), " _truncated=true\n") && !contains(appender->lines.back(), "after=")
+        && valid_utf8(appender->lines.back()), "logfmt truncation on a character boundary", appender->lines.back());
+
+    // json
+    clia::log::StructuredEvent::set_format(clia::log::StructuredEvent::Format::kJson);
+    CLIA_SLOG(logger, clia::log::Level::kWarn, "json_plain").kv("fd", 12).kv("ratio", 0.5).kv("ptr", static_cast<const char*>(nullptr));
+    check(contains(appender->lines.back(), "\"level\":\"WARN\"") && contains(appender->lines.back(), "\"event\":\"json_plain\",\"fd\":12,\"ratio\":0.5,\"ptr\":null}\n"),
+        "json plain values", appender->lines.back());
+    CLIA_SLOG(logger, clia::log::Level::kInfo, "json_escape").kv("msg", special);
+    check(contains(appender->lines.back(), "\"msg\":\"say \\\"hi\\\"\\\\\\n\\t\\u0001\\u007f\"}"), "json escaping", appender->lines.back());
+    CLIA_SLOG(logger, clia::log::Level::kInfo, "json_utf8").kv("text", utf8).kv("bad", invalid);
+    check(contains(appender->lines.back(), "\"text\":\"" + utf8 + "\",\"bad\":\"a\xef\xbf\xbd" "b\xef\xbf\xbd\xef\xbf\xbd\"") && valid_utf8(appender->lines.back()),
+        "json utf-8 and invalid bytes", appender->lines.back());
+    CLIA_SLOG(logger, clia::log::Level::kInfo, "json_truncate").kv("text", long_utf8).kv("after", 1);
+    check(contains(appender->lines.back(), "\",\"_truncated\":true}\n") && !contains(appender->lines.back(), "after")
+        && valid_utf8(appender->lines.back()), "json truncation on a character boundary", appender->lines.back());
+
+    // 二进制日志：默认 log_binary 在调用线程中用 binary::format 格式化
+    CLIA_BIN_LOG(logger, clia::log::Level::kInfo, "bin %d %s %.4s %c %5.2f", 42, utf8, utf8, 'x', 3.14159);
+    check(contains(appender->lines.back(), "]:: bin 42 " + utf8 + " \xe4\xbd\xa0 x  3.14\n") && valid_utf8(appender->lines.back()),
+        "binary format with precision on a character boundary", appender->lines.back());
+    CLIA_BIN_LOG(logger, clia::log::Level::kInfo, "bin long %s", long_utf8);
+    check(valid_utf8(appender->lines.back()) && contains(appender->lines.back(), "bin long \xe4\xb8\xad"),
+        "binary format truncation on a character boundary", appender->lines.back());
+
+    std::cout << (0 == failures ? "all passed" : "some checks failed") << std::endl;
+    return 0 == failures ? 0 : 1;
+}
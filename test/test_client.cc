@@ -0,0 +1,77 @@
+#include <cstdlib>
+#include <iostream>
+
+#include "clia/log.h"
+#include "clia/net/buffer.h"
+#include "clia/net/tcp_client.h"
+#include "clia/net/tcp_connection.h"
+#include "clia/log/async_logger.h"
+#include "clia/log/file_appender.h"
+#include "clia/reactor/event_loop.h"
+#include "clia/log/sync_logger.h"
+#include "clia/log/stdout_appender.h"
+
+// 连接 test_server，每秒发送一次消息；服务端重启时自动重连
+class EchoClient {
+public:
+    EchoClient(clia::reactor::EventLoop *loop, const clia::net::InetAddress &addr)
+        : loop_(loop)
+        , client_(loop, addr)
+        , seq_(0)
+    {
+        client_.set_connection_callback(std::bind(&EchoClient::handle_connect, this, std::placeholders::_1));
+        client_.set_message_callback(std::bind(&EchoClient::handle_message, this, std::placeholders::_1, std::placeholders::_2, std::placeholders::_3));
+        client_.enable_retry();
+    }
+    ~EchoClient() {
+        ;
+    }
+    void start() {
+        client_.connect();
+        loop_->run_every(1.0, std::bind(&EchoClient::on_tick, this));
+    }
+private:
+    void handle_connect(const clia::net::TcpConnectionPtr &conn) {
+        if (conn->connected()) {
+            CLIA_LOG_DEBUG << "Connection Up : " << conn->peer_addr().get_addr();
+        } else {
+            CLIA_LOG_DEBUG << "Connection Down : " << conn->peer_addr().get_addr();
+        }
+    }
+    void handle_message(const clia::net::TcpConnectionPtr &conn, clia::net::Buffer *buf, clia::util::Timestamp) {
+        std::string msg = buf->retrieve_all_as_string();
+        CLIA_LOG_DEBUG << "Recv from [" << conn->peer_addr().get_addr() << "]:: " << msg;
+    }
+    void on_tick() {
+        const clia::net::TcpConnectionPtr conn = client_.connection();
+        if (conn && conn->connected()) {
+            const std::string msg = "hello " + std::to_string(++seq_);
+            conn->send(msg.c_str(), msg.size());
+        }
+    }
+private:
+    clia::reactor::EventLoop *loop_;
+    clia::net::TcpClient client_;
+    int seq_;
+};
+
+int main(int argc, char *argv[]) {
+#ifdef NDEBUG    
+    std::shared_ptr<clia::log::trait::Appender> appender(new clia::log::FileAppender("./", "test_client"));
+    std::shared_ptr<clia::log::trait::Logger> logger(new clia::log::AsyncLogger(clia::log::Level::kWarn, appender));
+#else
+    std::shared_ptr<clia::log::trait::Appender> appender(new clia::log::StdoutAppender);
+    std::shared_ptr<clia::log::trait::Logger> logger(new clia::log::SyncLogger(clia::log::Level::kDebug, appender));
+#endif
+    clia::log::LoggerManger::instance()->set_default(logger);
+
+    const char *ip = argc > 1 ? argv[1] : "127.0.0.1";
+    const int port = argc > 2 ? std::atoi(argv[2]) : 1818;
+
+    clia::reactor::EventLoop loop;
+    clia::net::InetAddress addr(ip, static_cast<std::uint16_t>(port));
+    EchoClient client(&loop, addr);
+    client.start();
+    loop.loop();
+    return 0;
+}
@@ -0,0 +1,143 @@
+#include <cerrno>
+#include <csignal>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <string>
+
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "clia/log.h"
+#include "clia/net/buffer.h"
+#include "clia/net/handoff.h"
+#include "clia/net/tcp_connection.h"
+#include "clia/net/tcp_server.h"
+#include "clia/reactor/event_loop.h"
+#include "clia/log/sync_logger.h"
+#include "clia/log/stdout_appender.h"
+
+// 热重启交接：依次 fork 三代服务进程，每一代从上一代接手监听 socket 与空闲连接，
+// 再在同一个 Unix 域地址上等待下一代。客户端的一条连接始终保持打开，每次交接后都应由新一代应答
+class EchoServer {
+public:
+    EchoServer(clia::reactor::EventLoop *loop, const clia::net::InetAddress &addr, clia::net::HandoffState *state, const int generation)
+        : loop_(loop)
+        , server_(state->valid() ? new clia::net::TcpServer(loop, addr, state) : new clia::net::TcpServer(loop, addr))
+        , prefix_("gen" + std::to_string(generation) + ":")
+    {
+        server_->set_message_callback(std::bind(&EchoServer::handle_message, this, std::placeholders::_1, std::placeholders::_2, std::placeholders::_3));
+        server_->set_thread_num(1);
+    }
+    void start(const clia::net::InetAddress &handoff_addr) {
+        server_->start();
+        server_->enable_handoff(handoff_addr, true, 2.0, std::bind(&EchoServer::handle_drained, this, std::placeholders::_1));
+    }
+private:
+    void handle_message(const clia::net::TcpConnectionPtr &conn, clia::net::Buffer *buf, clia::util::Timestamp) {
+        const std::string msg = prefix_ + buf->retrieve_all_as_string();
+        conn->send(msg.c_str(), msg.size());
+    }
+    void handle_drained(const clia::net::TcpServer::DrainStats &stats) {
+        CLIA_LOG_INFO << prefix_ << " drained, handed off " << stats.handed_off << ", closed " << stats.closed << ", forced " << stats.forced;
+        loop_->quit();
+    }
+private:
+    clia::reactor::EventLoop *loop_;
+    std::unique_ptr<clia::net::TcpServer> server_;
+    const std::string prefix_;
+};
+
+static int run_server(const int generation, const clia::net::InetAddress &addr, const clia::net::InetAddress &handoff_addr) {
+    clia::net::HandoffState state;
+    if (generation > 0 && !clia::net::handoff::receive(handoff_addr, &state)) {
+        std::cerr << "gen" << generation << ": handoff receive failed" << std::endl;
+        return 2;
+    }
+    clia::reactor::EventLoop loop;
+    EchoServer server(&loop, addr, &state, generation);
+    server.start(handoff_addr);
+    loop.loop();
+    return 0;
+}
+
+static ::pid_t spawn_server(const int generation, const clia::net::InetAddress &addr, const clia::net::InetAddress &handoff_addr) {
+    const ::pid_t pid = ::fork();
+    if (0 == pid) {
+        ::_exit(run_server(generation, addr, handoff_addr));
+    }
+    return pid;
+}
+
+// 发送 ping 并读取一次应答
+static std::string request(const int fd) {
+    if (::write(fd, "ping", 4) != 4) {
+        return "write fail: " + std::string(std::strerror(errno));
+    }
+    char buf[64];
+    const ::ssize_t n = ::read(fd, buf, sizeof(buf));
+    return n > 0 ? std::string(buf, n) : "read fail: " + std::string(n < 0 ? std::strerror(errno) : "eof");
+}
+
+static bool wait_exit(const ::pid_t pid, const int generation) {
+    int status = 0;
+    ::waitpid(pid, &status, 0);
+    const bool ok = WIFEXITED(status) && 0 == WEXITSTATUS(status);
+    std::cout << (ok ? "[ OK ] " : "[FAIL] ") << "gen" << generation << " exited, status = " << status << std::endl;
+    return ok;
+}
+
+int main(int argc, char *argv[]) {
+    std::shared_ptr<clia::log::trait::Appender> appender(new clia::log::StdoutAppender);
+    std::shared_ptr<clia::log::trait::Logger> logger(new clia::log::SyncLogger(clia::log::Level::kInfo, appender));
+    clia::log::LoggerManger::instance()->set_default(logger);
+
+    const int port = argc > 1 ? std::atoi(argv[1]) : 1819;
+    const std::string path = argc > 2 ? argv[2] : "/tmp/clia_test_handoff.sock";
+    const clia::net::InetAddress addr("127.0.0.1", static_cast<std::uint16_t>(port));
+    const clia::net::InetAddress handoff_addr = clia::net::InetAddress::unix_domain(path);
+    constexpr int kGenerations = 3;
+
+    int failures = 0;
+    ::pid_t pid = spawn_server(0, addr, handoff_addr);
+    int fd = -1;
+    for (int i = 0; i < 100 && fd < 0; ++i) {
+        fd = ::socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        if (::connect(fd, addr.get_sockaddr(), addr.socklen()) < 0) {
+            ::close(fd);
+            fd = -1;
+            ::usleep(20 * 1000);
+        }
+    }
+    if (fd < 0) {
+        std::cout << "[FAIL] connect to gen0" << std::endl;
+        ::kill(pid, SIGTERM);
+        return 1;
+    }
+    ::timeval tv = {5, 0};
+    ::setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+
+    for (int generation = 0; generation < kGenerations; ++generation) {
+        if (generation > 0) {
+            // 新一代接手后旧进程 drain 完退出，连接只能由新一代应答
+            const ::pid_t next = spawn_server(generation, addr, handoff_addr);
+            failures += wait_exit(pid, generation - 1) ? 0 : 1;
+            pid = next;
+        }
+        const std::string expect = "gen" + std::to_string(generation) + ":ping";
+        const std::string reply = request(fd);
+        std::cout << (reply == expect ? "[ OK ] " : "[FAIL] ") << "reply [" << reply << "], expect [" << expect << "]" << std::endl;
+        failures += reply == expect ? 0 : 1;
+    }
+    ::close(fd);
+    ::kill(pid, SIGTERM);
+    ::waitpid(pid, nullptr, 0);
+    ::unlink(path.c_str());
+
+    std::cout << (0 == failures ? "all passed" : "some checks failed") << std::endl;
+    return 0 == failures ? 0 : 1;
+}
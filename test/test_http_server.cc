@@ -0,0 +1,55 @@
+#include <cstdlib>
+#include <string>
+
+#include "clia/log.h"
+#include "clia/http/http_server.h"
+#include "clia/log/async_logger.h"
+#include "clia/log/file_appender.h"
+#include "clia/log/sync_logger.h"
+#include "clia/log/stdout_appender.h"
+#include "clia/reactor/event_loop.h"
+
+void handle_request(const clia::http::HttpRequest &req, clia::http::HttpResponse *resp) {
+    if (req.path() == "/health") {
+        resp->set_status(200);
+        resp->set_content_type("text/plain");
+        resp->set_body("ok\n");
+    } else if (req.path() == "/echo") {
+        resp->set_status(200);
+        resp->set_content_type("application/octet-stream");
+        resp->set_body(req.body());
+    } else if (req.path() == "/stream") {
+        resp->set_status(200);
+        resp->set_content_type("text/plain");
+        resp->begin_chunked();
+        for (int i = 0; i < 3; ++i) {
+            const std::string line = "line " + std::to_string(i) + "\n";
+            resp->write_chunk(line.data(), line.size());
+        }
+        resp->end_chunked();
+    } else {
+        resp->set_status(404);
+        resp->set_content_type("application/json");
+        resp->set_body("{\"error\":\"not found\"}");
+    }
+}
+
+int main(int argc, char *argv[]) {
+#ifdef NDEBUG
+    std::shared_ptr<clia::log::trait::Appender> appender(new clia::log::FileAppender("./", "test_http_server"));
+    std::shared_ptr<clia::log::trait::Logger> logger(new clia::log::AsyncLogger(clia::log::Level::kWarn, appender));
+#else
+    std::shared_ptr<clia::log::trait::Appender> appender(new clia::log::StdoutAppender);
+    std::shared_ptr<clia::log::trait::Logger> logger(new clia::log::SyncLogger(clia::log::Level::kInfo, appender));
+#endif
+    clia::log::LoggerManger::instance()->set_default(logger);
+
+    clia::reactor::EventLoop loop;
+    clia::net::InetAddress addr("0.0.0.0", argc > 1 ? std::atoi(argv[1]) : 8080);
+    clia::http::HttpServer server(&loop, addr);
+    server.set_http_callback(handle_request);
+    server.set_thread_num(argc > 2 ? std::atoi(argv[2]) : 4);
+    server.start();
+    loop.loop();
+    return 0;
+}